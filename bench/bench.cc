@@ -0,0 +1,315 @@
+// Stage-by-stage benchmark of the native pipeline: parse, rasterize, pixel
+// conversion and the PNG, "png-fast" and QOI encoders, run over every Lottie file in a corpus directory
+// at several output sizes. Results are written as JSON for bench/compare.js.
+//
+//   build/Release/bench [--corpus DIR] [--sizes 100,512,2048] [--min-time MS] [--out FILE]
+
+#include "animation.h"
+#include "buffer_pool.h"
+#include "pixel.h"
+#include "png_writer.h"
+#include "qoi_writer.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <dirent.h>
+#include <fstream>
+#include <new>
+#include <sstream>
+#include <string>
+#include <sys/resource.h>
+#include <vector>
+
+#define lp_COLOR_BYTES 4
+#define li_BENCH_SCHEMA_VERSION 1
+#define li_DEFAULT_MIN_TIME_MS 500
+#define li_MIN_ITERATIONS 3
+#define ls_DEFAULT_CORPUS "bench/corpus"
+
+// Every operator new in the process is counted, rlottie's included. Memory from
+// plain malloc (libpng, zlib, the scratch pool) is not; the scratch pool and
+// encoder outputs are counted through get_buffer_pool_stats instead.
+static std::atomic<uint64_t> new_calls(0);
+
+void* operator new(size_t size) {
+    new_calls.fetch_add(1, std::memory_order_relaxed);
+    if (void* ptr = malloc(size ? size : 1)) return ptr;
+    throw std::bad_alloc();
+}
+
+void* operator new[](size_t size) {
+    return operator new(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+    new_calls.fetch_add(1, std::memory_order_relaxed);
+    return malloc(size ? size : 1);
+}
+
+void* operator new[](size_t size, const std::nothrow_t& tag) noexcept {
+    return operator new(size, tag);
+}
+
+void operator delete(void* ptr) noexcept { free(ptr); }
+void operator delete[](void* ptr) noexcept { free(ptr); }
+void operator delete(void* ptr, size_t) noexcept { free(ptr); }
+void operator delete[](void* ptr, size_t) noexcept { free(ptr); }
+
+struct BenchConfig {
+    std::string corpus;
+    std::vector<int> sizes;
+    double min_time_ms;
+    std::string out;
+};
+
+struct BenchRecord {
+    std::string file;
+    std::string stage;
+    int width;
+    int height;
+    uint64_t iterations;
+    double ns_per_op;
+    double mb_per_sec;
+    double allocations_per_op;
+    uint64_t output_bytes;
+    long peak_rss_kb;
+};
+
+static uint64_t count_allocations() {
+    BufferPoolStats stats = get_buffer_pool_stats();
+    return new_calls.load(std::memory_order_relaxed) + stats.scratch_allocations + stats.output_allocations;
+}
+
+static long peak_rss_kb() {
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+#ifdef __APPLE__
+    return usage.ru_maxrss / 1024;
+#else
+    return usage.ru_maxrss;
+#endif
+}
+
+// Runs op(i) until both li_MIN_ITERATIONS and the minimum time are reached.
+// Only the op itself is timed; `bytes` is the data one op processes.
+template <typename Op>
+static BenchRecord measure(const BenchConfig& config, const std::string& stage, size_t bytes, Op op) {
+    using clock = std::chrono::steady_clock;
+    std::chrono::nanoseconds elapsed(0);
+    uint64_t iterations = 0;
+    uint64_t allocations = count_allocations();
+
+    while (iterations < li_MIN_ITERATIONS || elapsed.count() < config.min_time_ms * 1e6) {
+        clock::time_point start = clock::now();
+        op(iterations);
+        elapsed += clock::now() - start;
+        iterations++;
+    }
+    allocations = count_allocations() - allocations;
+
+    BenchRecord record = {};
+    record.stage = stage;
+    record.iterations = iterations;
+    record.ns_per_op = (double)elapsed.count() / iterations;
+    record.mb_per_sec = bytes * 1e3 / record.ns_per_op;
+    record.allocations_per_op = (double)allocations / iterations;
+    record.peak_rss_kb = peak_rss_kb();
+    return record;
+}
+
+// Encodes a rendered frame with `encode`; output_bytes is the size of the result.
+template <typename Encode>
+static BenchRecord measure_encode(const BenchConfig& config, const std::string& stage, size_t frame_bytes, Encode encode) {
+    byte* buffer = nullptr;
+    size_t size = 0;
+    std::string error_msg;
+    BenchRecord record = measure(config, stage, frame_bytes, [&](uint64_t) {
+        if (!encode(&buffer, &size, error_msg)) {
+            fprintf(stderr, "bench: %s\n", error_msg.c_str());
+            exit(1);
+        }
+        free(buffer);
+    });
+    record.output_bytes = size;
+    return record;
+}
+
+static bool read_file(const std::string& path, std::string& contents) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) return false;
+    std::ostringstream stream;
+    stream << file.rdbuf();
+    contents = stream.str();
+    return true;
+}
+
+static std::vector<std::string> list_corpus(const std::string& dir) {
+    std::vector<std::string> files;
+    DIR* handle = opendir(dir.c_str());
+    if (!handle) return files;
+    while (struct dirent* entry = readdir(handle)) {
+        std::string name = entry->d_name;
+        if (name.size() > 5 && name.compare(name.size() - 5, 5, ".json") == 0) {
+            files.push_back(name);
+        }
+    }
+    closedir(handle);
+    std::sort(files.begin(), files.end());
+    return files;
+}
+
+static void bench_file(const BenchConfig& config, const std::string& name, std::vector<BenchRecord>& records) {
+    std::string json;
+    if (!read_file(config.corpus + "/" + name, json)) {
+        fprintf(stderr, "bench: cannot read %s\n", name.c_str());
+        return;
+    }
+
+    BenchRecord parse = measure(config, "parse", json.size(), [&](uint64_t) {
+        std::unique_ptr<rlottie::Animation> animation = load_animation_from_data(json);
+        if (!animation) {
+            fprintf(stderr, "bench: failed to parse %s\n", name.c_str());
+            exit(1);
+        }
+    });
+    parse.file = name;
+    records.push_back(parse);
+
+    std::unique_ptr<rlottie::Animation> animation = load_animation_from_data(json);
+    size_t total_frames = std::max<size_t>(get_total_frames(animation), 1);
+
+    for (int size : config.sizes) {
+        size_t pixel_count = (size_t)size * size;
+        size_t frame_bytes = pixel_count * lp_COLOR_BYTES;
+        std::vector<uint32_t> pixels(pixel_count);
+        rlottie::Surface surface(pixels.data(), size, size, size * lp_COLOR_BYTES);
+
+        std::vector<BenchRecord> stages;
+        stages.push_back(measure(config, "rasterize", frame_bytes, [&](uint64_t i) {
+            render_frame_sync(animation, i % total_frames, surface);
+        }));
+
+        // Convert and encode a frame from the middle of the animation, which is
+        // more representative than whichever frame the last render left behind.
+        render_frame_sync(animation, total_frames / 2, surface);
+        std::vector<uint8_t> rgba(frame_bytes);
+        stages.push_back(measure(config, "convert", frame_bytes, [&](uint64_t) {
+            premultiplied_argb_to_rgba(pixels.data(), rgba.data(), pixel_count);
+        }));
+
+        // The defaults of exportFrame.
+        PngOptions png = {1, PNG_FILTER_MODE_ADAPTIVE, PNG_STRATEGY_DEFAULT, 1, false};
+        stages.push_back(measure_encode(config, "encode", frame_bytes, [&](byte** out, size_t* out_size, std::string& error) {
+            return encode_png(pixels.data(), size, size, png, out, out_size, error);
+        }));
+        PngOptions fast = png;
+        fast.fast = true;
+        stages.push_back(measure_encode(config, "encode-png-fast", frame_bytes, [&](byte** out, size_t* out_size, std::string& error) {
+            return encode_png(pixels.data(), size, size, fast, out, out_size, error);
+        }));
+        stages.push_back(measure_encode(config, "encode-qoi", frame_bytes, [&](byte** out, size_t* out_size, std::string& error) {
+            return encode_qoi(pixels.data(), size, size, out, out_size, error);
+        }));
+
+        for (BenchRecord& record : stages) {
+            record.file = name;
+            record.width = size;
+            record.height = size;
+            records.push_back(record);
+        }
+        fprintf(stderr, "bench: %s %dx%d done\n", name.c_str(), size, size);
+    }
+}
+
+static std::string json_string(const std::string& value) {
+    std::string out = "\"";
+    for (char c : value) {
+        if (c == '"' || c == '\\') out += '\\';
+        out += c;
+    }
+    return out + "\"";
+}
+
+static std::string format_results(const std::vector<BenchRecord>& records) {
+    std::ostringstream out;
+    out << "{\n  \"version\": " << li_BENCH_SCHEMA_VERSION << ",\n";
+    out << "  \"pixelKernel\": " << json_string(pixel_kernel_name()) << ",\n";
+    out << "  \"results\": [";
+    for (size_t i = 0; i < records.size(); i++) {
+        const BenchRecord& r = records[i];
+        char line[512];
+        snprintf(line, sizeof(line),
+                 "%s\n    {\"file\": %s, \"stage\": \"%s\", \"width\": %d, \"height\": %d, \"iterations\": %llu, "
+                 "\"nsPerOp\": %.0f, \"mbPerSec\": %.2f, \"allocationsPerOp\": %.2f, \"outputBytes\": %llu, \"peakRssKb\": %ld}",
+                 i ? "," : "", json_string(r.file).c_str(), r.stage.c_str(), r.width, r.height,
+                 (unsigned long long)r.iterations, r.ns_per_op, r.mb_per_sec, r.allocations_per_op,
+                 (unsigned long long)r.output_bytes, r.peak_rss_kb);
+        out << line;
+    }
+    out << "\n  ]\n}\n";
+    return out.str();
+}
+
+static bool parse_sizes(const char* list, std::vector<int>& sizes) {
+    sizes.clear();
+    for (const char* p = list; *p;) {
+        char* end;
+        long size = strtol(p, &end, 10);
+        if (end == p || size < 1 || size > 16384) return false;
+        sizes.push_back((int)size);
+        p = *end == ',' ? end + 1 : end;
+        if (*end && *end != ',') return false;
+    }
+    return !sizes.empty();
+}
+
+int main(int argc, char** argv) {
+    BenchConfig config = {ls_DEFAULT_CORPUS, {100, 512, 2048}, li_DEFAULT_MIN_TIME_MS, ""};
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+        if (arg == "--corpus" && value) {
+            config.corpus = value;
+        } else if (arg == "--sizes" && value) {
+            if (!parse_sizes(value, config.sizes)) {
+                fprintf(stderr, "bench: invalid --sizes %s\n", value);
+                return 2;
+            }
+        } else if (arg == "--min-time" && value) {
+            config.min_time_ms = atof(value);
+        } else if (arg == "--out" && value) {
+            config.out = value;
+        } else {
+            fprintf(stderr, "usage: bench [--corpus DIR] [--sizes 100,512,2048] [--min-time MS] [--out FILE]\n");
+            return 2;
+        }
+        i++;
+    }
+
+    std::vector<std::string> files = list_corpus(config.corpus);
+    if (files.empty()) {
+        fprintf(stderr, "bench: no .json files in %s\n", config.corpus.c_str());
+        return 1;
+    }
+
+    std::vector<BenchRecord> records;
+    for (const std::string& name : files) {
+        bench_file(config, name, records);
+    }
+
+    std::string results = format_results(records);
+    if (config.out.empty()) {
+        fputs(results.c_str(), stdout);
+    } else {
+        std::ofstream file(config.out);
+        file << results;
+        if (!file) {
+            fprintf(stderr, "bench: cannot write %s\n", config.out.c_str());
+            return 1;
+        }
+    }
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,62 @@
+// Compares two result files from bench.cc or napi.js and exits non-zero when a
+// stage got slower, or allocates more, than the threshold allows.
+//
+//   node bench/compare.js BASELINE.json CURRENT.json [--threshold PERCENT]
+
+"use strict";
+
+const fs = require("fs");
+
+function load(file) {
+  const results = new Map();
+  for (const record of JSON.parse(fs.readFileSync(file, "utf8")).results) {
+    results.set(`${record.file} ${record.stage} ${record.width}x${record.height}`, record);
+  }
+  return results;
+}
+
+function main() {
+  const args = process.argv.slice(2);
+  let threshold = 10;
+  const thresholdIndex = args.indexOf("--threshold");
+  if (thresholdIndex !== -1) {
+    threshold = Number(args[thresholdIndex + 1]);
+    args.splice(thresholdIndex, 2);
+  }
+  if (args.length !== 2 || !(threshold >= 0)) {
+    console.error("usage: node bench/compare.js BASELINE.json CURRENT.json [--threshold PERCENT]");
+    process.exit(2);
+  }
+
+  const baseline = load(args[0]);
+  const current = load(args[1]);
+  let regressions = 0;
+
+  for (const [key, record] of current) {
+    const base = baseline.get(key);
+    if (!base) {
+      console.log(`  new        ${key}`);
+      continue;
+    }
+    const change = ((record.nsPerOp - base.nsPerOp) / base.nsPerOp) * 100;
+    const allocations =
+      base.allocationsPerOp !== undefined && record.allocationsPerOp > base.allocationsPerOp + 0.5;
+    const regressed = change > threshold || allocations;
+    if (regressed) regressions++;
+
+    const sign = change >= 0 ? "+" : "";
+    let line = `${regressed ? "! " : "  "}${(sign + change.toFixed(1) + "%").padStart(9)}  ${key}  ${base.nsPerOp} -> ${record.nsPerOp} ns/op`;
+    if (allocations) line += `, allocations ${base.allocationsPerOp} -> ${record.allocationsPerOp}`;
+    console.log(line);
+  }
+  for (const key of baseline.keys()) {
+    if (!current.has(key)) console.log(`  missing    ${key}`);
+  }
+
+  if (regressions > 0) {
+    console.log(`${regressions} regression(s) beyond ${threshold}%`);
+    process.exit(1);
+  }
+}
+
+main();
\ No newline at end of file
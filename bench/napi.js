@@ -0,0 +1,103 @@
+// Measures the N-API side of a render: the same frames as bench.cc, rendered
+// through the built addon from JavaScript. With --native pointing at bench.cc
+// output, each record also gets `marshalNsPerOp`, the time spent outside the
+// native rasterize and convert stages.
+//
+//   node bench/napi.js [--corpus DIR] [--sizes 100,512,2048] [--min-time MS] [--native FILE] [--out FILE]
+
+"use strict";
+
+const fs = require("fs");
+const path = require("path");
+const { loadAnimationSync } = require("..");
+
+const MIN_ITERATIONS = 3;
+
+function parseArgs(argv) {
+  const config = {
+    corpus: path.join(__dirname, "corpus"),
+    sizes: [100, 512, 2048],
+    minTimeMs: 500,
+    native: null,
+    out: null,
+  };
+  for (let i = 0; i < argv.length; i += 2) {
+    const value = argv[i + 1];
+    switch (argv[i]) {
+      case "--corpus": config.corpus = value; break;
+      case "--sizes": config.sizes = value.split(",").map(Number); break;
+      case "--min-time": config.minTimeMs = Number(value); break;
+      case "--native": config.native = value; break;
+      case "--out": config.out = value; break;
+      default:
+        console.error("usage: node bench/napi.js [--corpus DIR] [--sizes 100,512,2048] [--min-time MS] [--native FILE] [--out FILE]");
+        process.exit(2);
+    }
+  }
+  return config;
+}
+
+async function measure(config, stage, bytes, op) {
+  const minTimeNs = BigInt(Math.round(config.minTimeMs * 1e6));
+  let elapsed = 0n;
+  let iterations = 0;
+  while (iterations < MIN_ITERATIONS || elapsed < minTimeNs) {
+    const start = process.hrtime.bigint();
+    await op(iterations);
+    elapsed += process.hrtime.bigint() - start;
+    iterations++;
+  }
+  const nsPerOp = Number(elapsed) / iterations;
+  return {
+    stage,
+    iterations,
+    nsPerOp: Math.round(nsPerOp),
+    mbPerSec: Number(((bytes * 1e3) / nsPerOp).toFixed(2)),
+    peakRssKb: process.resourceUsage().maxRSS,
+  };
+}
+
+async function main() {
+  const config = parseArgs(process.argv.slice(2));
+  const native = config.native ? JSON.parse(fs.readFileSync(config.native, "utf8")).results : [];
+  const nativeNs = (file, size, stage) =>
+    native.find((r) => r.file === file && r.width === size && r.stage === stage)?.nsPerOp;
+
+  const results = [];
+  const files = fs.readdirSync(config.corpus).filter((name) => name.endsWith(".json")).sort();
+  for (const file of files) {
+    const animation = loadAnimationSync(fs.readFileSync(path.join(config.corpus, file)));
+    const totalFrames = Math.max(animation.totalFrames, 1);
+
+    for (const size of config.sizes) {
+      const options = (frame) => ({ frame: frame % totalFrames, width: size, height: size, format: "rgba" });
+      const bytes = size * size * 4;
+      const stages = [
+        await measure(config, "napi-sync", bytes, (i) => animation.renderFrameSync(options(i))),
+        await measure(config, "napi-async", bytes, (i) => animation.renderFrame(options(i))),
+      ];
+
+      const rasterize = nativeNs(file, size, "rasterize");
+      const convert = nativeNs(file, size, "convert");
+      for (const record of stages) {
+        if (rasterize !== undefined && convert !== undefined) {
+          record.marshalNsPerOp = Math.max(0, record.nsPerOp - rasterize - convert);
+        }
+        results.push({ file, width: size, height: size, ...record });
+      }
+      console.error(`napi: ${file} ${size}x${size} done`);
+    }
+  }
+
+  const output = JSON.stringify({ version: 1, results }, null, 2) + "\n";
+  if (config.out) {
+    fs.writeFileSync(config.out, output);
+  } else {
+    process.stdout.write(output);
+  }
+}
+
+main().catch((error) => {
+  console.error(error);
+  process.exit(1);
+});
\ No newline at end of file
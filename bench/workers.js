@@ -0,0 +1,140 @@
+// Stress test for running the addon on many worker_threads at once. The main
+// thread parses one animation and shares it by ID; every worker opens that ID,
+// renders frames through it (async and sync) and through exportFrame on the
+// shared worker pool, and checks each frame against the main thread's render.
+// One extra worker is terminated mid-run to exercise environment teardown.
+//
+//   node bench/workers.js [--workers 16] [--frames 60] [--size 256] [--file FILE]
+
+"use strict";
+
+const crypto = require("crypto");
+const fs = require("fs");
+const path = require("path");
+const { Worker, isMainThread, parentPort, workerData } = require("worker_threads");
+const lottie = require("..");
+
+function parseArgs(argv) {
+  const config = {
+    workers: 16,
+    frames: 60,
+    size: 256,
+    file: path.join(__dirname, "corpus", "shapes.json"),
+  };
+  for (let i = 0; i < argv.length; i += 2) {
+    const value = argv[i + 1];
+    switch (argv[i]) {
+      case "--workers": config.workers = Number(value); break;
+      case "--frames": config.frames = Number(value); break;
+      case "--size": config.size = Number(value); break;
+      case "--file": config.file = value; break;
+      default:
+        console.error("usage: node bench/workers.js [--workers 16] [--frames 60] [--size 256] [--file FILE]");
+        process.exit(2);
+    }
+  }
+  return config;
+}
+
+function digest(buffer) {
+  return crypto.createHash("sha1").update(buffer).digest("hex");
+}
+
+async function runWorker() {
+  const { id, frames, size, file, reference, index } = workerData;
+  const animation = lottie.openSharedAnimation(id);
+  const input = fs.readFileSync(file);
+  // Take and drop a reference of our own while the main thread still holds one.
+  lottie.releaseSharedAnimation(animation.share());
+
+  let renders = 0;
+  let mismatches = 0;
+  parentPort.postMessage("started");
+  const start = process.hrtime.bigint();
+  for (let i = 0; i < frames; i++) {
+    const frame = (i + index) % frames;
+    const options = { frame, width: size, height: size, format: "rgba" };
+    const pending = [animation.renderFrame(options)];
+    if (i % 8 === 0) pending.push(lottie.exportFrame(input, options));
+    const results = await Promise.all(pending);
+    if (i % 4 === 0) results.push(animation.renderFrameSync(options));
+    for (const result of results) {
+      renders++;
+      if (digest(result) !== reference[frame]) mismatches++;
+    }
+  }
+  const elapsedMs = Number(process.hrtime.bigint() - start) / 1e6;
+  parentPort.postMessage({ renders, mismatches, elapsedMs });
+}
+
+function spawn(config, id, reference, index) {
+  return new Worker(__filename, {
+    workerData: { id, frames: config.frames, size: config.size, file: config.file, reference, index },
+  });
+}
+
+async function main() {
+  const config = parseArgs(process.argv.slice(2));
+  const animation = lottie.loadAnimationSync(fs.readFileSync(config.file));
+  config.frames = Math.min(config.frames, animation.totalFrames);
+
+  const reference = [];
+  for (let frame = 0; frame < config.frames; frame++) {
+    reference.push(digest(animation.renderFrameSync({ frame, width: config.size, height: config.size, format: "rgba" })));
+  }
+
+  const id = animation.share();
+  const start = process.hrtime.bigint();
+
+  // Torn down while its jobs are queued or running on the shared pool.
+  const doomed = spawn(config, id, reference, 0);
+  doomed.on("error", () => {});
+  doomed.once("message", () => setTimeout(() => doomed.terminate(), 5));
+
+  const results = await Promise.all(
+    Array.from({ length: config.workers }, (_, index) =>
+      new Promise((resolve, reject) => {
+        const worker = spawn(config, id, reference, index);
+        worker.on("message", (message) => {
+          if (message !== "started") resolve(message);
+        });
+        worker.once("error", reject);
+        worker.once("exit", (code) => {
+          if (code !== 0) reject(new Error(`Worker ${index} exited with code ${code}`));
+        });
+      })
+    )
+  );
+  const elapsedMs = Number(process.hrtime.bigint() - start) / 1e6;
+
+  const renders = results.reduce((sum, result) => sum + result.renders, 0);
+  const mismatches = results.reduce((sum, result) => sum + result.mismatches, 0);
+  const released = lottie.releaseSharedAnimation(id);
+  let reopened = true;
+  try {
+    lottie.openSharedAnimation(id);
+  } catch {
+    reopened = false;
+  }
+
+  const summary = {
+    workers: config.workers,
+    frames: config.frames,
+    size: config.size,
+    renders,
+    mismatches,
+    elapsedMs: Math.round(elapsedMs),
+    rendersPerSec: Math.round((renders * 1e3) / elapsedMs),
+    released,
+    reopened,
+  };
+  const { calls, failures, inFlight } = lottie.getStats();
+  Object.assign(summary, { calls, failures, inFlight });
+  process.stdout.write(JSON.stringify(summary, null, 2) + "\n");
+  if (mismatches || !released || reopened) process.exit(1);
+}
+
+(isMainThread ? main : runWorker)().catch((error) => {
+  console.error(error);
+  process.exit(1);
+});
\ No newline at end of file
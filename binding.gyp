@@ -1,21 +1,47 @@
 {
+  "variables": {
+    "build_bench%": "false",
+    "build_tests%": "false"
+  },
   "targets": [
     {
       "target_name": "lottie-frame",
       "sources": [
+        "src/addon.cc",
         "src/animation.cc",
+        "src/animation_cache.cc",
+        "src/animation_input.cc",
+        "src/animation_registry.cc",
+        "src/apng.cc",
+        "src/batch.cc",
+        "src/buffer_pool.cc",
         "src/converter.cc",
         "src/exports.cc",
+        "src/frame_cache.cc",
+        "src/hash.cc",
+        "src/json_scan.cc",
+        "src/lottie_animation.cc",
+        "src/mapped_file.cc",
+        "src/metrics.cc",
         "src/module.cc",
+        "src/parallel.cc",
+        "src/pixel.cc",
         "src/png_writer.cc",
-        "src/utils.cc"
+        "src/probe.cc",
+        "src/qoi_writer.cc",
+        "src/spritesheet.cc",
+        "src/stream.cc",
+        "src/utils.cc",
+        "src/viewport.cc",
+        "src/worker_pool.cc"
       ],
       "include_dirs": [
         "<!@(node -p \"require('node-addon-api').include\")"
       ],
       "libraries": [
         "-lrlottie",
-        "-lpng"
+        "-lpng",
+        "-lz"
       ],
       "cflags!": ["-fno-exceptions"],
       "cflags_cc!": ["-fno-exceptions"],
@@ -37,5 +63,80 @@
         }]
       ]
     }
+  ],
+  "conditions": [
+    ["build_bench=='true'", {
+      "targets": [
+        {
+          "target_name": "bench",
+          "type": "executable",
+          "sources": [
+            "bench/bench.cc",
+            "src/animation.cc",
+            "src/buffer_pool.cc",
+            "src/hash.cc",
+            "src/parallel.cc",
+            "src/pixel.cc",
+            "src/png_writer.cc",
+            "src/qoi_writer.cc"
+          ],
+          "include_dirs": [
+            "src",
+            "<!@(node -p \"require('node-addon-api').include\")"
+          ],
+          "libraries": [
+            "-lrlottie",
+            "-lpng",
+            "-lz"
+          ],
+          "cflags!": ["-fno-exceptions"],
+          "cflags_cc!": ["-fno-exceptions"],
+          "defines": [
+            "NAPI_DISABLE_CPP_EXCEPTIONS"
+          ],
+          "conditions": [
+            ["OS=='mac'", {
+              "xcode_settings": {
+                "GCC_ENABLE_CPP_EXCEPTIONS": "YES",
+                "CLANG_CXX_LANGUAGE_STANDARD": "c++17",
+                "CLANG_CXX_LIBRARY": "libc++"
+              }
+            }],
+            ["OS!='mac'", {
+              "cflags_cc": ["-std=c++17"]
+            }]
+          ]
+        }
+      ]
+    }],
+    ["build_tests=='true'", {
+      "targets": [
+        {
+          "target_name": "pixel_test",
+          "type": "executable",
+          "sources": [
+            "test/pixel_test.cc",
+            "src/pixel.cc"
+          ],
+          "include_dirs": [
+            "src"
+          ],
+          "cflags!": ["-fno-exceptions"],
+          "cflags_cc!": ["-fno-exceptions"],
+          "conditions": [
+            ["OS=='mac'", {
+              "xcode_settings": {
+                "GCC_ENABLE_CPP_EXCEPTIONS": "YES",
+                "CLANG_CXX_LANGUAGE_STANDARD": "c++17",
+                "CLANG_CXX_LIBRARY": "libc++"
+              }
+            }],
+            ["OS!='mac'", {
+              "cflags_cc": ["-std=c++17"]
+            }]
+          ]
+        }
+      ]
+    }]
   ]
 }
\ No newline at end of file
@@ -0,0 +1,26 @@
+#include "addon.h"
+
+static void finalize_addon_data(napi_env env, void* data, void* hint) {
+    AddonData* addon = static_cast<AddonData*>(data);
+    if (addon->lottie_animation_constructor) {
+        napi_delete_reference(env, addon->lottie_animation_constructor);
+    }
+    // pool_env belongs to its threadsafe function, which the worker pool's
+    // cleanup hook releases.
+    delete addon;
+}
+
+napi_status create_addon_data(napi_env env) {
+    AddonData* addon = new AddonData{nullptr, nullptr};
+    napi_status status = napi_set_instance_data(env, addon, finalize_addon_data, nullptr);
+    if (status != napi_ok) {
+        delete addon;
+    }
+    return status;
+}
+
+AddonData* get_addon_data(napi_env env) {
+    void* data = nullptr;
+    if (napi_get_instance_data(env, &data) != napi_ok) return nullptr;
+    return static_cast<AddonData*>(data);
+}
\ No newline at end of file
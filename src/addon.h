@@ -0,0 +1,22 @@
+#ifndef ADDON_H
+#define ADDON_H
+
+#include <napi.h>
+
+struct PoolEnv;
+
+// Per-environment state: one for the main thread and one for each worker
+// thread that loads the addon. Everything native behind it (the worker pool,
+// the caches, shared animations) is process-wide, so these only hold what is
+// tied to a single JS heap.
+struct AddonData {
+    napi_ref lottie_animation_constructor;
+    // Completion channel of the worker pool, created on first use.
+    PoolEnv* pool_env;
+};
+
+// Called once from module init; the data is freed when the environment exits.
+napi_status create_addon_data(napi_env env);
+AddonData* get_addon_data(napi_env env);
+
+#endif // ADDON_H
\ No newline at end of file
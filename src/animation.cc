@@ -1,13 +1,59 @@
 #include "animation.h"
+#include "hash.h"
+#include <cmath>
+#include <cstdio>
 
-std::unique_ptr<rlottie::Animation> load_animation_from_data(const std::string& data) {
-    return rlottie::Animation::loadFromData(data, "");
+std::unique_ptr<rlottie::Animation> load_animation_from_data(std::string data, const std::string& resource_path) {
+    // rlottie's model cache is keyed by the second argument; with an empty key every
+    // load would alias the first cached model, so bypass it.
+    return rlottie::Animation::loadFromData(std::move(data), "", resource_path, false);
+}
+
+std::unique_ptr<rlottie::Animation> load_shared_animation_from_data(std::string data, const std::string& key, const std::string& resource_path) {
+    return rlottie::Animation::loadFromData(std::move(data), key, resource_path, true);
+}
+
+std::string animation_model_key(const uint8_t* data, size_t size, const std::string& resource_path, const std::string& animation_id) {
+    uint64_t seed = hash_bytes(animation_id.data(), animation_id.size(), hash_bytes(resource_path.data(), resource_path.size()));
+    uint64_t hash = hash_bytes(data, size, seed);
+    char key[40];
+    snprintf(key, sizeof(key), "lottie-frame:%016llx", (unsigned long long)hash);
+    return key;
+}
+
+std::shared_ptr<AnimationHandle> create_animation_handle(std::unique_ptr<rlottie::Animation> animation,
+                                                         std::shared_ptr<const AnimationSource> source) {
+    std::shared_ptr<AnimationHandle> handle = std::make_shared<AnimationHandle>();
+    handle->source = std::move(source);
+    handle->total_frames = animation->totalFrame();
+    handle->frame_rate = animation->frameRate();
+    handle->duration = animation->duration();
+    animation->size(handle->width, handle->height);
+    handle->animation = std::move(animation);
+    return handle;
+}
+
+std::shared_ptr<AnimationHandle> open_animation_handle(const std::shared_ptr<const AnimationSource>& source) {
+    std::unique_ptr<rlottie::Animation> animation = load_shared_animation_from_data(source->json, source->model_key, source->resource_path);
+    if (!animation) return nullptr;
+    return create_animation_handle(std::move(animation), source);
 }
 
 size_t get_total_frames(std::unique_ptr<rlottie::Animation>& animation) {
     return animation->totalFrame();
 }
 
+size_t frame_at_progress(size_t total_frames, double progress) {
+    if (total_frames < 2 || !(progress > 0)) return 0;
+    if (progress >= 1) return total_frames - 1;
+    return (size_t)std::lround(progress * (total_frames - 1));
+}
+
+size_t frame_at_time(size_t total_frames, double frame_rate, double time_ms) {
+    if (total_frames < 2 || !(frame_rate > 0)) return 0;
+    return frame_at_progress(total_frames, time_ms / 1000 * frame_rate / (total_frames - 1));
+}
+
 void render_frame_sync(std::unique_ptr<rlottie::Animation>& animation, size_t frame, rlottie::Surface& surface) {
     animation->renderSync(frame, surface, true);
 }
\ No newline at end of file
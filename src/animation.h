@@ -2,11 +2,52 @@
 #define ANIMATION_H
 
 #include <memory>
+#include <mutex>
 #include <string>
 #include <rlottie.h>
 
-std::unique_ptr<rlottie::Animation> load_animation_from_data(const std::string& data);
+// What more renderers over one parsed model are built from: the decoded JSON,
+// which rlottie needs even when it has the model cached, and the model's key
+// in rlottie's model cache.
+struct AnimationSource {
+    std::string json;
+    std::string model_key;
+    std::string resource_path;
+};
+
+// A parsed animation shared between JS handles and in-flight renders.
+// rlottie::Animation is not re-entrant, so every render on it must hold `mutex`.
+// The metadata fields are immutable after creation and may be read without it.
+struct AnimationHandle {
+    std::unique_ptr<rlottie::Animation> animation;
+    std::mutex mutex;
+    size_t total_frames;
+    double frame_rate;
+    double duration;
+    size_t width;
+    size_t height;
+    std::shared_ptr<const AnimationSource> source;
+};
+
+std::unique_ptr<rlottie::Animation> load_animation_from_data(std::string data, const std::string& resource_path = "");
+// Loads through rlottie's model cache under `key`: the first load parses, later loads
+// with the same key share the parsed model and only build a new renderer.
+std::unique_ptr<rlottie::Animation> load_shared_animation_from_data(std::string data, const std::string& key, const std::string& resource_path);
+std::string animation_model_key(const uint8_t* data, size_t size, const std::string& resource_path, const std::string& animation_id);
+std::shared_ptr<AnimationHandle> create_animation_handle(std::unique_ptr<rlottie::Animation> animation,
+                                                         std::shared_ptr<const AnimationSource> source);
+// A new handle with a renderer of its own over the source's model. Only an
+// open that does not find the model in rlottie's cache parses it again. Returns
+// nullptr if the source fails to load.
+std::shared_ptr<AnimationHandle> open_animation_handle(const std::shared_ptr<const AnimationSource>& source);
 size_t get_total_frames(std::unique_ptr<rlottie::Animation>& animation);
+// The frame nearest to `progress` (0-1) through the animation, clamped. This is
+// the rounding of rlottie's frameAtPos, computed from the metadata so that it
+// needs no render lock; rlottie only rasterizes whole frames.
+size_t frame_at_progress(size_t total_frames, double progress);
+// The frame nearest to time_ms into the animation at its own frame rate,
+// clamped, like rlottie's frameAtTime.
+size_t frame_at_time(size_t total_frames, double frame_rate, double time_ms);
 void render_frame_sync(std::unique_ptr<rlottie::Animation>& animation, size_t frame, rlottie::Surface& surface);
 
 #endif // ANIMATION_H
\ No newline at end of file
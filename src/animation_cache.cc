@@ -0,0 +1,171 @@
+#include "animation_cache.h"
+#include "animation_input.h"
+#include "hash.h"
+#include <algorithm>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+
+// The parsed model itself lives in rlottie's model cache under the source's
+// model key, so that every hit can build its own renderer instead of
+// contending for one. The source keeps the decoded JSON: rlottie rejects empty
+// data before it looks in its cache, and a model it has dropped since is
+// parsed again from the JSON.
+struct CacheEntry {
+    uint64_t key;
+    size_t size;
+    size_t bytes;
+    std::string resource_path;
+    std::string animation_id;
+    std::shared_ptr<const AnimationSource> source;
+};
+
+// rlottie's own default capacity, kept while the cache is off for the batch,
+// stream and sprite paths that share one model between their threads.
+static const size_t li_MODEL_CACHE_MIN_SIZE = 10;
+static size_t model_cache_size = li_MODEL_CACHE_MIN_SIZE;
+
+static std::mutex cache_mutex;
+static std::list<CacheEntry> cache_lru;
+static std::unordered_map<uint64_t, std::list<CacheEntry>::iterator> cache_index;
+static AnimationCacheStats cache_stats = {0, 0, 0, 0, 0, 0, 0};
+
+// rlottie cannot drop a single model, and only trims its cache when an insert
+// finds it exactly full, so a smaller capacity would never take effect. Setting
+// the capacity to 0 empties it; renderers already built keep their models, and
+// the entries still cached parse theirs again from the JSON they keep.
+static void reset_model_cache_locked() {
+    rlottie::configureModelCacheSize(0);
+    rlottie::configureModelCacheSize(model_cache_size);
+}
+
+static void evict_lru_locked() {
+    CacheEntry& entry = cache_lru.back();
+    cache_stats.bytes -= entry.bytes;
+    cache_stats.evictions++;
+    cache_index.erase(entry.key);
+    cache_lru.pop_back();
+}
+
+static void trim_locked() {
+    bool evicted = false;
+    while (!cache_lru.empty() &&
+           (cache_lru.size() > cache_stats.max_entries ||
+            (cache_stats.max_bytes && cache_stats.bytes > cache_stats.max_bytes))) {
+        evict_lru_locked();
+        evicted = true;
+    }
+    cache_stats.entries = cache_lru.size();
+    // Evicted models must not outlive their entries in rlottie's cache.
+    if (evicted) reset_model_cache_locked();
+}
+
+void configure_animation_cache(size_t max_entries, size_t max_bytes) {
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    cache_stats.max_entries = max_entries;
+    cache_stats.max_bytes = max_bytes;
+    size_t capacity = std::max(max_entries, li_MODEL_CACHE_MIN_SIZE);
+    if (capacity != model_cache_size) {
+        model_cache_size = capacity;
+        reset_model_cache_locked();
+    }
+    trim_locked();
+}
+
+void clear_animation_cache() {
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    cache_lru.clear();
+    cache_index.clear();
+    cache_stats.entries = 0;
+    cache_stats.bytes = 0;
+    reset_model_cache_locked();
+}
+
+AnimationCacheStats get_animation_cache_stats() {
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    return cache_stats;
+}
+
+static std::shared_ptr<AnimationHandle> parse_animation(const uint8_t* data, size_t size, const std::string& resource_path,
+                                                        const std::string& animation_id, std::string& error_msg) {
+    // rlottie parses in place and takes ownership of a std::string, so it gets
+    // a copy of the JSON the handle keeps for opening more renderers.
+    std::string json;
+    if (!decode_animation_input(data, size, animation_id, json, error_msg)) return nullptr;
+    auto source = std::make_shared<const AnimationSource>(
+        AnimationSource{json, animation_model_key(data, size, resource_path, animation_id), resource_path});
+    std::unique_ptr<rlottie::Animation> animation = load_animation_from_data(std::move(json), resource_path);
+    if (!animation) {
+        error_msg = "Failed to load Lottie animation from provided JSON data";
+        return nullptr;
+    }
+    return create_animation_handle(std::move(animation), std::move(source));
+}
+
+std::shared_ptr<AnimationHandle> load_cached_animation(const uint8_t* data, size_t size, const std::string& resource_path,
+                                                       const std::string& animation_id, std::string& error_msg) {
+    {
+        std::lock_guard<std::mutex> lock(cache_mutex);
+        if (cache_stats.max_entries == 0) {
+            return parse_animation(data, size, resource_path, animation_id, error_msg);
+        }
+    }
+
+    uint64_t seed = hash_bytes(animation_id.data(), animation_id.size(), hash_bytes(resource_path.data(), resource_path.size()));
+    uint64_t key = hash_bytes(data, size, seed);
+
+    std::shared_ptr<const AnimationSource> source;
+    {
+        std::lock_guard<std::mutex> lock(cache_mutex);
+        auto it = cache_index.find(key);
+        if (it != cache_index.end() && it->second->size == size && it->second->resource_path == resource_path &&
+            it->second->animation_id == animation_id) {
+            cache_lru.splice(cache_lru.begin(), cache_lru, it->second);
+            source = it->second->source;
+            cache_stats.hits++;
+        } else {
+            cache_stats.misses++;
+        }
+    }
+
+    // A hit skips decoding and, while rlottie still holds the model, parsing:
+    // loadFromData only copies the JSON and builds a renderer over the model.
+    if (source) {
+        std::shared_ptr<AnimationHandle> animation = open_animation_handle(source);
+        if (!animation) error_msg = "Failed to load Lottie animation from provided JSON data";
+        return animation;
+    }
+
+    // Parse outside the lock; if two threads miss on the same key the second
+    // insert simply replaces the first.
+    std::string json;
+    if (!decode_animation_input(data, size, animation_id, json, error_msg)) return nullptr;
+    // The decoded JSON is what the entry keeps, and stands in for the size of
+    // the parsed model; for .tgs and .lottie input it is several times the
+    // compressed input.
+    size_t bytes = json.size();
+    source = std::make_shared<const AnimationSource>(
+        AnimationSource{json, animation_model_key(data, size, resource_path, animation_id), resource_path});
+    std::unique_ptr<rlottie::Animation> animation = load_shared_animation_from_data(std::move(json), source->model_key, resource_path);
+    if (!animation) {
+        error_msg = "Failed to load Lottie animation from provided JSON data";
+        return nullptr;
+    }
+
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    if (cache_stats.max_entries == 0 || (cache_stats.max_bytes && bytes > cache_stats.max_bytes)) {
+        return create_animation_handle(std::move(animation), std::move(source));
+    }
+
+    auto it = cache_index.find(key);
+    if (it != cache_index.end()) {
+        cache_stats.bytes -= it->second->bytes;
+        cache_lru.erase(it->second);
+        cache_index.erase(it);
+    }
+    cache_lru.push_front(CacheEntry{key, size, bytes, resource_path, animation_id, source});
+    cache_index[key] = cache_lru.begin();
+    cache_stats.bytes += bytes;
+    trim_locked();
+    return create_animation_handle(std::move(animation), std::move(source));
+}
\ No newline at end of file
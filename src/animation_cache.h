@@ -0,0 +1,36 @@
+#ifndef ANIMATION_CACHE_H
+#define ANIMATION_CACHE_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include "animation.h"
+
+struct AnimationCacheStats {
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t evictions;
+    size_t entries;
+    size_t bytes;
+    size_t max_entries;
+    size_t max_bytes;
+};
+
+// Process-wide LRU of parsed animations keyed by a hash of the input bytes, the
+// resource path and the dotLottie animation ID. Disabled while max_entries is 0;
+// max_bytes of 0 means no byte budget. Entries keep their decoded JSON and are
+// charged by its size. The models are shared through rlottie's model cache,
+// sized to hold max_entries of them; configuring, clearing or evicting empties
+// it, so that it never holds models the budget has let go.
+void configure_animation_cache(size_t max_entries, size_t max_bytes);
+void clear_animation_cache();
+AnimationCacheStats get_animation_cache_stats();
+
+// Returns a new handle with its own renderer over the cached model when possible,
+// otherwise decodes and parses the data and caches the model. Handles are never
+// shared between calls, so their renders do not contend. On failure returns
+// nullptr and sets error_msg.
+std::shared_ptr<AnimationHandle> load_cached_animation(const uint8_t* data, size_t size, const std::string& resource_path,
+                                                       const std::string& animation_id, std::string& error_msg);
+
+#endif // ANIMATION_CACHE_H
\ No newline at end of file
@@ -0,0 +1,342 @@
+#include "animation_input.h"
+#include "json_scan.h"
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <vector>
+#include <zlib.h>
+
+#define li_MAX_INFLATED_SIZE (256u << 20)
+// Deflate's best case: 258-byte matches coded in a little over two bits.
+#define li_MAX_DEFLATE_RATIO 1032
+#define li_GZIP_TRAILER_SIZE 8
+#define li_ZIP_EOCD_SIZE 22
+#define li_ZIP_MAX_COMMENT 65535
+#define li_ZIP_CENTRAL_HEADER_SIZE 46
+#define li_ZIP_LOCAL_HEADER_SIZE 30
+#define li_ZIP_METHOD_STORED 0
+#define li_ZIP_METHOD_DEFLATE 8
+
+struct ZipEntry {
+    std::string name;
+    uint16_t method;
+    uint32_t crc;
+    uint32_t compressed_size;
+    uint32_t size;
+    uint32_t local_offset;
+};
+
+struct JsonEdit {
+    size_t begin;
+    size_t end;
+    std::string replacement;
+};
+
+static uint16_t get_u16(const uint8_t* p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t get_u32(const uint8_t* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+// How much to allocate up front for `compressed` bytes announced to inflate to
+// `announced`. The size fields are untrusted and std::string zero-fills, so the
+// guess never exceeds what the input could possibly inflate to.
+static size_t inflate_presize(size_t compressed, size_t announced) {
+    size_t limit = compressed > li_MAX_INFLATED_SIZE / li_MAX_DEFLATE_RATIO ? li_MAX_INFLATED_SIZE : compressed * li_MAX_DEFLATE_RATIO;
+    return std::min(announced, limit);
+}
+
+// Inflates into `out`, which the caller has sized to the expected output. The
+// buffer only grows while the stream keeps producing past that size.
+static bool inflate_into(const uint8_t* data, size_t size, int window_bits, std::string& out, std::string& error_msg) {
+    z_stream stream;
+    memset(&stream, 0, sizeof(stream));
+    if (inflateInit2(&stream, window_bits) != Z_OK) {
+        error_msg = "Failed to initialize decompression";
+        return false;
+    }
+
+    stream.next_in = const_cast<Bytef*>(data);
+    stream.avail_in = (uInt)size;
+    size_t total = 0;
+    int ret = Z_OK;
+    while (ret != Z_STREAM_END) {
+        if (total == out.size()) {
+            if (out.size() >= li_MAX_INFLATED_SIZE) {
+                inflateEnd(&stream);
+                error_msg = "Decompressed animation exceeds 256 MB";
+                return false;
+            }
+            out.resize(std::min<size_t>(std::max<size_t>(out.size() * 2, 4096), li_MAX_INFLATED_SIZE));
+        }
+        stream.next_out = reinterpret_cast<Bytef*>(&out[total]);
+        stream.avail_out = (uInt)(out.size() - total);
+        ret = inflate(&stream, Z_FINISH);
+        total = out.size() - stream.avail_out;
+        // Like gunzip, read concatenated gzip members as one stream.
+        if (ret == Z_STREAM_END && window_bits > 15 && stream.avail_in >= 2 && stream.next_in[0] == 0x1f && stream.next_in[1] == 0x8b) {
+            ret = inflateReset(&stream);
+            if (ret != Z_OK) break;
+            continue;
+        }
+        if (ret != Z_STREAM_END && ret != Z_OK && ret != Z_BUF_ERROR) break;
+        if (ret == Z_BUF_ERROR && stream.avail_out > 0) break;
+    }
+
+    inflateEnd(&stream);
+    if (ret != Z_STREAM_END) {
+        error_msg = "Failed to decompress animation data";
+        return false;
+    }
+    out.resize(total);
+    return true;
+}
+
+static bool inflate_gzip(const uint8_t* data, size_t size, std::string& json, std::string& error_msg) {
+    if (size < li_GZIP_TRAILER_SIZE) {
+        error_msg = "Truncated gzip data";
+        return false;
+    }
+    // ISIZE, the uncompressed length mod 2^32, closes the gzip trailer.
+    uint32_t expected = get_u32(data + size - 4);
+    json.resize(inflate_presize(size, expected));
+    return inflate_into(data, size, 15 + 16, json, error_msg);
+}
+
+static bool read_zip_directory(const uint8_t* data, size_t size, std::vector<ZipEntry>& entries, std::string& error_msg) {
+    error_msg = "Invalid dotLottie archive";
+    if (size < li_ZIP_EOCD_SIZE) return false;
+
+    size_t eocd = size - li_ZIP_EOCD_SIZE;
+    size_t lowest = size > li_ZIP_EOCD_SIZE + li_ZIP_MAX_COMMENT ? size - li_ZIP_EOCD_SIZE - li_ZIP_MAX_COMMENT : 0;
+    while (get_u32(data + eocd) != 0x06054b50) {
+        if (eocd == lowest) return false;
+        eocd--;
+    }
+
+    uint16_t count = get_u16(data + eocd + 10);
+    size_t offset = get_u32(data + eocd + 16);
+    for (uint16_t i = 0; i < count; i++) {
+        if (offset + li_ZIP_CENTRAL_HEADER_SIZE > size || get_u32(data + offset) != 0x02014b50) return false;
+        const uint8_t* header = data + offset;
+        size_t name_length = get_u16(header + 28);
+        size_t next = offset + li_ZIP_CENTRAL_HEADER_SIZE + name_length + get_u16(header + 30) + get_u16(header + 32);
+        if (next > size) return false;
+
+        ZipEntry entry;
+        entry.name.assign(reinterpret_cast<const char*>(header + li_ZIP_CENTRAL_HEADER_SIZE), name_length);
+        entry.method = get_u16(header + 10);
+        entry.crc = get_u32(header + 16);
+        entry.compressed_size = get_u32(header + 20);
+        entry.size = get_u32(header + 24);
+        entry.local_offset = get_u32(header + 42);
+        entries.push_back(std::move(entry));
+        offset = next;
+    }
+    error_msg.clear();
+    return true;
+}
+
+static const ZipEntry* find_zip_entry(const std::vector<ZipEntry>& entries, const std::string& name) {
+    for (const ZipEntry& entry : entries) {
+        if (entry.name == name) return &entry;
+    }
+    return nullptr;
+}
+
+static bool read_zip_entry(const uint8_t* data, size_t size, const ZipEntry& entry, std::string& out, std::string& error_msg) {
+    size_t offset = entry.local_offset;
+    if (offset + li_ZIP_LOCAL_HEADER_SIZE > size || get_u32(data + offset) != 0x04034b50) {
+        error_msg = "Invalid dotLottie archive entry " + entry.name;
+        return false;
+    }
+    size_t start = offset + li_ZIP_LOCAL_HEADER_SIZE + get_u16(data + offset + 26) + get_u16(data + offset + 28);
+    if (start + entry.compressed_size > size) {
+        error_msg = "Truncated dotLottie archive entry " + entry.name;
+        return false;
+    }
+    if (entry.size > li_MAX_INFLATED_SIZE) {
+        error_msg = "dotLottie archive entry " + entry.name + " exceeds 256 MB";
+        return false;
+    }
+
+    if (entry.method == li_ZIP_METHOD_STORED) {
+        out.assign(reinterpret_cast<const char*>(data + start), entry.compressed_size);
+    } else if (entry.method == li_ZIP_METHOD_DEFLATE) {
+        // The central directory records the exact size, so this is usually one
+        // allocation.
+        out.resize(inflate_presize(entry.compressed_size, entry.size));
+        if (!inflate_into(data + start, entry.compressed_size, -15, out, error_msg)) return false;
+    } else {
+        error_msg = "Unsupported compression in dotLottie archive entry " + entry.name;
+        return false;
+    }
+
+    if (crc32(0, reinterpret_cast<const Bytef*>(out.data()), (uInt)out.size()) != entry.crc) {
+        error_msg = "Corrupt dotLottie archive entry " + entry.name;
+        return false;
+    }
+    return true;
+}
+
+// Finds the animation's entry. Version 1 archives keep animations under
+// animations/, version 2 under a/.
+static const ZipEntry* find_animation_entry(const uint8_t* data, size_t size, const std::vector<ZipEntry>& entries,
+                                            const std::string& animation_id, std::string& error_msg) {
+    std::string id = animation_id;
+    if (id.empty()) {
+        const ZipEntry* manifest_entry = find_zip_entry(entries, "manifest.json");
+        std::string manifest;
+        if (manifest_entry && read_zip_entry(data, size, *manifest_entry, manifest, error_msg)) {
+            json_for_each_member(manifest, 0, [&](const std::string& key, size_t begin, size_t end) {
+                if (key != "animations") return true;
+                return json_for_each_element(manifest, begin, [&](size_t element, size_t) {
+                    if (!id.empty()) return true;
+                    return json_for_each_member(manifest, element, [&](const std::string& field, size_t value, size_t) {
+                        if (field == "id") json_read_string(manifest, value, &id);
+                        return true;
+                    });
+                });
+            });
+        }
+    }
+
+    if (!id.empty()) {
+        const ZipEntry* entry = find_zip_entry(entries, "animations/" + id + ".json");
+        if (!entry) entry = find_zip_entry(entries, "a/" + id + ".json");
+        if (!entry) error_msg = "Animation '" + id + "' not found in dotLottie archive";
+        return entry;
+    }
+
+    for (const ZipEntry& entry : entries) {
+        const std::string& name = entry.name;
+        bool in_folder = name.compare(0, 11, "animations/") == 0 || name.compare(0, 2, "a/") == 0;
+        if (in_folder && name.size() > 5 && name.compare(name.size() - 5, 5, ".json") == 0) return &entry;
+    }
+    error_msg = "No animation found in dotLottie archive";
+    return nullptr;
+}
+
+static void append_base64(std::string& out, const std::string& data) {
+    static const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    const uint8_t* p = reinterpret_cast<const uint8_t*>(data.data());
+    size_t size = data.size();
+    size_t i = 0;
+    for (; i + 3 <= size; i += 3) {
+        uint32_t v = ((uint32_t)p[i] << 16) | ((uint32_t)p[i + 1] << 8) | p[i + 2];
+        out.push_back(alphabet[v >> 18]);
+        out.push_back(alphabet[(v >> 12) & 0x3f]);
+        out.push_back(alphabet[(v >> 6) & 0x3f]);
+        out.push_back(alphabet[v & 0x3f]);
+    }
+    if (i < size) {
+        uint32_t v = (uint32_t)p[i] << 16;
+        if (i + 1 < size) v |= (uint32_t)p[i + 1] << 8;
+        out.push_back(alphabet[v >> 18]);
+        out.push_back(alphabet[(v >> 12) & 0x3f]);
+        out.push_back(i + 1 < size ? alphabet[(v >> 6) & 0x3f] : '=');
+        out.push_back('=');
+    }
+}
+
+static std::string image_mime_type(const std::string& name) {
+    size_t dot = name.rfind('.');
+    std::string ext = dot == std::string::npos ? "" : name.substr(dot + 1);
+    for (char& c : ext) c = (char)tolower((unsigned char)c);
+    if (ext == "jpg") ext = "jpeg";
+    if (ext == "svg") ext = "svg+xml";
+    return "image/" + (ext.empty() ? std::string("png") : ext);
+}
+
+// rlottie can only load image assets from disk or from data URIs, so images
+// that live inside the archive are rewritten as embedded data URIs.
+static bool inline_archive_images(const uint8_t* data, size_t size, const std::vector<ZipEntry>& entries,
+                                  std::string& json, std::string& error_msg) {
+    std::vector<JsonEdit> edits;
+    bool ok = true;
+
+    json_for_each_member(json, 0, [&](const std::string& key, size_t begin, size_t end) {
+        if (key != "assets") return true;
+        return json_for_each_element(json, begin, [&](size_t asset_begin, size_t) {
+            std::string directory, file;
+            size_t u_begin = 0, u_end = 0, p_begin = 0, p_end = 0, e_begin = 0, e_end = 0;
+            bool is_object = json_for_each_member(json, asset_begin, [&](const std::string& field, size_t value, size_t value_end) {
+                if (field == "u") {
+                    json_read_string(json, value, &directory);
+                    u_begin = value, u_end = value_end;
+                } else if (field == "p") {
+                    json_read_string(json, value, &file);
+                    p_begin = value, p_end = value_end;
+                } else if (field == "e") {
+                    e_begin = value, e_end = value_end;
+                }
+                return true;
+            });
+            if (!is_object || !p_end || file.empty() || file.compare(0, 5, "data:") == 0) return true;
+
+            while (!directory.empty() && directory[0] == '/') directory.erase(0, 1);
+            const ZipEntry* entry = find_zip_entry(entries, directory + file);
+            if (!entry) entry = find_zip_entry(entries, "images/" + file);
+            if (!entry) entry = find_zip_entry(entries, "i/" + file);
+            if (!entry) return true;
+
+            std::string image;
+            if (!read_zip_entry(data, size, *entry, image, error_msg)) {
+                ok = false;
+                return false;
+            }
+            std::string uri = "\"data:" + image_mime_type(entry->name) + ";base64,";
+            uri.reserve(uri.size() + (image.size() + 2) / 3 * 4 + 1);
+            append_base64(uri, image);
+            uri.push_back('"');
+
+            // Edits must stay in document order.
+            if (!e_end) edits.push_back(JsonEdit{asset_begin + 1, asset_begin + 1, "\"e\":1,"});
+            std::vector<JsonEdit> fields;
+            if (u_end) fields.push_back(JsonEdit{u_begin, u_end, "\"\""});
+            fields.push_back(JsonEdit{p_begin, p_end, std::move(uri)});
+            if (e_end) fields.push_back(JsonEdit{e_begin, e_end, "1"});
+            std::sort(fields.begin(), fields.end(), [](const JsonEdit& a, const JsonEdit& b) { return a.begin < b.begin; });
+            for (JsonEdit& edit : fields) edits.push_back(std::move(edit));
+            return true;
+        });
+    });
+    if (!ok) return false;
+    if (edits.empty()) return true;
+
+    size_t total = json.size();
+    for (const JsonEdit& edit : edits) total += edit.replacement.size() - (edit.end - edit.begin);
+    std::string patched;
+    patched.reserve(total);
+    size_t copied = 0;
+    for (const JsonEdit& edit : edits) {
+        patched.append(json, copied, edit.begin - copied);
+        patched.append(edit.replacement);
+        copied = edit.end;
+    }
+    patched.append(json, copied, std::string::npos);
+    json.swap(patched);
+    return true;
+}
+
+static bool read_dotlottie(const uint8_t* data, size_t size, const std::string& animation_id, std::string& json, std::string& error_msg) {
+    std::vector<ZipEntry> entries;
+    if (!read_zip_directory(data, size, entries, error_msg)) return false;
+
+    const ZipEntry* entry = find_animation_entry(data, size, entries, animation_id, error_msg);
+    if (!entry || !read_zip_entry(data, size, *entry, json, error_msg)) return false;
+    return inline_archive_images(data, size, entries, json, error_msg);
+}
+
+bool decode_animation_input(const uint8_t* data, size_t size, const std::string& animation_id, std::string& json, std::string& error_msg) {
+    if (size >= 2 && data[0] == 0x1f && data[1] == 0x8b) {
+        return inflate_gzip(data, size, json, error_msg);
+    }
+    if (size >= 4 && get_u32(data) == 0x04034b50) {
+        return read_dotlottie(data, size, animation_id, json, error_msg);
+    }
+    json.assign(reinterpret_cast<const char*>(data), size);
+    return true;
+}
\ No newline at end of file
@@ -0,0 +1,15 @@
+#ifndef ANIMATION_INPUT_H
+#define ANIMATION_INPUT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Turns loader input into Lottie JSON text. Plain JSON is copied as is,
+// gzip input (Telegram .tgs stickers) is inflated, and dotLottie (.lottie zip)
+// archives yield the animation named by animation_id, or the first one when it
+// is empty, with the archive's images inlined as data URIs. Runs on the
+// calling thread; callers invoke it from worker threads.
+bool decode_animation_input(const uint8_t* data, size_t size, const std::string& animation_id, std::string& json, std::string& error_msg);
+
+#endif // ANIMATION_INPUT_H
\ No newline at end of file
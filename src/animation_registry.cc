@@ -0,0 +1,45 @@
+#include "animation_registry.h"
+#include <mutex>
+#include <unordered_map>
+
+struct SharedAnimation {
+    std::shared_ptr<const AnimationSource> source;
+    size_t references;
+};
+
+static std::mutex registry_mutex;
+static std::unordered_map<uint32_t, SharedAnimation> registry;
+static std::unordered_map<const AnimationSource*, uint32_t> registry_ids;
+static uint32_t next_id = 1;
+
+uint32_t share_animation(const std::shared_ptr<AnimationHandle>& animation) {
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    auto it = registry_ids.find(animation->source.get());
+    if (it != registry_ids.end()) {
+        registry[it->second].references++;
+        return it->second;
+    }
+
+    uint32_t id = next_id++;
+    registry[id] = SharedAnimation{animation->source, 1};
+    registry_ids[animation->source.get()] = id;
+    return id;
+}
+
+std::shared_ptr<const AnimationSource> find_shared_animation(uint32_t id) {
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    auto it = registry.find(id);
+    if (it == registry.end()) return nullptr;
+    return it->second.source;
+}
+
+bool release_shared_animation(uint32_t id) {
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    auto it = registry.find(id);
+    if (it == registry.end()) return false;
+    if (--it->second.references == 0) {
+        registry_ids.erase(it->second.source.get());
+        registry.erase(it);
+    }
+    return true;
+}
\ No newline at end of file
@@ -0,0 +1,22 @@
+#ifndef ANIMATION_REGISTRY_H
+#define ANIMATION_REGISTRY_H
+
+#include <cstdint>
+#include <memory>
+#include "animation.h"
+
+// Process-wide table of animation sources published under a numeric ID, so
+// that another worker thread can open the same parsed model instead of parsing
+// its own copy. Every open gets a handle with its own renderer, so handles
+// opened from one ID render in parallel. Each share adds a reference to the
+// entry and each release drops one; open handles keep their source alive.
+
+// Publishes the handle's source and returns its ID, the same ID on every call
+// for handles opened from one source. IDs are never reused within a process.
+uint32_t share_animation(const std::shared_ptr<AnimationHandle>& animation);
+// Returns nullptr for an unknown or fully released ID.
+std::shared_ptr<const AnimationSource> find_shared_animation(uint32_t id);
+// Returns false for an unknown ID.
+bool release_shared_animation(uint32_t id);
+
+#endif // ANIMATION_REGISTRY_H
\ No newline at end of file
@@ -0,0 +1,361 @@
+#include "apng.h"
+#include "animation.h"
+#include "animation_cache.h"
+#include "buffer_pool.h"
+#include "exports.h"
+#include "png_writer.h"
+#include "utils.h"
+#include <cmath>
+#include <cstring>
+
+#define lp_COLOR_BYTES 4
+#define li_APNG_DEFAULT_LEVEL 6
+#define li_MAX_DELAY 65535
+#define li_MAX_FPS 1000
+
+enum ApngDisposeOp {
+    APNG_DISPOSE_NONE = 0
+};
+
+enum ApngBlendOp {
+    APNG_BLEND_SOURCE = 0
+};
+
+struct DirtyRect {
+    int x;
+    int y;
+    int width;
+    int height;
+};
+
+AnimationExportData* create_animation_export_data(napi_env env, const byte* in_data, size_t size) {
+    BatchData* batch = create_batch_data(env, in_data, size);
+    if (!batch) return nullptr;
+
+    AnimationExportData* data = new AnimationExportData();
+    data->batch = batch;
+    data->fps_override = 0;
+    data->loop = 0;
+
+    // A whole animation is written once and kept, so it is worth a higher
+    // level than the one single frames default to.
+    batch->base->png.compression_level = li_APNG_DEFAULT_LEVEL;
+    batch->base->format = OUTPUT_APNG;
+    return data;
+}
+
+void destroy_animation_export_data(AnimationExportData* data) {
+    if (data) {
+        destroy_batch_data(data->batch);
+        delete data;
+    }
+}
+
+// Bounding box of the pixels that differ between two frames; false if the
+// frames are identical.
+static bool find_dirty_rect(const uint32_t* previous, const uint32_t* current, int width, int height, DirtyRect* rect) {
+    size_t row_bytes = (size_t)width * lp_COLOR_BYTES;
+    int top = 0;
+    while (top < height && memcmp(previous + (size_t)top * width, current + (size_t)top * width, row_bytes) == 0) top++;
+    if (top == height) return false;
+
+    int bottom = height - 1;
+    while (bottom > top && memcmp(previous + (size_t)bottom * width, current + (size_t)bottom * width, row_bytes) == 0) bottom--;
+
+    int left = width;
+    int right = -1;
+    for (int y = top; y <= bottom; y++) {
+        const uint32_t* a = previous + (size_t)y * width;
+        const uint32_t* b = current + (size_t)y * width;
+        int x = 0;
+        while (x < left && a[x] == b[x]) x++;
+        if (x < left) left = x;
+        x = width - 1;
+        while (x > right && a[x] == b[x]) x--;
+        if (x > right) right = x;
+    }
+
+    *rect = {left, top, right - left + 1, bottom - top + 1};
+    return true;
+}
+
+static void put_u16(byte* p, uint32_t value) {
+    p[0] = (byte)(value >> 8);
+    p[1] = (byte)value;
+}
+
+static void put_u32(byte* p, uint32_t value) {
+    p[0] = (byte)(value >> 24);
+    p[1] = (byte)(value >> 16);
+    p[2] = (byte)(value >> 8);
+    p[3] = (byte)value;
+}
+
+// Frame delays share one denominator, so identical frames can be merged into
+// the previous frame by adding numerators. Integral frame rates are exact.
+static void frame_delay(double fps, uint32_t step, uint32_t* num, uint32_t* den) {
+    if (fps == std::floor(fps) && fps <= li_MAX_DELAY) {
+        *den = (uint32_t)fps;
+        *num = step;
+    } else {
+        *den = 1000;
+        *num = (uint32_t)std::lround(step * 1000.0 / fps);
+    }
+    if (*num > li_MAX_DELAY) *num = li_MAX_DELAY;
+    if (*num == 0) *num = 1;
+}
+
+bool export_apng_sync(AnimationExportData* data) {
+    BatchData* batch = data->batch;
+    ConverterData* base = batch->base;
+
+    if (!open_converter_input(base)) return false;
+    if (!base->animation) {
+        base->animation = load_cached_animation(base->in_data, base->in_size, base->resource_path, base->animation_id, base->error_msg);
+        if (!base->animation) return false;
+    }
+    if (!resolve_batch_frames(batch, base->animation->total_frames, base->animation->frame_rate)) {
+        return false;
+    }
+    if (batch->frames.empty()) {
+        base->error_msg = "No frames selected";
+        return false;
+    }
+
+    double fps = data->fps_override > 0 ? data->fps_override : base->animation->frame_rate;
+    if (!(fps > 0)) fps = 30;
+    uint32_t delay_num, delay_den;
+    frame_delay(fps, batch->use_range ? batch->range_step : 1, &delay_num, &delay_den);
+
+    int width = base->width;
+    int height = base->height;
+    size_t frame_bytes = (size_t)width * height * lp_COLOR_BYTES;
+    ScratchBuffer previous(frame_bytes);
+    ScratchBuffer current(frame_bytes);
+    if (!previous || !current) {
+        base->error_msg = "Failed to allocate frame buffer (width: " + std::to_string(width) + ", height: " + std::to_string(height) + ")";
+        return false;
+    }
+
+    PngBuffer out = {nullptr, 0, 0};
+    byte actl[8];
+    put_u32(actl, (uint32_t)batch->frames.size());
+    put_u32(actl + 4, data->loop);
+    size_t actl_offset = 0;
+    bool ok = append_png_header(&out, width, height);
+    if (ok) {
+        actl_offset = out.size;
+        ok = append_png_chunk(&out, "acTL", actl, sizeof(actl));
+    }
+
+    uint32_t sequence = 0;
+    uint32_t frames_written = 0;
+    size_t last_fctl_offset = 0;
+    uint32_t last_delay = 0;
+    std::vector<byte> payload;
+    uint32_t* previous_pixels = previous.pixels();
+    uint32_t* current_pixels = current.pixels();
+
+    for (size_t i = 0; ok && i < batch->frames.size(); i++) {
+        rlottie::Surface surface(current_pixels, width, height, width * lp_COLOR_BYTES);
+        {
+            std::lock_guard<std::mutex> lock(base->animation->mutex);
+            render_frame_sync(base->animation->animation, batch->frames[i], surface);
+        }
+        if (is_cancelled(base->cancel)) {
+            free(out.buffer);
+            base->error_msg = ls_ABORTED_MESSAGE;
+            return false;
+        }
+
+        DirtyRect rect = {0, 0, width, height};
+        if (i > 0 && !find_dirty_rect(previous_pixels, current_pixels, width, height, &rect)) {
+            // Nothing changed: hold the previous frame longer instead.
+            if (last_delay + delay_num <= li_MAX_DELAY) {
+                last_delay += delay_num;
+                put_u16(out.buffer + last_fctl_offset + 8 + 20, last_delay);
+                update_png_chunk_crc(&out, last_fctl_offset);
+                continue;
+            }
+            rect = {0, 0, 1, 1};
+        }
+
+        byte fctl[26];
+        put_u32(fctl, sequence++);
+        put_u32(fctl + 4, rect.width);
+        put_u32(fctl + 8, rect.height);
+        put_u32(fctl + 12, rect.x);
+        put_u32(fctl + 16, rect.y);
+        put_u16(fctl + 20, delay_num);
+        put_u16(fctl + 22, delay_den);
+        fctl[24] = APNG_DISPOSE_NONE;
+        fctl[25] = APNG_BLEND_SOURCE;
+        last_fctl_offset = out.size;
+        last_delay = delay_num;
+        ok = append_png_chunk(&out, "fcTL", fctl, sizeof(fctl));
+
+        // The first frame doubles as the default image, so it goes in IDAT;
+        // later frames are fdAT chunks, which lead with a sequence number.
+        payload.clear();
+        if (i > 0) {
+            payload.resize(4);
+            put_u32(payload.data(), sequence++);
+        }
+        const uint32_t* origin = current_pixels + (size_t)rect.y * width + rect.x;
+        if (ok && !compress_png_image(origin, width, rect.width, rect.height, base->png, payload)) {
+            free(out.buffer);
+            base->error_msg = "Failed to compress PNG data";
+            return false;
+        }
+        ok = ok && append_png_chunk(&out, i > 0 ? "fdAT" : "IDAT", payload.data(), payload.size());
+        frames_written++;
+        std::swap(previous_pixels, current_pixels);
+    }
+
+    ok = ok && append_png_chunk(&out, "IEND", nullptr, 0);
+    if (!ok) {
+        free(out.buffer);
+        base->error_msg = "Failed to allocate memory for APNG";
+        return false;
+    }
+
+    put_u32(out.buffer + actl_offset + 8, frames_written);
+    update_png_chunk_crc(&out, actl_offset);
+
+    if (out.capacity - out.size > out.capacity / 4) {
+        byte* shrunk = (byte*)realloc(out.buffer, out.size);
+        if (shrunk) out.buffer = shrunk;
+    }
+    base->result_buffer = out.buffer;
+    base->result_size = out.size;
+    return true;
+}
+
+static const char* parse_animation_options(napi_env env, napi_value options, AnimationExportData* data) {
+    ConverterData* base = data->batch->base;
+    const char* error = parse_converter_options(env, options, base);
+    if (error) return error;
+    if (base->target_ref) return "Target is only supported when exporting a single frame";
+    if (base->viewport.enabled) return "Viewport, scale, tileSize and sizes above 4096 are only supported when exporting a single frame";
+    if (base->frame_address != FRAME_ADDRESS_INDEX) return "Time and progress are only supported when exporting a single frame";
+
+    napi_valuetype arg_type;
+    napi_status status = napi_typeof(env, options, &arg_type);
+    if (status != napi_ok || arg_type != napi_object) return nullptr;
+
+    napi_value prop;
+    if (has_own_property(env, options, "frameRange")) {
+        status = napi_get_named_property(env, options, "frameRange", &prop);
+        if (status == napi_ok) {
+            error = parse_frame_selection(env, prop, data->batch);
+            if (error) return error;
+        }
+    }
+
+    if (has_own_property(env, options, "fpsOverride")) {
+        status = napi_get_named_property(env, options, "fpsOverride", &prop);
+        if (status == napi_ok) {
+            double fps;
+            status = napi_get_value_double(env, prop, &fps);
+            if (status != napi_ok || !(fps > 0) || fps > li_MAX_FPS) {
+                return "FPS override must be a number greater than 0 and at most 1000";
+            }
+            data->fps_override = fps;
+        }
+    }
+
+    if (has_own_property(env, options, "loop")) {
+        status = napi_get_named_property(env, options, "loop", &prop);
+        if (status == napi_ok) {
+            if (napi_get_value_uint32(env, prop, &data->loop) != napi_ok) {
+                return "Loop must be a valid integer";
+            }
+        }
+    }
+
+    return nullptr;
+}
+
+static void execute_animation_work(napi_env env, void* data) {
+    AnimationExportData* export_data = static_cast<AnimationExportData*>(data);
+    export_data->batch->base->success = export_apng_sync(export_data);
+}
+
+static void abandon_animation_work(void* data) {
+    AnimationExportData* export_data = static_cast<AnimationExportData*>(data);
+    drop_converter_refs(export_data->batch->base);
+    destroy_animation_export_data(export_data);
+}
+
+static void complete_animation_work(napi_env env, napi_status status, void* data) {
+    AnimationExportData* export_data = static_cast<AnimationExportData*>(data);
+    ConverterData* base = export_data->batch->base;
+    napi_value result;
+
+    if (status == napi_cancelled) {
+        base->error_msg = ls_ABORTED_MESSAGE;
+    }
+
+    if (base->success) {
+        status = create_owned_buffer(env, base->result_buffer, base->result_size, &result);
+        base->result_buffer = nullptr;
+        if (status == napi_ok) {
+            napi_resolve_deferred(env, base->deferred, result);
+        } else {
+            napi_create_string_utf8(env, "Failed to create result buffer", NAPI_AUTO_LENGTH, &result);
+            napi_reject_deferred(env, base->deferred, result);
+        }
+    } else {
+        status = napi_create_string_utf8(env, base->error_msg.c_str(), NAPI_AUTO_LENGTH, &result);
+        if (status == napi_ok) {
+            napi_reject_deferred(env, base->deferred, result);
+        }
+    }
+
+    destroy_animation_export_data(export_data);
+}
+
+napi_value exportAnimation(napi_env env, napi_callback_info info) {
+    size_t argc = 2;
+    napi_value args[2];
+    napi_status status = napi_get_cb_info(env, info, &argc, args, nullptr, nullptr);
+    CHECK_STATUS(env, status, "Failed to get callback info");
+
+    if (argc < 1) {
+        THROW_ERROR(env, "Expected at least 1 argument: Lottie JSON buffer");
+    }
+
+    AnimationExportData* data = create_animation_export_data(env, nullptr, 0);
+    if (!data) {
+        THROW_ERROR(env, "Failed to allocate converter data");
+    }
+    ConverterData* base = data->batch->base;
+    const char* input_error = get_converter_input(env, args[0], base, true);
+    if (input_error) {
+        destroy_animation_export_data(data);
+        THROW_ERROR(env, input_error);
+    }
+
+    if (argc >= 2 && args[1] != nullptr) {
+        const char* error = parse_animation_options(env, args[1], data);
+        if (error) {
+            destroy_animation_export_data(data);
+            THROW_ERROR(env, error);
+        }
+    }
+
+    napi_value promise;
+    status = napi_create_promise(env, &base->deferred, &promise);
+    if (status != napi_ok) {
+        destroy_animation_export_data(data);
+        THROW_ERROR(env, "Failed to create promise");
+    }
+
+    status = queue_pool_work(env, execute_animation_work, complete_animation_work, abandon_animation_work, data, base->priority, base->cancel);
+    if (status != napi_ok) {
+        destroy_animation_export_data(data);
+        THROW_ERROR(env, "Failed to queue async work");
+    }
+
+    return promise;
+}
\ No newline at end of file
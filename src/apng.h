@@ -0,0 +1,18 @@
+#ifndef APNG_H
+#define APNG_H
+
+#include <napi.h>
+#include "batch.h"
+
+struct AnimationExportData {
+    BatchData* batch;
+    double fps_override;
+    uint32_t loop;
+};
+
+AnimationExportData* create_animation_export_data(napi_env env, const byte* in_data, size_t size);
+void destroy_animation_export_data(AnimationExportData* data);
+bool export_apng_sync(AnimationExportData* data);
+napi_value exportAnimation(napi_env env, napi_callback_info info);
+
+#endif // APNG_H
\ No newline at end of file
@@ -0,0 +1,502 @@
+#include "batch.h"
+#include "animation.h"
+#include "animation_input.h"
+#include "buffer_pool.h"
+#include "exports.h"
+#include "parallel.h"
+#include "utils.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <mutex>
+#include <unordered_map>
+
+#define lp_COLOR_BYTES 4
+#define li_MAX_CONCURRENCY 64
+#define li_DEDUPE_CHUNKS_PER_WORKER 4
+#define li_MAX_SAMPLES (1 << 20)
+#define ld_MAX_SAMPLE_FPS 1000.0
+
+struct BatchWorker {
+    std::unique_ptr<rlottie::Animation> animation;
+    std::unique_ptr<ScratchBuffer> buffer;
+    std::unique_ptr<ScratchBuffer> previous;
+    // Index of the frame held in `previous`, or SIZE_MAX.
+    size_t previous_index = SIZE_MAX;
+};
+
+BatchData* create_batch_data(napi_env env, const byte* in_data, size_t size) {
+    ConverterData* base = create_converter_data(env, in_data, size);
+    if (!base) return nullptr;
+
+    BatchData* data = new BatchData();
+    data->base = base;
+    data->use_range = true;
+    data->range_start = 0;
+    data->range_end = 0;
+    data->range_step = 1;
+    data->has_range_end = false;
+    data->sample_fps = 0;
+    data->concurrency = 0;
+    data->dedupe = true;
+    return data;
+}
+
+void destroy_batch_data(BatchData* data) {
+    if (data) {
+        for (FrameResult& result : data->results) {
+            free(result.buffer);
+        }
+        destroy_converter_data(data->base);
+        delete data;
+    }
+}
+
+bool resolve_batch_frames(BatchData* data, size_t frame_count, double frame_rate) {
+    if (data->sample_fps > 0) {
+        if (!(frame_rate > 0)) {
+            data->base->error_msg = "The animation has no frame rate to resample";
+            return false;
+        }
+        double duration_ms = frame_count * 1000.0 / frame_rate;
+        double samples = std::ceil(duration_ms * data->sample_fps / 1000.0);
+        if (samples > li_MAX_SAMPLES) {
+            data->base->error_msg = "Resampling would produce more than " + std::to_string(li_MAX_SAMPLES) + " frames";
+            return false;
+        }
+        data->times.resize((size_t)samples);
+        for (size_t i = 0; i < data->times.size(); i++) {
+            data->times[i] = i * 1000.0 / data->sample_fps;
+        }
+    }
+    if (!data->use_range && (data->sample_fps > 0 || !data->times.empty())) {
+        data->frames.resize(data->times.size());
+        for (size_t i = 0; i < data->times.size(); i++) {
+            data->frames[i] = (uint32_t)frame_at_time(frame_count, frame_rate, data->times[i]);
+        }
+    }
+
+    if (data->use_range) {
+        uint32_t end = data->has_range_end ? data->range_end : (uint32_t)(frame_count ? frame_count - 1 : 0);
+        data->frames.clear();
+        if (frame_count) {
+            // Checked before expanding, so that a huge range cannot allocate
+            // a frame list of billions of entries.
+            if (end >= frame_count) {
+                data->base->error_msg = "Frame index " + std::to_string(end) + " out of range (total frames: " + std::to_string(frame_count) + ")";
+                return false;
+            }
+            if (data->range_start > end) {
+                data->base->error_msg = "Frame range start " + std::to_string(data->range_start) + " is after its end " + std::to_string(end);
+                return false;
+            }
+            for (uint64_t frame = data->range_start; frame <= end; frame += data->range_step) {
+                data->frames.push_back((uint32_t)frame);
+            }
+        }
+    }
+
+    for (uint32_t frame : data->frames) {
+        if (frame >= frame_count) {
+            data->base->error_msg = "Frame index " + std::to_string(frame) + " out of range (total frames: " + std::to_string(frame_count) + ")";
+            return false;
+        }
+    }
+    return true;
+}
+
+bool export_frames_sync(BatchData* data) {
+    ConverterData* base = data->base;
+    if (!open_converter_input(base)) return false;
+    std::string json_data;
+    if (!decode_animation_input(base->in_data, base->in_size, base->animation_id, json_data, base->error_msg)) {
+        return false;
+    }
+    std::string key = animation_model_key(base->in_data, base->in_size, base->resource_path, base->animation_id);
+
+    // Parse once; the other workers' instances share this model through rlottie's
+    // model cache and only build their own renderer.
+    std::unique_ptr<rlottie::Animation> animation = load_shared_animation_from_data(json_data, key, base->resource_path);
+    if (!animation) {
+        base->error_msg = "Failed to load Lottie animation from provided JSON data";
+        return false;
+    }
+
+    if (!resolve_batch_frames(data, get_total_frames(animation), animation->frameRate())) {
+        return false;
+    }
+
+    size_t count = data->frames.size();
+    size_t concurrency = data->concurrency ? data->concurrency : default_concurrency();
+    if (concurrency > count) concurrency = count;
+    data->results.assign(count, FrameResult{nullptr, 0, 0});
+    for (size_t i = 0; i < count; i++) data->results[i].source = i;
+
+    // With dedupe, a frame requested more than once (as resampling to a lower
+    // frame rate does) is rendered for its first request only.
+    std::vector<size_t> first_request(count);
+    if (data->dedupe) {
+        std::unordered_map<uint32_t, size_t> requested;
+        for (size_t i = 0; i < count; i++) {
+            first_request[i] = requested.emplace(data->frames[i], i).first->second;
+        }
+    } else {
+        for (size_t i = 0; i < count; i++) first_request[i] = i;
+    }
+
+    std::vector<BatchWorker> workers(concurrency ? concurrency : 1);
+    workers[0].animation = std::move(animation);
+    std::mutex error_mutex;
+
+    auto fail = [&](const std::string& message) {
+        std::lock_guard<std::mutex> lock(error_mutex);
+        if (base->error_msg.empty()) base->error_msg = message;
+        return false;
+    };
+
+    // With dedupe, workers take runs of consecutive frames so that each frame
+    // can be compared against the one rendered just before it on the same
+    // thread. A few runs per worker keep the load balanced.
+    size_t frame_bytes = (size_t)base->width * base->height * lp_COLOR_BYTES;
+    size_t run_length = 1;
+    if (data->dedupe && concurrency) {
+        run_length = std::max((size_t)1, count / (concurrency * li_DEDUPE_CHUNKS_PER_WORKER));
+    }
+    size_t run_count = (count + run_length - 1) / run_length;
+
+    bool ok = parallel_for(run_count, concurrency, [&](size_t worker_index, size_t run) {
+        BatchWorker& worker = workers[worker_index];
+        if (!worker.animation) {
+            worker.animation = load_shared_animation_from_data(json_data, key, base->resource_path);
+            if (!worker.animation) {
+                return fail("Failed to load Lottie animation from provided JSON data");
+            }
+        }
+        if (!worker.buffer) {
+            worker.buffer.reset(new ScratchBuffer(frame_bytes));
+            if (data->dedupe) worker.previous.reset(new ScratchBuffer(frame_bytes));
+            if (!*worker.buffer || (data->dedupe && !*worker.previous)) {
+                return fail("Failed to allocate frame buffer (width: " + std::to_string(base->width) + ", height: " + std::to_string(base->height) + ")");
+            }
+        }
+
+        size_t first = run * run_length;
+        size_t last = std::min(first + run_length, count);
+        for (size_t index = first; index < last; index++) {
+            if (first_request[index] != index) {
+                // A repeat of the frame before it still matches `previous`.
+                if (worker.previous_index == index - 1 && data->frames[index] == data->frames[index - 1]) {
+                    worker.previous_index = index;
+                }
+                continue;
+            }
+            rlottie::Surface surface(worker.buffer->pixels(), base->width, base->height, base->width * lp_COLOR_BYTES);
+            render_frame_sync(worker.animation, data->frames[index], surface);
+            if (is_cancelled(base->cancel)) {
+                return fail(ls_ABORTED_MESSAGE);
+            }
+
+            FrameResult& result = data->results[index];
+            if (index > 0 && worker.previous_index == index - 1 && memcmp(worker.buffer->data(), worker.previous->data(), frame_bytes) == 0) {
+                result.source = data->results[index - 1].source;
+                worker.previous_index = index;
+                continue;
+            }
+
+            std::string error_msg;
+            if (!encode_frame(worker.buffer->pixels(), base->width, base->height, base->png, base->format, &result.buffer, &result.size, error_msg)) {
+                return fail(error_msg);
+            }
+            if (data->dedupe) {
+                std::swap(worker.buffer, worker.previous);
+                worker.previous_index = index;
+            }
+        }
+        return true;
+    });
+
+    // A frame matching its predecessor may have copied the source of a repeat
+    // request before that was resolved; sources always come earlier, so one
+    // pass in order points every result at the one that was encoded.
+    for (size_t i = 0; ok && i < count; i++) {
+        size_t source = first_request[i] != i ? first_request[i] : data->results[i].source;
+        data->results[i].source = data->results[source].source;
+    }
+    return ok;
+}
+
+static void execute_batch_work(napi_env env, void* data) {
+    BatchData* batch_data = static_cast<BatchData*>(data);
+    batch_data->base->success = export_frames_sync(batch_data);
+}
+
+static void abandon_batch_work(void* data) {
+    BatchData* batch_data = static_cast<BatchData*>(data);
+    drop_converter_refs(batch_data->base);
+    destroy_batch_data(batch_data);
+}
+
+static napi_status append_duplicate(napi_env env, napi_value duplicates, uint32_t position, size_t index, size_t source) {
+    napi_value pair, value;
+    napi_status status = napi_create_array_with_length(env, 2, &pair);
+    if (status == napi_ok) status = napi_create_uint32(env, (uint32_t)index, &value);
+    if (status == napi_ok) status = napi_set_element(env, pair, 0, value);
+    if (status == napi_ok) status = napi_create_uint32(env, (uint32_t)source, &value);
+    if (status == napi_ok) status = napi_set_element(env, pair, 1, value);
+    if (status == napi_ok) status = napi_set_element(env, duplicates, position, pair);
+    return status;
+}
+
+static void complete_batch_work(napi_env env, napi_status status, void* data) {
+    BatchData* batch_data = static_cast<BatchData*>(data);
+    ConverterData* base = batch_data->base;
+    napi_value result;
+
+    if (status == napi_cancelled) {
+        base->error_msg = ls_ABORTED_MESSAGE;
+    }
+
+    if (base->success) {
+        std::vector<FrameResult>& results = batch_data->results;
+        std::vector<napi_value> frames(results.size());
+        napi_value duplicates, frame_numbers;
+        uint32_t duplicate_count = 0;
+        status = napi_create_array_with_length(env, results.size(), &result);
+        if (status == napi_ok) {
+            status = napi_create_array(env, &duplicates);
+        }
+        if (status == napi_ok) {
+            status = napi_create_array_with_length(env, results.size(), &frame_numbers);
+        }
+        for (size_t i = 0; status == napi_ok && i < results.size(); i++) {
+            // Deduplicated frames share their source's Buffer. They are listed
+            // by result index, since resampling can request a frame number
+            // more than once.
+            if (results[i].source != i) {
+                frames[i] = frames[results[i].source];
+                status = append_duplicate(env, duplicates, duplicate_count++, i, results[i].source);
+            } else {
+                status = create_owned_buffer(env, results[i].buffer, results[i].size, &frames[i]);
+                results[i].buffer = nullptr;
+            }
+            if (status == napi_ok) {
+                status = napi_set_element(env, result, (uint32_t)i, frames[i]);
+            }
+            napi_value frame_number;
+            if (status == napi_ok) {
+                status = napi_create_uint32(env, batch_data->frames[i], &frame_number);
+            }
+            if (status == napi_ok) {
+                status = napi_set_element(env, frame_numbers, (uint32_t)i, frame_number);
+            }
+        }
+        if (status == napi_ok) {
+            status = napi_set_named_property(env, result, "duplicates", duplicates);
+        }
+        if (status == napi_ok) {
+            status = napi_set_named_property(env, result, "frames", frame_numbers);
+        }
+        if (status == napi_ok) {
+            napi_resolve_deferred(env, base->deferred, result);
+        } else {
+            napi_create_string_utf8(env, "Failed to create result buffers", NAPI_AUTO_LENGTH, &result);
+            napi_reject_deferred(env, base->deferred, result);
+        }
+    } else {
+        status = napi_create_string_utf8(env, base->error_msg.c_str(), NAPI_AUTO_LENGTH, &result);
+        if (status == napi_ok) {
+            napi_reject_deferred(env, base->deferred, result);
+        }
+    }
+
+    destroy_batch_data(batch_data);
+}
+
+const char* parse_frame_selection(napi_env env, napi_value value, BatchData* data) {
+    bool is_array;
+    napi_status status = napi_is_array(env, value, &is_array);
+    if (status != napi_ok) return "Failed to get type of frames option";
+
+    if (is_array) {
+        uint32_t length;
+        status = napi_get_array_length(env, value, &length);
+        if (status != napi_ok) return "Failed to get length of frames option";
+
+        data->use_range = false;
+        data->frames.resize(length);
+        for (uint32_t i = 0; i < length; i++) {
+            napi_value element;
+            status = napi_get_element(env, value, i, &element);
+            if (status != napi_ok || napi_get_value_uint32(env, element, &data->frames[i]) != napi_ok) {
+                return "Frames must be valid integers";
+            }
+        }
+        return nullptr;
+    }
+
+    napi_valuetype value_type;
+    status = napi_typeof(env, value, &value_type);
+    if (status != napi_ok || value_type != napi_object) {
+        return "Frames must be an array of frame indices or a { start, end, step } range";
+    }
+
+    napi_value prop;
+    if (has_own_property(env, value, "start")) {
+        status = napi_get_named_property(env, value, "start", &prop);
+        if (status != napi_ok || napi_get_value_uint32(env, prop, &data->range_start) != napi_ok) {
+            return "Range start must be a valid integer";
+        }
+    }
+    if (has_own_property(env, value, "end")) {
+        status = napi_get_named_property(env, value, "end", &prop);
+        if (status != napi_ok || napi_get_value_uint32(env, prop, &data->range_end) != napi_ok) {
+            return "Range end must be a valid integer";
+        }
+        data->has_range_end = true;
+    }
+    if (has_own_property(env, value, "step")) {
+        status = napi_get_named_property(env, value, "step", &prop);
+        if (status != napi_ok || napi_get_value_uint32(env, prop, &data->range_step) != napi_ok || data->range_step == 0) {
+            return "Range step must be a positive integer";
+        }
+    }
+    return nullptr;
+}
+
+// Parses the times and fps options, which select frames by time instead of
+// by index.
+static const char* parse_resampling(napi_env env, napi_value options, BatchData* data) {
+    bool has_times = has_own_property(env, options, "times");
+    bool has_fps = has_own_property(env, options, "fps");
+    if (!has_times && !has_fps) return nullptr;
+    if ((has_times && has_fps) || has_own_property(env, options, "frames")) {
+        return "Only one of frames, times and fps can be given";
+    }
+
+    napi_value prop;
+    napi_status status;
+    if (has_times) {
+        status = napi_get_named_property(env, options, "times", &prop);
+        bool is_array = false;
+        if (status != napi_ok || napi_is_array(env, prop, &is_array) != napi_ok || !is_array) {
+            return "Times must be an array of non-negative numbers of milliseconds";
+        }
+        uint32_t length;
+        status = napi_get_array_length(env, prop, &length);
+        if (status != napi_ok) return "Failed to get length of times option";
+        data->times.resize(length);
+        for (uint32_t i = 0; i < length; i++) {
+            napi_value element;
+            status = napi_get_element(env, prop, i, &element);
+            if (status != napi_ok || napi_get_value_double(env, element, &data->times[i]) != napi_ok ||
+                !(data->times[i] >= 0) || !std::isfinite(data->times[i])) {
+                return "Times must be an array of non-negative numbers of milliseconds";
+            }
+        }
+    } else {
+        status = napi_get_named_property(env, options, "fps", &prop);
+        if (status != napi_ok || napi_get_value_double(env, prop, &data->sample_fps) != napi_ok ||
+            !(data->sample_fps > 0) || data->sample_fps > ld_MAX_SAMPLE_FPS) {
+            return "Fps must be a number greater than 0 and at most 1000";
+        }
+    }
+    data->use_range = false;
+    return nullptr;
+}
+
+const char* parse_batch_options(napi_env env, napi_value options, BatchData* data) {
+    const char* error = parse_converter_options(env, options, data->base);
+    if (error) return error;
+    if (data->base->target_ref) return "Target is only supported when exporting a single frame";
+    if (data->base->viewport.enabled) return "Viewport, scale, tileSize and sizes above 4096 are only supported when exporting a single frame";
+
+    napi_valuetype arg_type;
+    napi_status status = napi_typeof(env, options, &arg_type);
+    if (status != napi_ok || arg_type != napi_object) return nullptr;
+
+    if (data->base->frame_address != FRAME_ADDRESS_INDEX) {
+        return "Time and progress select a single frame; use times or fps to resample a batch";
+    }
+
+    napi_value prop;
+    if (has_own_property(env, options, "frames")) {
+        status = napi_get_named_property(env, options, "frames", &prop);
+        if (status == napi_ok) {
+            error = parse_frame_selection(env, prop, data);
+            if (error) return error;
+        }
+    }
+
+    error = parse_resampling(env, options, data);
+    if (error) return error;
+
+    if (has_own_property(env, options, "concurrency")) {
+        status = napi_get_named_property(env, options, "concurrency", &prop);
+        if (status == napi_ok) {
+            uint32_t concurrency;
+            status = napi_get_value_uint32(env, prop, &concurrency);
+            if (status != napi_ok) {
+                return "Concurrency must be a valid integer";
+            }
+            if (concurrency < 1 || concurrency > li_MAX_CONCURRENCY) {
+                return "Concurrency must be between 1 and 64";
+            }
+            data->concurrency = concurrency;
+        }
+    }
+
+    if (has_own_property(env, options, "dedupe")) {
+        status = napi_get_named_property(env, options, "dedupe", &prop);
+        if (status == napi_ok) {
+            if (napi_get_value_bool(env, prop, &data->dedupe) != napi_ok) {
+                return "Dedupe must be a boolean";
+            }
+        }
+    }
+
+    return nullptr;
+}
+
+napi_value exportFrames(napi_env env, napi_callback_info info) {
+    size_t argc = 2;
+    napi_value args[2];
+    napi_status status = napi_get_cb_info(env, info, &argc, args, nullptr, nullptr);
+    CHECK_STATUS(env, status, "Failed to get callback info");
+
+    if (argc < 1) {
+        THROW_ERROR(env, "Expected at least 1 argument: Lottie JSON buffer");
+    }
+
+    BatchData* data = create_batch_data(env, nullptr, 0);
+    if (!data) {
+        THROW_ERROR(env, "Failed to allocate converter data");
+    }
+    const char* input_error = get_converter_input(env, args[0], data->base, true);
+    if (input_error) {
+        destroy_batch_data(data);
+        THROW_ERROR(env, input_error);
+    }
+
+    if (argc >= 2 && args[1] != nullptr) {
+        const char* error = parse_batch_options(env, args[1], data);
+        if (error) {
+            destroy_batch_data(data);
+            THROW_ERROR(env, error);
+        }
+    }
+
+    napi_value promise;
+    status = napi_create_promise(env, &data->base->deferred, &promise);
+    if (status != napi_ok) {
+        destroy_batch_data(data);
+        THROW_ERROR(env, "Failed to create promise");
+    }
+
+    status = queue_pool_work(env, execute_batch_work, complete_batch_work, abandon_batch_work, data, data->base->priority, data->base->cancel);
+    if (status != napi_ok) {
+        destroy_batch_data(data);
+        THROW_ERROR(env, "Failed to queue async work");
+    }
+
+    return promise;
+}
\ No newline at end of file
@@ -0,0 +1,43 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <napi.h>
+#include <vector>
+#include "converter.h"
+
+struct FrameResult {
+    byte* buffer;
+    size_t size;
+    // Index of the result holding this frame's data; differs from the frame's
+    // own index when it rendered identically to the frame before it or
+    // repeats an earlier request.
+    size_t source;
+};
+
+struct BatchData {
+    ConverterData* base;
+    bool use_range;
+    uint32_t range_start;
+    uint32_t range_end;
+    uint32_t range_step;
+    bool has_range_end;
+    // Resampling: the frames nearest to these times in milliseconds, or to
+    // every 1/sample_fps seconds of the animation when sample_fps is set.
+    std::vector<double> times;
+    double sample_fps;
+    std::vector<uint32_t> frames;
+    uint32_t concurrency;
+    bool dedupe;
+    std::vector<FrameResult> results;
+};
+
+BatchData* create_batch_data(napi_env env, const byte* in_data, size_t size);
+void destroy_batch_data(BatchData* data);
+// Parses an array of frame indices or a { start, end, step } range.
+const char* parse_frame_selection(napi_env env, napi_value value, BatchData* data);
+const char* parse_batch_options(napi_env env, napi_value options, BatchData* data);
+bool resolve_batch_frames(BatchData* data, size_t frame_count, double frame_rate);
+bool export_frames_sync(BatchData* data);
+napi_value exportFrames(napi_env env, napi_callback_info info);
+
+#endif // BATCH_H
\ No newline at end of file
@@ -0,0 +1,80 @@
+#include "buffer_pool.h"
+#include <atomic>
+#include <cstdlib>
+#include <vector>
+
+#define li_POOL_MAX_BUFFERS 4
+#define ll_POOL_MAX_BYTES (192u * 1024 * 1024)
+
+static std::atomic<uint64_t> pool_allocations(0);
+static std::atomic<uint64_t> pool_reuses(0);
+static std::atomic<uint64_t> pool_bytes(0);
+static std::atomic<uint64_t> output_allocations(0);
+
+struct PoolEntry {
+    uint8_t* data;
+    size_t size;
+};
+
+struct ThreadPool {
+    std::vector<PoolEntry> entries;
+    size_t bytes = 0;
+
+    ~ThreadPool() {
+        for (PoolEntry& entry : entries) {
+            free(entry.data);
+        }
+        pool_bytes -= bytes;
+    }
+};
+
+static thread_local ThreadPool thread_pool;
+
+ScratchBuffer::ScratchBuffer(size_t size) : data_(nullptr), size_(size) {
+    ThreadPool& pool = thread_pool;
+    for (size_t i = 0; i < pool.entries.size(); i++) {
+        if (pool.entries[i].size == size) {
+            data_ = pool.entries[i].data;
+            pool.entries.erase(pool.entries.begin() + i);
+            pool.bytes -= size;
+            pool_bytes -= size;
+            pool_reuses++;
+            return;
+        }
+    }
+
+    data_ = (uint8_t*)malloc(size ? size : 1);
+    if (data_) pool_allocations++;
+}
+
+ScratchBuffer::~ScratchBuffer() {
+    if (!data_) return;
+
+    ThreadPool& pool = thread_pool;
+    if (size_ > ll_POOL_MAX_BYTES) {
+        free(data_);
+        return;
+    }
+
+    // Make room by dropping the least recently returned buffers.
+    while (!pool.entries.empty() &&
+           (pool.entries.size() >= li_POOL_MAX_BUFFERS || pool.bytes + size_ > ll_POOL_MAX_BYTES)) {
+        PoolEntry& oldest = pool.entries.front();
+        pool.bytes -= oldest.size;
+        pool_bytes -= oldest.size;
+        free(oldest.data);
+        pool.entries.erase(pool.entries.begin());
+    }
+
+    pool.entries.push_back(PoolEntry{data_, size_});
+    pool.bytes += size_;
+    pool_bytes += size_;
+}
+
+void count_output_allocation() {
+    output_allocations++;
+}
+
+BufferPoolStats get_buffer_pool_stats() {
+    return BufferPoolStats{pool_allocations.load(), pool_reuses.load(), pool_bytes.load(), output_allocations.load()};
+}
\ No newline at end of file
@@ -0,0 +1,39 @@
+#ifndef BUFFER_POOL_H
+#define BUFFER_POOL_H
+
+#include <cstddef>
+#include <cstdint>
+
+struct BufferPoolStats {
+    uint64_t scratch_allocations;
+    uint64_t scratch_reuses;
+    uint64_t pooled_bytes;
+    uint64_t output_allocations;
+};
+
+// Scratch memory (render surfaces, conversion buffers, row pointers) recycled
+// through a small per-thread free list. Buffers are matched by exact byte size,
+// which in practice means by resolution, since a thread tends to render the
+// same size repeatedly.
+class ScratchBuffer {
+public:
+    explicit ScratchBuffer(size_t size);
+    ~ScratchBuffer();
+    ScratchBuffer(const ScratchBuffer&) = delete;
+    ScratchBuffer& operator=(const ScratchBuffer&) = delete;
+
+    uint8_t* data() const { return data_; }
+    uint32_t* pixels() const { return reinterpret_cast<uint32_t*>(data_); }
+    size_t size() const { return size_; }
+    explicit operator bool() const { return data_ != nullptr; }
+
+private:
+    uint8_t* data_;
+    size_t size_;
+};
+
+BufferPoolStats get_buffer_pool_stats();
+// Counts a malloc/realloc of an encoder output buffer that is handed to JS.
+void count_output_allocation();
+
+#endif // BUFFER_POOL_H
\ No newline at end of file
@@ -1,42 +1,118 @@
 #include "converter.h"
 #include "animation.h"
+#include "animation_cache.h"
+#include "buffer_pool.h"
+#include "hash.h"
+#include "pixel.h"
 #include "png_writer.h"
+#include "qoi_writer.h"
+#include "utils.h"
+#include <cstdio>
 #include <cstring>
 
 #define lp_COLOR_BYTES 4
 #define li_MAX_DIMENSION 4096
-#define DEFAULT_QUALITY 100
+#define DEFAULT_COMPRESSION_LEVEL 1
 #define DEFAULT_WIDTH 100
 #define DEFAULT_HEIGHT 100
 #define DEFAULT_FRAME 0
 
+int quality_to_compression_level(uint32_t quality) {
+    return (int)((1.0f - quality / 100.0f) * 9);
+}
+
 ConverterData* create_converter_data(napi_env env, const byte* in_data, size_t size) {
     ConverterData* data = new ConverterData();
 
     data->env = env;
     data->deferred = nullptr;
-    data->in_data = (byte*)malloc(size);
-    if (!data->in_data) {
-        delete data;
-        return nullptr;
-    }
-    memcpy(data->in_data, in_data, size);
+    data->priority = JOB_PRIORITY_NORMAL;
+    // Replaced by the caller's token when it passes a signal. Every job has
+    // one, so that the pool can stop it when its environment exits.
+    data->cancel = std::make_shared<CancelToken>();
+    data->in_data = in_data;
     data->in_size = size;
+    data->in_ref = nullptr;
     data->width = DEFAULT_WIDTH;
     data->height = DEFAULT_HEIGHT;
-    data->quality = DEFAULT_QUALITY / 100.0f;
+    // Not the level 0 that quality 100 maps to: a stored PNG of flat art is
+    // some 60 times larger and no faster to write than level 1.
+    data->png.compression_level = DEFAULT_COMPRESSION_LEVEL;
+    data->png.filter = PNG_FILTER_MODE_ADAPTIVE;
+    data->png.strategy = PNG_STRATEGY_DEFAULT;
+    data->png.threads = 1;
+    data->png.fast = false;
+    data->format = OUTPUT_PNG;
     data->frame = DEFAULT_FRAME;
+    data->frame_address = FRAME_ADDRESS_INDEX;
+    data->frame_position = 0;
     data->result_buffer = nullptr;
     data->result_size = 0;
     data->success = false;
     data->error_msg = "";
+    data->target_data = nullptr;
+    data->target_size = 0;
+    data->target_ref = nullptr;
+    data->report_timings = false;
+    data->share_cached = false;
+    data->queued_at_ns = 0;
+    data->timings = FrameTimings();
+    data->viewport = RenderViewport();
+    data->viewport.scale = 1;
     return data;
 }
 
+bool retain_converter_input(ConverterData* data, napi_value buffer) {
+    return napi_create_reference(data->env, buffer, 1, &data->in_ref) == napi_ok;
+}
+
+const char* get_converter_input(napi_env env, napi_value input, ConverterData* data, bool retain) {
+    bool is_buffer = false;
+    napi_status status = napi_is_buffer(env, input, &is_buffer);
+    if (status == napi_ok && is_buffer) {
+        byte* in_data;
+        size_t in_size;
+        status = napi_get_buffer_info(env, input, (void**)&in_data, &in_size);
+        if (status != napi_ok) {
+            return "Failed to get buffer info from Lottie JSON argument";
+        }
+        data->in_data = in_data;
+        data->in_size = in_size;
+        if (retain && !retain_converter_input(data, input)) {
+            return "Failed to reference Lottie JSON argument";
+        }
+        return nullptr;
+    }
+
+    std::string path;
+    napi_valuetype input_type;
+    napi_value prop;
+    if (napi_typeof(env, input, &input_type) != napi_ok || input_type != napi_object ||
+        napi_get_named_property(env, input, "path", &prop) != napi_ok || !get_string_value(env, prop, path) ||
+        path.empty()) {
+        return "Input must be a Buffer or an object with a path string";
+    }
+    data->in_data = nullptr;
+    data->in_size = 0;
+    data->in_path = path;
+    return nullptr;
+}
+
+bool open_converter_input(ConverterData* data) {
+    if (data->in_path.empty() || data->in_file.is_open()) return true;
+    if (!data->in_file.open(data->in_path, data->error_msg)) return false;
+    data->in_data = data->in_file.data();
+    data->in_size = data->in_file.size();
+    return true;
+}
+
 void destroy_converter_data(ConverterData* data) {
     if (data) {
-        if (data->in_data) {
-            free(data->in_data);
+        if (data->in_ref) {
+            napi_delete_reference(data->env, data->in_ref);
+        }
+        if (data->target_ref) {
+            napi_delete_reference(data->env, data->target_ref);
         }
         if (data->result_buffer) {
             free(data->result_buffer);
@@ -45,29 +121,283 @@ void destroy_converter_data(ConverterData* data) {
     }
 }
 
-bool convert_to_png_sync(ConverterData* data) {
-    std::string json_data(reinterpret_cast<char*>(data->in_data), data->in_size);
-    std::unique_ptr<rlottie::Animation> animation = load_animation_from_data(json_data);
-    if (!animation) {
-        data->error_msg = "Failed to load Lottie animation from provided JSON data";
+void drop_converter_refs(ConverterData* data) {
+    data->in_ref = nullptr;
+    data->target_ref = nullptr;
+}
+
+uint32_t resolve_frame_address(const ConverterData* data, size_t total_frames, double frame_rate) {
+    switch (data->frame_address) {
+        case FRAME_ADDRESS_TIME:
+            return (uint32_t)frame_at_time(total_frames, frame_rate, data->frame_position);
+        case FRAME_ADDRESS_PROGRESS:
+            return (uint32_t)frame_at_progress(total_frames, data->frame_position);
+        default:
+            return data->frame;
+    }
+}
+
+bool parse_output_format(const std::string& name, OutputFormat* format, PngOptions* png) {
+    if (name == "png" || name == "png-fast") {
+        *format = OUTPUT_PNG;
+    } else if (name == "qoi") {
+        *format = OUTPUT_QOI;
+    } else if (name == "rgba") {
+        *format = OUTPUT_RGBA;
+    } else if (name == "bgra") {
+        *format = OUTPUT_BGRA;
+    } else if (name == "argb-premul") {
+        *format = OUTPUT_ARGB_PREMUL;
+    } else if (name == "apng") {
+        *format = OUTPUT_APNG;
+    } else {
+        return false;
+    }
+    png->fast = name == "png-fast";
+    return true;
+}
+
+bool parse_png_filter(const std::string& name, PngFilterMode* filter) {
+    if (name == "adaptive") {
+        *filter = PNG_FILTER_MODE_ADAPTIVE;
+    } else if (name == "none") {
+        *filter = PNG_FILTER_MODE_NONE;
+    } else if (name == "sub") {
+        *filter = PNG_FILTER_MODE_SUB;
+    } else if (name == "up") {
+        *filter = PNG_FILTER_MODE_UP;
+    } else if (name == "average") {
+        *filter = PNG_FILTER_MODE_AVERAGE;
+    } else if (name == "paeth") {
+        *filter = PNG_FILTER_MODE_PAETH;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+bool parse_png_strategy(const std::string& name, PngStrategy* strategy) {
+    if (name == "default") {
+        *strategy = PNG_STRATEGY_DEFAULT;
+    } else if (name == "filtered") {
+        *strategy = PNG_STRATEGY_FILTERED;
+    } else if (name == "huffman") {
+        *strategy = PNG_STRATEGY_HUFFMAN;
+    } else if (name == "rle") {
+        *strategy = PNG_STRATEGY_RLE;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+void convert_raw_pixels(const uint32_t* src, byte* dst, size_t count, OutputFormat format) {
+    switch (format) {
+        case OUTPUT_RGBA:
+            premultiplied_argb_to_rgba(src, dst, count);
+            break;
+        case OUTPUT_BGRA:
+            premultiplied_argb_to_bgra(src, dst, count);
+            break;
+        default:
+            if (reinterpret_cast<const byte*>(src) != dst) memcpy(dst, src, count * lp_COLOR_BYTES);
+            break;
+    }
+}
+
+bool encode_frame(const uint32_t* pixels, int width, int height, const PngOptions& png, OutputFormat format,
+                  byte** out_buffer, size_t* out_size, std::string& error_msg) {
+    if (format == OUTPUT_PNG) {
+        return encode_png(pixels, width, height, png, out_buffer, out_size, error_msg);
+    }
+    if (format == OUTPUT_QOI) {
+        return encode_qoi(pixels, width, height, out_buffer, out_size, error_msg);
+    }
+
+    size_t size = (size_t)width * height * lp_COLOR_BYTES;
+    byte* buffer = (byte*)malloc(size);
+    if (!buffer) {
+        error_msg = "Failed to allocate pixel buffer";
+        return false;
+    }
+    count_output_allocation();
+    convert_raw_pixels(pixels, buffer, (size_t)width * height, format);
+    *out_buffer = buffer;
+    *out_size = size;
+    return true;
+}
+
+// The render stage starts once the lock is held, so time spent waiting on
+// another render of the same handle only shows up in the total. Viewport
+// renders load their own wrapper animations and need no lock.
+static bool render_pixels(ConverterData* data, uint32_t* pixels) {
+    if (data->viewport.enabled) {
+        return render_viewport_frame(data, pixels, data->width);
+    }
+
+    rlottie::Surface surface(pixels, data->width, data->height, data->width * lp_COLOR_BYTES);
+    std::lock_guard<std::mutex> lock(data->animation->mutex);
+    uint64_t start = metrics_now_ns();
+    render_frame_sync(data->animation->animation, data->frame, surface);
+    data->timings.stage_ns[METRIC_STAGE_RENDER] = metrics_now_ns() - start;
+    return true;
+}
+
+static void convert_timed(ConverterData* data, const uint32_t* pixels, byte* output, size_t count) {
+    uint64_t start = metrics_now_ns();
+    convert_raw_pixels(pixels, output, count, data->format);
+    data->timings.stage_ns[METRIC_STAGE_ENCODE] = metrics_now_ns() - start;
+}
+
+// Raw frames are rendered straight into the memory handed to JS and converted
+// in place, so they cost one rasterization and one pass over the pixels.
+static bool convert_to_raw_sync(ConverterData* data) {
+    size_t count = (size_t)data->width * data->height;
+    byte* output = data->target_data;
+    if (!output) {
+        output = (byte*)malloc(count * lp_COLOR_BYTES);
+        if (!output) {
+            data->error_msg = "Failed to allocate pixel buffer (width: " + std::to_string(data->width) + ", height: " + std::to_string(data->height) + ")";
+            return false;
+        }
+        count_output_allocation();
+        data->result_buffer = output;
+        data->result_size = count * lp_COLOR_BYTES;
+    }
+
+    if (reinterpret_cast<uintptr_t>(output) % alignof(uint32_t) == 0) {
+        uint32_t* pixels = reinterpret_cast<uint32_t*>(output);
+        if (!render_pixels(data, pixels)) return false;
+        convert_timed(data, pixels, output, count);
+        return true;
+    }
+
+    // rlottie writes whole words, so a target view at an odd offset goes
+    // through a scratch surface.
+    ScratchBuffer buffer(count * lp_COLOR_BYTES);
+    if (!buffer) {
+        data->error_msg = "Failed to allocate frame buffer (width: " + std::to_string(data->width) + ", height: " + std::to_string(data->height) + ")";
         return false;
     }
+    if (!render_pixels(data, buffer.pixels())) return false;
+    convert_timed(data, buffer.pixels(), output, count);
+    return true;
+}
 
-    size_t frame_count = get_total_frames(animation);
-    if (data->frame >= frame_count) {
-        data->error_msg = "Frame index out of range (total frames: " + std::to_string(frame_count) + ")";
+static bool convert_frame_stages(ConverterData* data) {
+    if (is_cancelled(data->cancel)) {
+        data->error_msg = ls_ABORTED_MESSAGE;
         return false;
     }
+    if (!open_converter_input(data)) return false;
+    if (!data->viewport.enabled) {
+        if (!data->animation) {
+            uint64_t start = metrics_now_ns();
+            data->animation = load_cached_animation(data->in_data, data->in_size, data->resource_path, data->animation_id, data->error_msg);
+            data->timings.stage_ns[METRIC_STAGE_PARSE] = metrics_now_ns() - start;
+            if (!data->animation) return false;
+        }
 
-    std::unique_ptr<uint32_t[]> buffer = std::unique_ptr<uint32_t[]>(new (std::nothrow) uint32_t[data->width * data->height]);
+        size_t frame_count = data->animation->total_frames;
+        data->frame = resolve_frame_address(data, frame_count, data->animation->frame_rate);
+        if (data->frame >= frame_count) {
+            data->error_msg = "Frame index out of range (total frames: " + std::to_string(frame_count) + ")";
+            return false;
+        }
+    }
+
+    if (is_raw_format(data->format)) {
+        return convert_to_raw_sync(data);
+    }
+
+    ScratchBuffer buffer((size_t)data->width * data->height * lp_COLOR_BYTES);
     if (!buffer) {
         data->error_msg = "Failed to allocate frame buffer (width: " + std::to_string(data->width) + ", height: " + std::to_string(data->height) + ")";
         return false;
     }
 
-    rlottie::Surface surface(buffer.get(), data->width, data->height, data->width * lp_COLOR_BYTES);
-    render_frame_sync(animation, data->frame, surface);
+    if (!render_pixels(data, buffer.pixels())) return false;
+    if (is_cancelled(data->cancel)) {
+        data->error_msg = ls_ABORTED_MESSAGE;
+        return false;
+    }
+
+    uint64_t start = metrics_now_ns();
+    bool success = encode_frame(buffer.pixels(), data->width, data->height, data->png, data->format,
+                                &data->result_buffer, &data->result_size, data->error_msg);
+    data->timings.stage_ns[METRIC_STAGE_ENCODE] = metrics_now_ns() - start;
+    return success;
+}
+
+static void append_key_string(std::string& key, const std::string& value) {
+    key += std::to_string(value.size());
+    key += ':';
+    key += value;
+}
+
+// Everything that changes the output bytes. PNG threads and tile sizes only
+// change how the work is split, so they are left out. Frames addressed by time
+// or progress are keyed by that address, which avoids loading the animation on
+// a hit.
+static std::string frame_cache_key(const ConverterData* data) {
+    const RenderViewport& viewport = data->viewport;
+    char options[512];
+    snprintf(options, sizeof(options), "%016llx:%zu:%d:%d:%d:%d:%d:%d:%d:%d:%u:%.17g:%d:%d:%d:%.17g:%.17g:%.17g:%.17g:%.17g:",
+             (unsigned long long)hash_bytes(data->in_data, data->in_size), data->in_size, (int)data->format,
+             data->width, data->height, data->png.compression_level, (int)data->png.filter, (int)data->png.strategy,
+             (int)data->png.fast, (int)data->frame_address, data->frame, data->frame_position, (int)viewport.enabled,
+             viewport.canvas_width, viewport.canvas_height, viewport.x, viewport.y, viewport.width,
+             viewport.height, viewport.scale);
+    std::string key = options;
+    append_key_string(key, data->resource_path);
+    append_key_string(key, data->animation_id);
+    return key;
+}
+
+// Single-frame exports from input bytes go through the frame cache when it is
+// enabled. Renders into a target or from a loaded handle always run.
+static bool convert_frame_cached(ConverterData* data) {
+    if (!open_converter_input(data)) return false;
+    std::string key = frame_cache_key(data);
+    bool cancelled;
+    std::shared_ptr<const CachedFrame> frame = acquire_cached_frame(key, data->cancel, &cancelled);
+    if (cancelled) {
+        data->error_msg = ls_ABORTED_MESSAGE;
+        return false;
+    }
+    if (frame) {
+        data->cached_result = frame;
+        data->result_size = frame->size;
+        return true;
+    }
+
+    bool success = convert_frame_stages(data);
+    if (success) {
+        // The new entry takes the result over, so the caller gets the same
+        // memory the cache keeps.
+        frame = std::make_shared<const CachedFrame>(data->result_buffer, data->result_size);
+        data->result_buffer = nullptr;
+        data->cached_result = frame;
+    }
+    finish_cached_frame(key, frame);
+    return success;
+}
+
+bool convert_frame_sync(ConverterData* data) {
+    FrameTimings& timings = data->timings;
+    begin_frame_metrics();
+    uint64_t start = metrics_now_ns();
+    if (data->queued_at_ns) {
+        timings.stage_ns[METRIC_STAGE_QUEUE] = start - data->queued_at_ns;
+    }
+
+    bool cacheable = !data->target_ref && !data->animation && frame_cache_enabled();
+    bool success = cacheable ? convert_frame_cached(data) : convert_frame_stages(data);
 
-    bool success = write_png(data, buffer.get());
+    timings.stage_ns[METRIC_STAGE_TOTAL] = metrics_now_ns() - start;
+    timings.input_bytes = data->in_size;
+    timings.surface_bytes = (size_t)data->width * data->height * lp_COLOR_BYTES;
+    timings.output_bytes = data->target_ref ? timings.surface_bytes : data->result_size;
+    end_frame_metrics(timings, success);
     return success;
 }
\ No newline at end of file
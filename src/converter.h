@@ -2,27 +2,146 @@
 #define CONVERTER_H
 
 #include <napi.h>
+#include <memory>
 #include <string>
+#include "animation.h"
+#include "frame_cache.h"
+#include "mapped_file.h"
+#include "metrics.h"
+#include "viewport.h"
+#include "worker_pool.h"
 
 typedef uint8_t byte;
 
+// Raw formats are 4 bytes per pixel, rows packed. "argb-premul" is rlottie's
+// own output: premultiplied ARGB32 words in native byte order. QOI is a fast
+// lossless image format with straight alpha. APNG is only produced by
+// exportAnimation.
+enum OutputFormat {
+    OUTPUT_PNG,
+    OUTPUT_RGBA,
+    OUTPUT_BGRA,
+    OUTPUT_ARGB_PREMUL,
+    OUTPUT_QOI,
+    OUTPUT_APNG
+};
+
+enum PngFilterMode {
+    PNG_FILTER_MODE_ADAPTIVE,
+    PNG_FILTER_MODE_NONE,
+    PNG_FILTER_MODE_SUB,
+    PNG_FILTER_MODE_UP,
+    PNG_FILTER_MODE_AVERAGE,
+    PNG_FILTER_MODE_PAETH
+};
+
+enum PngStrategy {
+    PNG_STRATEGY_DEFAULT,
+    PNG_STRATEGY_FILTERED,
+    PNG_STRATEGY_HUFFMAN,
+    PNG_STRATEGY_RLE
+};
+
+// How a single frame is addressed. Times and progress are turned into a frame
+// index by resolve_frame_address once the animation is loaded.
+enum FrameAddress {
+    FRAME_ADDRESS_INDEX,
+    FRAME_ADDRESS_TIME,
+    FRAME_ADDRESS_PROGRESS
+};
+
+struct PngOptions {
+    int compression_level;
+    PngFilterMode filter;
+    PngStrategy strategy;
+    // Frames large enough are split into row strips that are filtered and
+    // deflated on this many threads.
+    size_t threads;
+    // "png-fast": sub filter and a run-length-only deflate of our own instead
+    // of zlib; the level, filter and strategy above are ignored.
+    bool fast;
+};
+
 struct ConverterData {
     napi_env env;
     napi_deferred deferred;
-    byte* in_data;
+    JobPriority priority;
+    std::shared_ptr<CancelToken> cancel;
+    const byte* in_data;
     size_t in_size;
+    napi_ref in_ref;
+    // File input: in_data and in_size point into in_file once
+    // open_converter_input has mapped in_path on the worker.
+    std::string in_path;
+    MappedFile in_file;
     int width;
     int height;
-    float quality;
+    PngOptions png;
+    OutputFormat format;
     uint32_t frame;
+    FrameAddress frame_address;
+    // Milliseconds for FRAME_ADDRESS_TIME, 0-1 for FRAME_ADDRESS_PROGRESS.
+    double frame_position;
     byte* result_buffer;
     size_t result_size;
+    // Set instead of result_buffer when the result lives in the frame cache.
+    // JS gets a copy of it, or a view when share_cached opts into one.
+    std::shared_ptr<const CachedFrame> cached_result;
+    bool share_cached;
     std::string error_msg;
     bool success;
+    std::string resource_path;
+    // Which animation of a dotLottie archive to load; empty for the first.
+    std::string animation_id;
+    std::shared_ptr<AnimationHandle> animation;
+    // Caller-supplied memory that raw frames are rendered into instead of
+    // result_buffer; target_ref keeps its backing store alive.
+    byte* target_data;
+    size_t target_size;
+    napi_ref target_ref;
+    // Set when the frame is a region or rescale of the width x height canvas,
+    // or too large for one render; width and height then hold the output size.
+    RenderViewport viewport;
+    // Stage timings are always collected for getStats; report_timings only
+    // attaches them to the result. queued_at_ns is 0 for synchronous calls.
+    bool report_timings;
+    uint64_t queued_at_ns;
+    FrameTimings timings;
 };
 
+// The input is borrowed, not copied. Work that outlives the current call must
+// keep the JS buffer alive with retain_converter_input.
 ConverterData* create_converter_data(napi_env env, const byte* in_data, size_t size);
+bool retain_converter_input(ConverterData* data, napi_value buffer);
+// Reads the animation argument of an export: a Buffer, borrowed and, with
+// `retain`, kept alive for async work; or a { path } object whose file is
+// mapped later by open_converter_input.
+const char* get_converter_input(napi_env env, napi_value input, ConverterData* data, bool retain);
+// Maps the input file, if any. Call on the thread that decodes the input.
+bool open_converter_input(ConverterData* data);
 void destroy_converter_data(ConverterData* data);
-bool convert_to_png_sync(ConverterData* data);
+// Forgets the JS references of data whose environment has exited; they die
+// with the environment and must not be deleted. Call before destroying it.
+void drop_converter_refs(ConverterData* data);
+// Legacy mapping of the 1-100 quality option onto a zlib level (100 -> 0).
+int quality_to_compression_level(uint32_t quality);
+// The frame index data addresses in an animation with this metadata.
+uint32_t resolve_frame_address(const ConverterData* data, size_t total_frames, double frame_rate);
+// Raw formats are written straight from the render surface; the others are
+// encoded into a new buffer.
+inline bool is_raw_format(OutputFormat format) {
+    return format == OUTPUT_RGBA || format == OUTPUT_BGRA || format == OUTPUT_ARGB_PREMUL;
+}
+// Sets png->fast for "png-fast", which is PNG output from the fast encoder.
+bool parse_output_format(const std::string& name, OutputFormat* format, PngOptions* png);
+bool parse_png_filter(const std::string& name, PngFilterMode* filter);
+bool parse_png_strategy(const std::string& name, PngStrategy* strategy);
+// Writes premultiplied ARGB32 pixels in a raw output format. src and dst may
+// be the same memory.
+void convert_raw_pixels(const uint32_t* src, byte* dst, size_t count, OutputFormat format);
+// Encodes a rendered frame into a new malloc'd buffer in the given format.
+bool encode_frame(const uint32_t* pixels, int width, int height, const PngOptions& png, OutputFormat format,
+                  byte** out_buffer, size_t* out_size, std::string& error_msg);
+bool convert_frame_sync(ConverterData* data);
 
 #endif // CONVERTER_H
\ No newline at end of file
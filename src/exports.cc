@@ -1,19 +1,430 @@
 #include "converter.h"
+#include "animation_cache.h"
+#include "buffer_pool.h"
 #include "utils.h"
+#include <cmath>
 
+#define lp_COLOR_BYTES 4
 #define li_MAX_DIMENSION 4096
+#define li_MAX_CANVAS_DIMENSION 16384
+#define li_MIN_TILE_SIZE 64
+#define ld_MAX_SCALE 16.0
+#define li_MAX_COMPRESSION_THREADS 64
+#define li_MAX_POOL_THREADS 64
+
+static void finalize_cancel_token(napi_env env, void* data, void* hint) {
+    delete static_cast<std::shared_ptr<CancelToken>*>(data);
+}
+
+static std::shared_ptr<CancelToken>* get_cancel_token(napi_env env, napi_value value) {
+    napi_valuetype value_type;
+    void* token = nullptr;
+    if (napi_typeof(env, value, &value_type) != napi_ok || value_type != napi_external ||
+        napi_get_value_external(env, value, &token) != napi_ok) {
+        return nullptr;
+    }
+    return static_cast<std::shared_ptr<CancelToken>*>(token);
+}
+
+static bool get_number_property(napi_env env, napi_value object, const char* key, double* value) {
+    napi_value prop;
+    return napi_get_named_property(env, object, key, &prop) == napi_ok && napi_get_value_double(env, prop, value) == napi_ok;
+}
+
+static const char* parse_viewport(napi_env env, napi_value value, RenderViewport* viewport) {
+    napi_valuetype value_type;
+    if (napi_typeof(env, value, &value_type) != napi_ok || value_type != napi_object) {
+        return "Viewport must be an object with x, y, width and height";
+    }
+    if (!get_number_property(env, value, "x", &viewport->x) || !get_number_property(env, value, "y", &viewport->y) ||
+        !get_number_property(env, value, "width", &viewport->width) ||
+        !get_number_property(env, value, "height", &viewport->height)) {
+        return "Viewport must be an object with x, y, width and height";
+    }
+    if (!(viewport->x >= 0) || !(viewport->y >= 0) || !(viewport->width > 0) || !(viewport->height > 0)) {
+        return "Viewport must have a non-negative position and a positive size";
+    }
+    return nullptr;
+}
+
+// Turns width x height into the canvas of a viewport render and sets the
+// output size. Plain frames up to li_MAX_DIMENSION keep the direct path.
+static const char* resolve_viewport(ConverterData* data, bool has_viewport) {
+    RenderViewport& viewport = data->viewport;
+    viewport.canvas_width = data->width;
+    viewport.canvas_height = data->height;
+    if (has_viewport) {
+        if (viewport.x + viewport.width > data->width || viewport.y + viewport.height > data->height) {
+            return "Viewport must lie within the width x height canvas";
+        }
+    } else {
+        viewport.x = 0;
+        viewport.y = 0;
+        viewport.width = data->width;
+        viewport.height = data->height;
+    }
+
+    double width = viewport.width * viewport.scale + 0.5;
+    double height = viewport.height * viewport.scale + 0.5;
+    if (width < 1 || height < 1 || width >= li_MAX_CANVAS_DIMENSION + 1 || height >= li_MAX_CANVAS_DIMENSION + 1) {
+        return "Output size must be between 1 and 16384";
+    }
+    data->width = (int)width;
+    data->height = (int)height;
+    viewport.enabled = has_viewport || viewport.scale != 1 || viewport.tile_size != 0 ||
+                       data->width > li_MAX_DIMENSION || data->height > li_MAX_DIMENSION;
+    return nullptr;
+}
+
+const char* parse_converter_options(napi_env env, napi_value options, ConverterData* data) {
+    napi_valuetype arg_type;
+    napi_status status = napi_typeof(env, options, &arg_type);
+    if (status != napi_ok) return "Failed to get type of options argument";
+
+    if (arg_type == napi_object) {
+        napi_value prop;
+
+        if (has_own_property(env, options, "frame")) {
+            status = napi_get_named_property(env, options, "frame", &prop);
+            if (status == napi_ok) {
+                uint32_t frame;
+                status = napi_get_value_uint32(env, prop, &frame);
+                if (status != napi_ok) {
+                    return "Frame must be a valid integer";
+                }
+                data->frame = frame;
+            }
+        }
+
+        if (has_own_property(env, options, "time")) {
+            status = napi_get_named_property(env, options, "time", &prop);
+            if (status == napi_ok) {
+                double time;
+                status = napi_get_value_double(env, prop, &time);
+                if (status != napi_ok || !(time >= 0) || !std::isfinite(time)) {
+                    return "Time must be a non-negative number of milliseconds";
+                }
+                data->frame_address = FRAME_ADDRESS_TIME;
+                data->frame_position = time;
+            }
+        }
+
+        if (has_own_property(env, options, "progress")) {
+            status = napi_get_named_property(env, options, "progress", &prop);
+            if (status == napi_ok) {
+                double progress;
+                status = napi_get_value_double(env, prop, &progress);
+                if (status != napi_ok || !(progress >= 0) || progress > 1) {
+                    return "Progress must be a number between 0 and 1";
+                }
+                if (data->frame_address == FRAME_ADDRESS_TIME) {
+                    return "Only one of frame, time and progress can be given";
+                }
+                data->frame_address = FRAME_ADDRESS_PROGRESS;
+                data->frame_position = progress;
+            }
+        }
+
+        if (data->frame_address != FRAME_ADDRESS_INDEX && has_own_property(env, options, "frame")) {
+            return "Only one of frame, time and progress can be given";
+        }
+
+        if (has_own_property(env, options, "width")) {
+            status = napi_get_named_property(env, options, "width", &prop);
+            if (status == napi_ok) {
+                uint32_t width;
+                status = napi_get_value_uint32(env, prop, &width);
+                if (status != napi_ok) {
+                    return "Width must be a valid integer";
+                }
+                if (width == 0 || width > li_MAX_CANVAS_DIMENSION) {
+                    return "Width must be between 1 and 16384";
+                }
+                data->width = width;
+            }
+        }
+
+        if (has_own_property(env, options, "height")) {
+            status = napi_get_named_property(env, options, "height", &prop);
+            if (status == napi_ok) {
+                uint32_t height;
+                status = napi_get_value_uint32(env, prop, &height);
+                if (status != napi_ok) {
+                    return "Height must be a valid integer";
+                }
+                if (height == 0 || height > li_MAX_CANVAS_DIMENSION) {
+                    return "Height must be between 1 and 16384";
+                }
+                data->height = height;
+            }
+        }
+
+        if (has_own_property(env, options, "quality")) {
+            status = napi_get_named_property(env, options, "quality", &prop);
+            if (status == napi_ok) {
+                uint32_t quality;
+                status = napi_get_value_uint32(env, prop, &quality);
+                if (status != napi_ok) {
+                    return "Quality must be a valid integer";
+                }
+                if (quality < 1 || quality > 100) {
+                    return "Quality must be between 1 and 100";
+                }
+                data->png.compression_level = quality_to_compression_level(quality);
+            }
+        }
+
+        if (has_own_property(env, options, "compressionLevel")) {
+            status = napi_get_named_property(env, options, "compressionLevel", &prop);
+            if (status == napi_ok) {
+                uint32_t level;
+                status = napi_get_value_uint32(env, prop, &level);
+                if (status != napi_ok || level > 9) {
+                    return "Compression level must be an integer between 0 and 9";
+                }
+                data->png.compression_level = (int)level;
+            }
+        }
+
+        if (has_own_property(env, options, "filter")) {
+            status = napi_get_named_property(env, options, "filter", &prop);
+            if (status == napi_ok) {
+                std::string filter;
+                if (!get_string_value(env, prop, filter) || !parse_png_filter(filter, &data->png.filter)) {
+                    return "Filter must be one of 'none', 'sub', 'up', 'average', 'paeth' or 'adaptive'";
+                }
+            }
+        }
+
+        if (has_own_property(env, options, "strategy")) {
+            status = napi_get_named_property(env, options, "strategy", &prop);
+            if (status == napi_ok) {
+                std::string strategy;
+                if (!get_string_value(env, prop, strategy) || !parse_png_strategy(strategy, &data->png.strategy)) {
+                    return "Strategy must be one of 'default', 'filtered', 'huffman' or 'rle'";
+                }
+            }
+        }
+
+        if (has_own_property(env, options, "compressionThreads")) {
+            status = napi_get_named_property(env, options, "compressionThreads", &prop);
+            if (status == napi_ok) {
+                uint32_t threads;
+                status = napi_get_value_uint32(env, prop, &threads);
+                if (status != napi_ok || threads < 1 || threads > li_MAX_COMPRESSION_THREADS) {
+                    return "Compression threads must be between 1 and 64";
+                }
+                data->png.threads = threads;
+            }
+        }
+
+        if (has_own_property(env, options, "resourcePath")) {
+            status = napi_get_named_property(env, options, "resourcePath", &prop);
+            if (status == napi_ok) {
+                if (!get_string_value(env, prop, data->resource_path)) {
+                    return "Resource path must be a string";
+                }
+            }
+        }
+
+        if (has_own_property(env, options, "priority")) {
+            status = napi_get_named_property(env, options, "priority", &prop);
+            if (status == napi_ok) {
+                std::string priority;
+                if (!get_string_value(env, prop, priority) || !parse_job_priority(priority, &data->priority)) {
+                    return "Priority must be one of 'high', 'normal' or 'low'";
+                }
+            }
+        }
+
+        if (has_own_property(env, options, "cancelToken")) {
+            status = napi_get_named_property(env, options, "cancelToken", &prop);
+            if (status == napi_ok) {
+                std::shared_ptr<CancelToken>* token = get_cancel_token(env, prop);
+                if (!token) return "Cancel token must be a handle from createCancelToken";
+                data->cancel = *token;
+            }
+        }
+
+        if (has_own_property(env, options, "animationId")) {
+            status = napi_get_named_property(env, options, "animationId", &prop);
+            if (status == napi_ok) {
+                if (!get_string_value(env, prop, data->animation_id)) {
+                    return "Animation ID must be a string";
+                }
+            }
+        }
+
+        if (has_own_property(env, options, "format")) {
+            status = napi_get_named_property(env, options, "format", &prop);
+            if (status == napi_ok) {
+                std::string name;
+                OutputFormat format;
+                if (!get_string_value(env, prop, name) || !parse_output_format(name, &format, &data->png)) {
+                    return "Format must be one of 'png', 'png-fast', 'qoi', 'rgba', 'bgra', 'argb-premul' or 'apng'";
+                }
+                // Animated output is decided by the entry point, not the option.
+                if ((format == OUTPUT_APNG) != (data->format == OUTPUT_APNG)) {
+                    return data->format == OUTPUT_APNG ? "Animation format must be 'apng'" : "Format 'apng' is only supported by exportAnimation";
+                }
+                data->format = format;
+            }
+        }
+
+        bool has_viewport = has_own_property(env, options, "viewport");
+        if (has_viewport) {
+            status = napi_get_named_property(env, options, "viewport", &prop);
+            if (status == napi_ok) {
+                const char* error = parse_viewport(env, prop, &data->viewport);
+                if (error) return error;
+            }
+        }
+
+        if (has_own_property(env, options, "scale")) {
+            status = napi_get_named_property(env, options, "scale", &prop);
+            if (status == napi_ok) {
+                double scale;
+                status = napi_get_value_double(env, prop, &scale);
+                if (status != napi_ok || !(scale > 0) || scale > ld_MAX_SCALE) {
+                    return "Scale must be a number greater than 0 and at most 16";
+                }
+                data->viewport.scale = scale;
+            }
+        }
+
+        if (has_own_property(env, options, "tileSize")) {
+            status = napi_get_named_property(env, options, "tileSize", &prop);
+            if (status == napi_ok) {
+                uint32_t tile_size;
+                status = napi_get_value_uint32(env, prop, &tile_size);
+                if (status != napi_ok || tile_size < li_MIN_TILE_SIZE || tile_size > li_MAX_DIMENSION) {
+                    return "Tile size must be an integer between 64 and 4096";
+                }
+                data->viewport.tile_size = (int)tile_size;
+            }
+        }
+
+        const char* viewport_error = resolve_viewport(data, has_viewport);
+        if (viewport_error) return viewport_error;
+
+        if (has_own_property(env, options, "shareCached")) {
+            status = napi_get_named_property(env, options, "shareCached", &prop);
+            if (status == napi_ok) {
+                if (napi_get_value_bool(env, prop, &data->share_cached) != napi_ok) {
+                    return "Share cached must be a boolean";
+                }
+            }
+        }
+
+        if (has_own_property(env, options, "timings")) {
+            status = napi_get_named_property(env, options, "timings", &prop);
+            if (status == napi_ok) {
+                if (napi_get_value_bool(env, prop, &data->report_timings) != napi_ok) {
+                    return "Timings must be a boolean";
+                }
+            }
+        }
+
+        if (has_own_property(env, options, "target")) {
+            status = napi_get_named_property(env, options, "target", &prop);
+            if (status == napi_ok) {
+                void* target_data;
+                if (!get_byte_view(env, prop, &target_data, &data->target_size)) {
+                    return "Target must be a Buffer, TypedArray, DataView or ArrayBuffer";
+                }
+                data->target_data = static_cast<byte*>(target_data);
+                if (napi_create_reference(env, prop, 1, &data->target_ref) != napi_ok) {
+                    return "Failed to reference target argument";
+                }
+            }
+        }
+
+        if (data->target_ref) {
+            if (!is_raw_format(data->format)) {
+                return "Target requires a raw pixel format";
+            }
+            if (data->target_size < (size_t)data->width * data->height * lp_COLOR_BYTES) {
+                return "Target is too small for the requested frame size";
+            }
+        }
+    } else if (arg_type != napi_undefined && arg_type != napi_null) {
+        return "Options argument must be an object";
+    }
+
+    return nullptr;
+}
+
+static napi_status attach_timings(napi_env env, const FrameTimings& timings, napi_value result) {
+    napi_value object;
+    napi_status status = napi_create_object(env, &object);
+    if (status != napi_ok) return status;
+
+    if (!set_number_property(env, object, "queueNs", (double)timings.stage_ns[METRIC_STAGE_QUEUE]) ||
+        !set_number_property(env, object, "parseNs", (double)timings.stage_ns[METRIC_STAGE_PARSE]) ||
+        !set_number_property(env, object, "renderNs", (double)timings.stage_ns[METRIC_STAGE_RENDER]) ||
+        !set_number_property(env, object, "encodeNs", (double)timings.stage_ns[METRIC_STAGE_ENCODE]) ||
+        !set_number_property(env, object, "totalNs", (double)timings.stage_ns[METRIC_STAGE_TOTAL]) ||
+        !set_number_property(env, object, "inputBytes", (double)timings.input_bytes) ||
+        !set_number_property(env, object, "outputBytes", (double)timings.output_bytes) ||
+        !set_number_property(env, object, "surfaceBytes", (double)timings.surface_bytes)) {
+        return napi_generic_failure;
+    }
+    return napi_set_named_property(env, result, "timings", object);
+}
+
+static void finalize_cached_frame(napi_env env, void* data, void* hint) {
+    delete static_cast<std::shared_ptr<const CachedFrame>*>(hint);
+}
+
+// A hit gets its own copy, so that no caller can change what later hits
+// return. Callers that promise not to write to it can share the entry
+// instead: the Buffer then points into it and holds a reference, so the hit
+// costs no copy and eviction never frees memory JS can still see.
+static napi_status create_cached_frame_buffer(napi_env env, const std::shared_ptr<const CachedFrame>& frame, bool share,
+                                              napi_value* result) {
+    if (!share) return napi_create_buffer_copy(env, frame->size, frame->data, nullptr, result);
+
+    auto* hint = new std::shared_ptr<const CachedFrame>(frame);
+    napi_status status = napi_create_external_buffer(env, frame->size, frame->data, finalize_cached_frame, hint, result);
+    if (status == napi_ok) return status;
+
+    delete hint;
+    return napi_create_buffer_copy(env, frame->size, frame->data, nullptr, result);
+}
+
+// Raw frames rendered into a target resolve to that target; everything else
+// hands its result buffer, or a view of the cached result, over to JS.
+static napi_status create_converter_result(napi_env env, ConverterData* data, napi_value* result) {
+    napi_status status;
+    if (data->target_ref) {
+        status = napi_get_reference_value(env, data->target_ref, result);
+    } else if (data->cached_result) {
+        status = create_cached_frame_buffer(env, data->cached_result, data->share_cached, result);
+    } else {
+        status = create_owned_buffer(env, data->result_buffer, data->result_size, result);
+        data->result_buffer = nullptr;
+    }
+    if (status == napi_ok && data->report_timings) {
+        status = attach_timings(env, data->timings, *result);
+    }
+    return status;
+}
 
 void execute_work(napi_env env, void* data) {
     ConverterData* converter_data = static_cast<ConverterData*>(data);
-    converter_data->success = convert_to_png_sync(converter_data);
+    converter_data->success = convert_frame_sync(converter_data);
 }
 
 void complete_work(napi_env env, napi_status status, void* data) {
     ConverterData* converter_data = static_cast<ConverterData*>(data);
     napi_value result;
 
+    if (status == napi_cancelled) {
+        converter_data->error_msg = ls_ABORTED_MESSAGE;
+    }
+
     if (converter_data->success) {
-        status = napi_create_buffer_copy(env, converter_data->result_size, converter_data->result_buffer, nullptr, &result);
+        status = create_converter_result(env, converter_data, &result);
         if (status != napi_ok) {
             THROW_ERROR_NO_RETURN(env, "Failed to create result buffer");
         }
@@ -36,6 +447,44 @@ void complete_work(napi_env env, napi_status status, void* data) {
     destroy_converter_data(converter_data);
 }
 
+static void abandon_work(void* data) {
+    ConverterData* converter_data = static_cast<ConverterData*>(data);
+    drop_converter_refs(converter_data);
+    destroy_converter_data(converter_data);
+}
+
+napi_value queue_converter_work(napi_env env, ConverterData* data) {
+    napi_value promise;
+    napi_status status = napi_create_promise(env, &data->deferred, &promise);
+    if (status != napi_ok) {
+        destroy_converter_data(data);
+        THROW_ERROR(env, "Failed to create promise");
+    }
+
+    data->queued_at_ns = metrics_now_ns();
+    status = queue_pool_work(env, execute_work, complete_work, abandon_work, data, data->priority, data->cancel);
+    if (status != napi_ok) {
+        destroy_converter_data(data);
+        THROW_ERROR(env, "Failed to queue async work");
+    }
+
+    return promise;
+}
+
+napi_value run_converter_sync(napi_env env, ConverterData* data) {
+    if (!convert_frame_sync(data)) {
+        std::string msg = data->error_msg;
+        destroy_converter_data(data);
+        THROW_ERROR(env, msg.c_str());
+    }
+
+    napi_value result;
+    napi_status status = create_converter_result(env, data, &result);
+    destroy_converter_data(data);
+    CHECK_STATUS(env, status, "Failed to create result buffer");
+    return result;
+}
+
 napi_value exportFrame(napi_env env, napi_callback_info info) {
     size_t argc = 2;
     napi_value args[2];
@@ -46,110 +495,25 @@ napi_value exportFrame(napi_env env, napi_callback_info info) {
         THROW_ERROR(env, "Expected at least 1 argument: Lottie JSON buffer");
     }
 
-    byte* in_data;
-    size_t in_size;
-    status = napi_get_buffer_info(env, args[0], (void**)&in_data, &in_size);
-    CHECK_STATUS(env, status, "Failed to get buffer info from Lottie JSON argument");
-
-    ConverterData* data = create_converter_data(env, in_data, in_size);
+    ConverterData* data = create_converter_data(env, nullptr, 0);
     if (!data) {
         THROW_ERROR(env, "Failed to allocate converter data");
     }
+    const char* input_error = get_converter_input(env, args[0], data, true);
+    if (input_error) {
+        destroy_converter_data(data);
+        THROW_ERROR(env, input_error);
+    }
 
     if (argc >= 2 && args[1] != nullptr) {
-        napi_valuetype arg_type;
-        status = napi_typeof(env, args[1], &arg_type);
-        CHECK_STATUS(env, status, "Failed to get type of options argument");
-
-        if (arg_type == napi_object) {
-            napi_value prop;
-
-            if (has_own_property(env, args[1], "frame")) {
-                status = napi_get_named_property(env, args[1], "frame", &prop);
-                if (status == napi_ok) {
-                    uint32_t frame;
-                    status = napi_get_value_uint32(env, prop, &frame);
-                    if (status != napi_ok) {
-                        destroy_converter_data(data);
-                        THROW_ERROR(env, "Frame must be a valid integer");
-                    }
-                    data->frame = frame;
-                }
-            }
-
-            if (has_own_property(env, args[1], "width")) {
-                status = napi_get_named_property(env, args[1], "width", &prop);
-                if (status == napi_ok) {
-                    uint32_t width;
-                    status = napi_get_value_uint32(env, prop, &width);
-                    if (status != napi_ok) {
-                        destroy_converter_data(data);
-                        THROW_ERROR(env, "Width must be a valid integer");
-                    }
-                    if (width == 0 || width > li_MAX_DIMENSION) {
-                        destroy_converter_data(data);
-                        THROW_ERROR(env, "Width must be between 1 and 4096");
-                    }
-                    data->width = width;
-                }
-            }
-
-            if (has_own_property(env, args[1], "height")) {
-                status = napi_get_named_property(env, args[1], "height", &prop);
-                if (status == napi_ok) {
-                    uint32_t height;
-                    status = napi_get_value_uint32(env, prop, &height);
-                    if (status != napi_ok) {
-                        destroy_converter_data(data);
-                        THROW_ERROR(env, "Height must be a valid integer");
-                    }
-                    if (height == 0 || height > li_MAX_DIMENSION) {
-                        destroy_converter_data(data);
-                        THROW_ERROR(env, "Height must be between 1 and 4096");
-                    }
-                    data->height = height;
-                }
-            }
-
-            if (has_own_property(env, args[1], "quality")) {
-                status = napi_get_named_property(env, args[1], "quality", &prop);
-                if (status == napi_ok) {
-                    uint32_t quality;
-                    status = napi_get_value_uint32(env, prop, &quality);
-                    if (status != napi_ok) {
-                        destroy_converter_data(data);
-                        THROW_ERROR(env, "Quality must be a valid integer");
-                    }
-                    if (quality < 1 || quality > 100) {
-                        destroy_converter_data(data);
-                        THROW_ERROR(env, "Quality must be between 1 and 100");
-                    }
-                    data->quality = quality / 100.0f;
-                }
-            }
-        } else if (arg_type != napi_undefined && arg_type != napi_null) {
+        const char* error = parse_converter_options(env, args[1], data);
+        if (error) {
             destroy_converter_data(data);
-            THROW_ERROR(env, "Options argument must be an object");
+            THROW_ERROR(env, error);
         }
     }
 
-    napi_deferred deferred;
-    napi_value promise;
-    status = napi_create_promise(env, &deferred, &promise);
-    CHECK_STATUS(env, status, "Failed to create promise");
-
-    data->deferred = deferred;
-
-    napi_async_work work;
-    napi_value resource_name;
-    status = napi_create_string_utf8(env, "LottieExportFrame", NAPI_AUTO_LENGTH, &resource_name);
-    CHECK_STATUS(env, status, "Failed to create resource name");
-    status = napi_create_async_work(env, nullptr, resource_name, execute_work, complete_work, data, &work);
-    CHECK_STATUS(env, status, "Failed to create async work");
-    status = napi_queue_async_work(env, work);
-    CHECK_STATUS(env, status, "Failed to queue async work");
-
-    return promise;
+    return queue_converter_work(env, data);
 }
 
 napi_value exportFrameSync(napi_env env, napi_callback_info info) {
@@ -162,103 +526,317 @@ napi_value exportFrameSync(napi_env env, napi_callback_info info) {
         THROW_ERROR(env, "Expected at least 1 argument: Lottie JSON buffer");
     }
 
-    byte* in_data;
-    size_t in_size;
-    status = napi_get_buffer_info(env, args[0], (void**)&in_data, &in_size);
-    CHECK_STATUS(env, status, "Failed to get buffer info from Lottie JSON argument");
-
-    ConverterData* data = create_converter_data(env, in_data, in_size);
+    ConverterData* data = create_converter_data(env, nullptr, 0);
     if (!data) {
         THROW_ERROR(env, "Failed to allocate converter data");
     }
+    const char* input_error = get_converter_input(env, args[0], data, false);
+    if (input_error) {
+        destroy_converter_data(data);
+        THROW_ERROR(env, input_error);
+    }
 
     if (argc >= 2 && args[1] != nullptr) {
-        napi_valuetype arg_type;
-        status = napi_typeof(env, args[1], &arg_type);
+        const char* error = parse_converter_options(env, args[1], data);
+        if (error) {
+            destroy_converter_data(data);
+            THROW_ERROR(env, error);
+        }
+    }
+
+    return run_converter_sync(env, data);
+}
+
+napi_value configureAnimationCache(napi_env env, napi_callback_info info) {
+    size_t argc = 1;
+    napi_value args[1];
+    napi_status status = napi_get_cb_info(env, info, &argc, args, nullptr, nullptr);
+    CHECK_STATUS(env, status, "Failed to get callback info");
+
+    napi_valuetype arg_type = napi_undefined;
+    if (argc >= 1) {
+        status = napi_typeof(env, args[0], &arg_type);
         CHECK_STATUS(env, status, "Failed to get type of options argument");
+    }
+    if (arg_type != napi_object) {
+        THROW_ERROR(env, "Expected 1 argument: cache options object");
+    }
 
-        if (arg_type == napi_object) {
-            napi_value prop;
-
-            if (has_own_property(env, args[1], "frame")) {
-                status = napi_get_named_property(env, args[1], "frame", &prop);
-                if (status == napi_ok) {
-                    uint32_t frame;
-                    status = napi_get_value_uint32(env, prop, &frame);
-                    if (status != napi_ok) {
-                        destroy_converter_data(data);
-                        THROW_ERROR(env, "Frame must be a valid integer");
-                    }
-                    data->frame = frame;
-                }
+    AnimationCacheStats current = get_animation_cache_stats();
+    size_t max_entries = current.max_entries;
+    size_t max_bytes = current.max_bytes;
+    napi_value prop;
+
+    if (has_own_property(env, args[0], "maxEntries")) {
+        status = napi_get_named_property(env, args[0], "maxEntries", &prop);
+        if (status == napi_ok) {
+            uint32_t entries;
+            status = napi_get_value_uint32(env, prop, &entries);
+            if (status != napi_ok) {
+                THROW_ERROR(env, "Max entries must be a valid integer");
             }
+            max_entries = entries;
+        }
+    }
 
-            if (has_own_property(env, args[1], "width")) {
-                status = napi_get_named_property(env, args[1], "width", &prop);
-                if (status == napi_ok) {
-                    uint32_t width;
-                    status = napi_get_value_uint32(env, prop, &width);
-                    if (status != napi_ok) {
-                        destroy_converter_data(data);
-                        THROW_ERROR(env, "Width must be a valid integer");
-                    }
-                    if (width == 0 || width > li_MAX_DIMENSION) {
-                        destroy_converter_data(data);
-                        THROW_ERROR(env, "Width must be between 1 and 4096");
-                    }
-                    data->width = width;
-                }
+    if (has_own_property(env, args[0], "maxBytes")) {
+        status = napi_get_named_property(env, args[0], "maxBytes", &prop);
+        if (status == napi_ok) {
+            int64_t bytes;
+            status = napi_get_value_int64(env, prop, &bytes);
+            if (status != napi_ok || bytes < 0) {
+                THROW_ERROR(env, "Max bytes must be a non-negative integer");
             }
+            max_bytes = (size_t)bytes;
+        }
+    }
 
-            if (has_own_property(env, args[1], "height")) {
-                status = napi_get_named_property(env, args[1], "height", &prop);
-                if (status == napi_ok) {
-                    uint32_t height;
-                    status = napi_get_value_uint32(env, prop, &height);
-                    if (status != napi_ok) {
-                        destroy_converter_data(data);
-                        THROW_ERROR(env, "Height must be a valid integer");
-                    }
-                    if (height == 0 || height > li_MAX_DIMENSION) {
-                        destroy_converter_data(data);
-                        THROW_ERROR(env, "Height must be between 1 and 4096");
-                    }
-                    data->height = height;
-                }
-            }
+    configure_animation_cache(max_entries, max_bytes);
+    return nullptr;
+}
 
-            if (has_own_property(env, args[1], "quality")) {
-                status = napi_get_named_property(env, args[1], "quality", &prop);
-                if (status == napi_ok) {
-                    uint32_t quality;
-                    status = napi_get_value_uint32(env, prop, &quality);
-                    if (status != napi_ok) {
-                        destroy_converter_data(data);
-                        THROW_ERROR(env, "Quality must be a valid integer");
-                    }
-                    if (quality < 1 || quality > 100) {
-                        destroy_converter_data(data);
-                        THROW_ERROR(env, "Quality must be between 1 and 100");
-                    }
-                    data->quality = quality / 100.0f;
-                }
+napi_value clearAnimationCache(napi_env env, napi_callback_info info) {
+    clear_animation_cache();
+    return nullptr;
+}
+
+napi_value getAnimationCacheStats(napi_env env, napi_callback_info info) {
+    AnimationCacheStats stats = get_animation_cache_stats();
+
+    napi_value result;
+    napi_status status = napi_create_object(env, &result);
+    CHECK_STATUS(env, status, "Failed to create stats object");
+
+    if (!set_number_property(env, result, "hits", (double)stats.hits) ||
+        !set_number_property(env, result, "misses", (double)stats.misses) ||
+        !set_number_property(env, result, "evictions", (double)stats.evictions) ||
+        !set_number_property(env, result, "entries", (double)stats.entries) ||
+        !set_number_property(env, result, "bytes", (double)stats.bytes) ||
+        !set_number_property(env, result, "maxEntries", (double)stats.max_entries) ||
+        !set_number_property(env, result, "maxBytes", (double)stats.max_bytes)) {
+        THROW_ERROR(env, "Failed to set stats properties");
+    }
+
+    return result;
+}
+
+napi_value configureFrameCache(napi_env env, napi_callback_info info) {
+    size_t argc = 1;
+    napi_value args[1];
+    napi_status status = napi_get_cb_info(env, info, &argc, args, nullptr, nullptr);
+    CHECK_STATUS(env, status, "Failed to get callback info");
+
+    napi_valuetype arg_type = napi_undefined;
+    if (argc >= 1) {
+        status = napi_typeof(env, args[0], &arg_type);
+        CHECK_STATUS(env, status, "Failed to get type of options argument");
+    }
+    if (arg_type != napi_object) {
+        THROW_ERROR(env, "Expected 1 argument: cache options object");
+    }
+
+    size_t max_bytes = get_frame_cache_stats().max_bytes;
+    if (has_own_property(env, args[0], "maxBytes")) {
+        napi_value prop;
+        status = napi_get_named_property(env, args[0], "maxBytes", &prop);
+        if (status == napi_ok) {
+            int64_t bytes;
+            status = napi_get_value_int64(env, prop, &bytes);
+            if (status != napi_ok || bytes < 0) {
+                THROW_ERROR(env, "Max bytes must be a non-negative integer");
             }
-        } else if (arg_type != napi_undefined && arg_type != napi_null) {
-            destroy_converter_data(data);
-            THROW_ERROR(env, "Options argument must be an object");
+            max_bytes = (size_t)bytes;
         }
     }
 
-    if (!convert_to_png_sync(data)) {
-        std::string msg = data->error_msg;
-        destroy_converter_data(data);
-        THROW_ERROR(env, msg.c_str());
+    configure_frame_cache(max_bytes);
+    return nullptr;
+}
+
+napi_value clearFrameCache(napi_env env, napi_callback_info info) {
+    clear_frame_cache();
+    return nullptr;
+}
+
+napi_value getFrameCacheStats(napi_env env, napi_callback_info info) {
+    FrameCacheStats stats = get_frame_cache_stats();
+
+    napi_value result;
+    napi_status status = napi_create_object(env, &result);
+    CHECK_STATUS(env, status, "Failed to create stats object");
+
+    if (!set_number_property(env, result, "hits", (double)stats.hits) ||
+        !set_number_property(env, result, "misses", (double)stats.misses) ||
+        !set_number_property(env, result, "coalesced", (double)stats.coalesced) ||
+        !set_number_property(env, result, "evictions", (double)stats.evictions) ||
+        !set_number_property(env, result, "entries", (double)stats.entries) ||
+        !set_number_property(env, result, "bytes", (double)stats.bytes) ||
+        !set_number_property(env, result, "maxBytes", (double)stats.max_bytes)) {
+        THROW_ERROR(env, "Failed to set stats properties");
     }
 
+    return result;
+}
+
+napi_value getBufferPoolStats(napi_env env, napi_callback_info info) {
+    BufferPoolStats stats = get_buffer_pool_stats();
+
     napi_value result;
-    status = napi_create_buffer_copy(env, data->result_size, data->result_buffer, nullptr, &result);
-    CHECK_STATUS(env, status, "Failed to create result buffer");
+    napi_status status = napi_create_object(env, &result);
+    CHECK_STATUS(env, status, "Failed to create stats object");
+
+    if (!set_number_property(env, result, "scratchAllocations", (double)stats.scratch_allocations) ||
+        !set_number_property(env, result, "scratchReuses", (double)stats.scratch_reuses) ||
+        !set_number_property(env, result, "pooledBytes", (double)stats.pooled_bytes) ||
+        !set_number_property(env, result, "outputAllocations", (double)stats.output_allocations)) {
+        THROW_ERROR(env, "Failed to set stats properties");
+    }
+
+    return result;
+}
+
+napi_value setConcurrency(napi_env env, napi_callback_info info) {
+    size_t argc = 1;
+    napi_value args[1];
+    napi_status status = napi_get_cb_info(env, info, &argc, args, nullptr, nullptr);
+    CHECK_STATUS(env, status, "Failed to get callback info");
+
+    if (argc < 1) {
+        THROW_ERROR(env, "Expected 1 argument: number of worker threads");
+    }
+
+    uint32_t concurrency;
+    status = napi_get_value_uint32(env, args[0], &concurrency);
+    if (status != napi_ok) {
+        THROW_ERROR(env, "Concurrency must be a valid integer");
+    }
+    if (concurrency < 1 || concurrency > li_MAX_POOL_THREADS) {
+        THROW_ERROR(env, "Concurrency must be between 1 and 64");
+    }
+
+    set_pool_concurrency(concurrency);
+    return nullptr;
+}
+
+napi_value getQueueStats(napi_env env, napi_callback_info info) {
+    static const char* const priority_names[JOB_PRIORITY_COUNT] = {"high", "normal", "low"};
+    WorkerPoolStats stats = get_worker_pool_stats();
+
+    napi_value result;
+    napi_status status = napi_create_object(env, &result);
+    CHECK_STATUS(env, status, "Failed to create stats object");
+
+    if (!set_number_property(env, result, "concurrency", (double)stats.concurrency) ||
+        !set_number_property(env, result, "running", (double)stats.running)) {
+        THROW_ERROR(env, "Failed to set stats properties");
+    }
+
+    for (size_t i = 0; i < JOB_PRIORITY_COUNT; i++) {
+        const JobQueueStats& queue = stats.queues[i];
+        napi_value queue_stats;
+        status = napi_create_object(env, &queue_stats);
+        CHECK_STATUS(env, status, "Failed to create stats object");
+
+        double average_wait_ms = queue.started ? queue.total_wait_ms / queue.started : 0;
+        if (!set_number_property(env, queue_stats, "depth", (double)queue.depth) ||
+            !set_number_property(env, queue_stats, "queued", (double)queue.queued) ||
+            !set_number_property(env, queue_stats, "started", (double)queue.started) ||
+            !set_number_property(env, queue_stats, "cancelled", (double)queue.cancelled) ||
+            !set_number_property(env, queue_stats, "averageWaitMs", average_wait_ms) ||
+            !set_number_property(env, queue_stats, "maxWaitMs", queue.max_wait_ms) ||
+            napi_set_named_property(env, result, priority_names[i], queue_stats) != napi_ok) {
+            THROW_ERROR(env, "Failed to set stats properties");
+        }
+    }
+
+    return result;
+}
+
+napi_value createCancelToken(napi_env env, napi_callback_info info) {
+    std::shared_ptr<CancelToken>* token = new std::shared_ptr<CancelToken>(std::make_shared<CancelToken>());
+
+    napi_value handle;
+    napi_status status = napi_create_external(env, token, finalize_cancel_token, nullptr, &handle);
+    if (status != napi_ok) {
+        delete token;
+        THROW_ERROR(env, "Failed to create cancel token");
+    }
+    return handle;
+}
+
+napi_value cancelToken(napi_env env, napi_callback_info info) {
+    size_t argc = 1;
+    napi_value args[1];
+    napi_status status = napi_get_cb_info(env, info, &argc, args, nullptr, nullptr);
+    CHECK_STATUS(env, status, "Failed to get callback info");
+
+    std::shared_ptr<CancelToken>* token = argc >= 1 ? get_cancel_token(env, args[0]) : nullptr;
+    if (!token) {
+        THROW_ERROR(env, "Expected 1 argument: cancel token");
+    }
+
+    cancel_pool_work(*token);
+    return nullptr;
+}
+
+static napi_status create_histogram_object(napi_env env, const StageHistogram& histogram, napi_value* result) {
+    napi_status status = napi_create_object(env, result);
+    if (status != napi_ok) return status;
+
+    double mean = histogram.count ? (double)histogram.sum_ns / histogram.count : 0;
+    if (!set_number_property(env, *result, "count", (double)histogram.count) ||
+        !set_number_property(env, *result, "meanNs", mean) ||
+        !set_number_property(env, *result, "p50Ns", (double)histogram_quantile(histogram, 0.5)) ||
+        !set_number_property(env, *result, "p90Ns", (double)histogram_quantile(histogram, 0.9)) ||
+        !set_number_property(env, *result, "p99Ns", (double)histogram_quantile(histogram, 0.99)) ||
+        !set_number_property(env, *result, "maxNs", (double)histogram.max_ns)) {
+        return napi_generic_failure;
+    }
+
+    napi_value buckets;
+    status = napi_create_array_with_length(env, histogram.buckets.size(), &buckets);
+    if (status != napi_ok) return status;
+    for (size_t i = 0; i < histogram.buckets.size(); i++) {
+        napi_value bucket;
+        status = napi_create_object(env, &bucket);
+        if (status != napi_ok) return status;
+        if (!set_number_property(env, bucket, "upperNs", (double)histogram.buckets[i].upper_ns) ||
+            !set_number_property(env, bucket, "count", (double)histogram.buckets[i].count)) {
+            return napi_generic_failure;
+        }
+        status = napi_set_element(env, buckets, (uint32_t)i, bucket);
+        if (status != napi_ok) return status;
+    }
+    return napi_set_named_property(env, *result, "buckets", buckets);
+}
+
+napi_value getStats(napi_env env, napi_callback_info info) {
+    MetricsSnapshot snapshot = get_metrics_snapshot();
+
+    napi_value result;
+    napi_status status = napi_create_object(env, &result);
+    CHECK_STATUS(env, status, "Failed to create stats object");
+
+    if (!set_number_property(env, result, "calls", (double)snapshot.calls) ||
+        !set_number_property(env, result, "failures", (double)snapshot.failures) ||
+        !set_number_property(env, result, "inFlight", (double)snapshot.in_flight) ||
+        !set_number_property(env, result, "inputBytes", (double)snapshot.input_bytes) ||
+        !set_number_property(env, result, "outputBytes", (double)snapshot.output_bytes)) {
+        THROW_ERROR(env, "Failed to set stats properties");
+    }
+
+    napi_value stages;
+    status = napi_create_object(env, &stages);
+    CHECK_STATUS(env, status, "Failed to create stats object");
+    for (int stage = 0; stage < METRIC_STAGE_COUNT; stage++) {
+        napi_value histogram;
+        status = create_histogram_object(env, snapshot.stages[stage], &histogram);
+        CHECK_STATUS(env, status, "Failed to create histogram object");
+        status = napi_set_named_property(env, stages, metric_stage_name((MetricStage)stage), histogram);
+        CHECK_STATUS(env, status, "Failed to set stats properties");
+    }
+    status = napi_set_named_property(env, result, "stages", stages);
+    CHECK_STATUS(env, status, "Failed to set stats properties");
 
-    destroy_converter_data(data);
     return result;
 }
\ No newline at end of file
@@ -4,9 +4,24 @@
 #include <napi.h>
 #include "converter.h"
 
+const char* parse_converter_options(napi_env env, napi_value options, ConverterData* data);
 void execute_work(napi_env env, void* data);
 void complete_work(napi_env env, napi_status status, void* data);
+napi_value queue_converter_work(napi_env env, ConverterData* data);
+napi_value run_converter_sync(napi_env env, ConverterData* data);
 napi_value exportFrame(napi_env env, napi_callback_info info);
 napi_value exportFrameSync(napi_env env, napi_callback_info info);
+napi_value configureAnimationCache(napi_env env, napi_callback_info info);
+napi_value clearAnimationCache(napi_env env, napi_callback_info info);
+napi_value getAnimationCacheStats(napi_env env, napi_callback_info info);
+napi_value configureFrameCache(napi_env env, napi_callback_info info);
+napi_value clearFrameCache(napi_env env, napi_callback_info info);
+napi_value getFrameCacheStats(napi_env env, napi_callback_info info);
+napi_value getBufferPoolStats(napi_env env, napi_callback_info info);
+napi_value setConcurrency(napi_env env, napi_callback_info info);
+napi_value getQueueStats(napi_env env, napi_callback_info info);
+napi_value createCancelToken(napi_env env, napi_callback_info info);
+napi_value cancelToken(napi_env env, napi_callback_info info);
+napi_value getStats(napi_env env, napi_callback_info info);
 
 #endif // EXPORTS_H
\ No newline at end of file
@@ -0,0 +1,137 @@
+#include "frame_cache.h"
+#include "worker_pool.h"
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+
+// How often a waiter for a coalesced render checks its cancel token.
+#define li_CANCEL_POLL_MS 10
+
+struct FrameCacheEntry {
+    std::string key;
+    std::shared_ptr<const CachedFrame> frame;
+};
+
+// One per render in flight; waiters hold it so it survives its removal from
+// the table when the render finishes.
+struct PendingFrame {
+    bool done;
+    std::shared_ptr<const CachedFrame> frame;
+};
+
+static std::mutex cache_mutex;
+static std::condition_variable pending_cv;
+static std::list<FrameCacheEntry> cache_lru;
+static std::unordered_map<std::string, std::list<FrameCacheEntry>::iterator> cache_index;
+static std::unordered_map<std::string, std::shared_ptr<PendingFrame>> pending_frames;
+static FrameCacheStats cache_stats = {0, 0, 0, 0, 0, 0, 0};
+
+CachedFrame::~CachedFrame() {
+    free(data);
+}
+
+static void evict_lru_locked() {
+    FrameCacheEntry& entry = cache_lru.back();
+    cache_stats.bytes -= entry.frame->size;
+    cache_stats.evictions++;
+    cache_index.erase(entry.key);
+    cache_lru.pop_back();
+}
+
+static void trim_locked() {
+    while (!cache_lru.empty() && cache_stats.bytes > cache_stats.max_bytes) {
+        evict_lru_locked();
+    }
+    cache_stats.entries = cache_lru.size();
+}
+
+void configure_frame_cache(size_t max_bytes) {
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    cache_stats.max_bytes = max_bytes;
+    trim_locked();
+}
+
+void clear_frame_cache() {
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    cache_lru.clear();
+    cache_index.clear();
+    cache_stats.entries = 0;
+    cache_stats.bytes = 0;
+}
+
+FrameCacheStats get_frame_cache_stats() {
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    return cache_stats;
+}
+
+bool frame_cache_enabled() {
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    return cache_stats.max_bytes != 0;
+}
+
+std::shared_ptr<const CachedFrame> acquire_cached_frame(const std::string& key, const std::shared_ptr<CancelToken>& cancel,
+                                                        bool* cancelled) {
+    *cancelled = false;
+    std::unique_lock<std::mutex> lock(cache_mutex);
+    for (;;) {
+        auto it = cache_index.find(key);
+        if (it != cache_index.end()) {
+            cache_lru.splice(cache_lru.begin(), cache_lru, it->second);
+            cache_stats.hits++;
+            return it->second->frame;
+        }
+
+        auto pending = pending_frames.find(key);
+        if (pending == pending_frames.end()) {
+            cache_stats.misses++;
+            pending_frames.emplace(key, std::make_shared<PendingFrame>(PendingFrame{false, nullptr}));
+            return nullptr;
+        }
+
+        // The render in flight is on another thread and never waits on this
+        // one, so blocking here cannot deadlock the pool. Cancelling only sets
+        // a flag, so the wait wakes up now and then to let an aborted waiter
+        // free its worker.
+        std::shared_ptr<PendingFrame> shared = pending->second;
+        while (!pending_cv.wait_for(lock, std::chrono::milliseconds(li_CANCEL_POLL_MS), [&] { return shared->done; })) {
+            if (is_cancelled(cancel)) {
+                *cancelled = true;
+                return nullptr;
+            }
+        }
+        if (shared->frame) {
+            cache_stats.coalesced++;
+            return shared->frame;
+        }
+        // That render failed; look again and render here if nobody else has
+        // taken over.
+    }
+}
+
+void finish_cached_frame(const std::string& key, std::shared_ptr<const CachedFrame> frame) {
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    auto pending = pending_frames.find(key);
+    if (pending != pending_frames.end()) {
+        pending->second->done = true;
+        pending->second->frame = frame;
+        pending_frames.erase(pending);
+        pending_cv.notify_all();
+    }
+
+    // Waiters get the frame even when it is too large to keep.
+    if (!frame || cache_stats.max_bytes == 0 || frame->size > cache_stats.max_bytes) return;
+
+    auto it = cache_index.find(key);
+    if (it != cache_index.end()) {
+        cache_stats.bytes -= it->second->frame->size;
+        cache_lru.erase(it->second);
+        cache_index.erase(it);
+    }
+    cache_lru.push_front(FrameCacheEntry{key, frame});
+    cache_index[key] = cache_lru.begin();
+    cache_stats.bytes += frame->size;
+    trim_locked();
+}
\ No newline at end of file
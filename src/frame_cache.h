@@ -0,0 +1,52 @@
+#ifndef FRAME_CACHE_H
+#define FRAME_CACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+struct CancelToken;
+
+// An encoded frame owned by the cache. Results handed to JS share it, so it
+// outlives eviction for as long as any Buffer still points at it.
+struct CachedFrame {
+    uint8_t* data;
+    size_t size;
+
+    CachedFrame(uint8_t* data, size_t size) : data(data), size(size) {}
+    ~CachedFrame();
+    CachedFrame(const CachedFrame&) = delete;
+    CachedFrame& operator=(const CachedFrame&) = delete;
+};
+
+struct FrameCacheStats {
+    uint64_t hits;
+    uint64_t misses;
+    // Requests that waited for an identical render already in flight.
+    uint64_t coalesced;
+    uint64_t evictions;
+    size_t entries;
+    size_t bytes;
+    size_t max_bytes;
+};
+
+// Process-wide LRU of encoded frames keyed by a caller-built string describing
+// the input and every option that affects the output bytes. Disabled while
+// max_bytes is 0. Entries are charged by their encoded size; frames larger
+// than the whole budget are never stored.
+void configure_frame_cache(size_t max_bytes);
+void clear_frame_cache();
+FrameCacheStats get_frame_cache_stats();
+bool frame_cache_enabled();
+
+// Returns the cached frame for key. On a miss while an identical render is in
+// flight, waits for it and shares its result; a waiter whose `cancel` fires
+// gives up, returning nullptr with *cancelled set. Otherwise returns nullptr
+// and the caller owns the render: it must call finish_cached_frame with the
+// same key, passing nullptr on failure so that waiters render for themselves.
+std::shared_ptr<const CachedFrame> acquire_cached_frame(const std::string& key, const std::shared_ptr<CancelToken>& cancel,
+                                                        bool* cancelled);
+void finish_cached_frame(const std::string& key, std::shared_ptr<const CachedFrame> frame);
+
+#endif // FRAME_CACHE_H
\ No newline at end of file
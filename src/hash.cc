@@ -0,0 +1,90 @@
+#include "hash.h"
+#include <cstring>
+
+#define lu_PRIME1 0x9E3779B185EBCA87ULL
+#define lu_PRIME2 0xC2B2AE3D27D4EB4FULL
+#define lu_PRIME3 0x165667B19E3779F9ULL
+#define lu_PRIME4 0x85EBCA77C2B2AE63ULL
+#define lu_PRIME5 0x27D4EB2F165667C5ULL
+
+static inline uint64_t rotl64(uint64_t x, int r) {
+    return (x << r) | (x >> (64 - r));
+}
+
+static inline uint64_t read64(const uint8_t* p) {
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline uint32_t read32(const uint8_t* p) {
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline uint64_t round64(uint64_t acc, uint64_t input) {
+    acc += input * lu_PRIME2;
+    acc = rotl64(acc, 31);
+    return acc * lu_PRIME1;
+}
+
+static inline uint64_t merge64(uint64_t acc, uint64_t val) {
+    acc ^= round64(0, val);
+    return acc * lu_PRIME1 + lu_PRIME4;
+}
+
+uint64_t hash_bytes(const void* data, size_t size, uint64_t seed) {
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+    const uint8_t* end = p + size;
+    uint64_t h;
+
+    if (size >= 32) {
+        // Four independent lanes keep the multiplies pipelined.
+        uint64_t v1 = seed + lu_PRIME1 + lu_PRIME2;
+        uint64_t v2 = seed + lu_PRIME2;
+        uint64_t v3 = seed;
+        uint64_t v4 = seed - lu_PRIME1;
+        const uint8_t* limit = end - 32;
+        do {
+            v1 = round64(v1, read64(p));
+            v2 = round64(v2, read64(p + 8));
+            v3 = round64(v3, read64(p + 16));
+            v4 = round64(v4, read64(p + 24));
+            p += 32;
+        } while (p <= limit);
+
+        h = rotl64(v1, 1) + rotl64(v2, 7) + rotl64(v3, 12) + rotl64(v4, 18);
+        h = merge64(h, v1);
+        h = merge64(h, v2);
+        h = merge64(h, v3);
+        h = merge64(h, v4);
+    } else {
+        h = seed + lu_PRIME5;
+    }
+
+    h += (uint64_t)size;
+
+    while (p + 8 <= end) {
+        h ^= round64(0, read64(p));
+        h = rotl64(h, 27) * lu_PRIME1 + lu_PRIME4;
+        p += 8;
+    }
+    if (p + 4 <= end) {
+        h ^= (uint64_t)read32(p) * lu_PRIME1;
+        h = rotl64(h, 23) * lu_PRIME2 + lu_PRIME3;
+        p += 4;
+    }
+    while (p < end) {
+        h ^= (*p) * lu_PRIME5;
+        h = rotl64(h, 11) * lu_PRIME1;
+        p++;
+    }
+
+    h ^= h >> 33;
+    h *= lu_PRIME2;
+    h ^= h >> 29;
+    h *= lu_PRIME3;
+    h ^= h >> 32;
+    return h;
+}
\ No newline at end of file
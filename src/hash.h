@@ -0,0 +1,10 @@
+#ifndef HASH_H
+#define HASH_H
+
+#include <cstddef>
+#include <cstdint>
+
+// 64-bit non-cryptographic hash (XXH64) for cache keys and frame comparison.
+uint64_t hash_bytes(const void* data, size_t size, uint64_t seed = 0);
+
+#endif // HASH_H
\ No newline at end of file
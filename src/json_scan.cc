@@ -0,0 +1,178 @@
+#include "json_scan.h"
+#include <cstdint>
+
+size_t json_skip_whitespace(const std::string& json, size_t pos) {
+    while (pos < json.size() && (json[pos] == ' ' || json[pos] == '\t' || json[pos] == '\n' || json[pos] == '\r')) pos++;
+    return pos;
+}
+
+static bool skip_string(const std::string& json, size_t pos, size_t* end) {
+    for (pos++; pos < json.size(); pos++) {
+        if (json[pos] == '\\') {
+            pos++;
+        } else if (json[pos] == '"') {
+            *end = pos + 1;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool json_skip_value(const std::string& json, size_t pos, size_t* end) {
+    pos = json_skip_whitespace(json, pos);
+    if (pos >= json.size()) return false;
+
+    char c = json[pos];
+    if (c == '"') return skip_string(json, pos, end);
+
+    if (c == '{' || c == '[') {
+        // Iterative so that deeply nested input cannot exhaust the stack.
+        size_t depth = 0;
+        while (pos < json.size()) {
+            c = json[pos];
+            if (c == '"') {
+                if (!skip_string(json, pos, &pos)) return false;
+                continue;
+            }
+            if (c == '{' || c == '[') {
+                depth++;
+            } else if (c == '}' || c == ']') {
+                if (--depth == 0) {
+                    *end = pos + 1;
+                    return true;
+                }
+            }
+            pos++;
+        }
+        return false;
+    }
+
+    // Number, true, false or null.
+    size_t start = pos;
+    while (pos < json.size() && ((json[pos] >= '0' && json[pos] <= '9') || (json[pos] >= 'a' && json[pos] <= 'z') ||
+                                 json[pos] == '-' || json[pos] == '+' || json[pos] == '.' || json[pos] == 'E')) {
+        pos++;
+    }
+    *end = pos;
+    return pos > start;
+}
+
+static int hex_digit(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+static bool read_hex4(const std::string& json, size_t pos, uint32_t* value) {
+    if (pos + 4 > json.size()) return false;
+    *value = 0;
+    for (size_t i = 0; i < 4; i++) {
+        int digit = hex_digit(json[pos + i]);
+        if (digit < 0) return false;
+        *value = (*value << 4) | (uint32_t)digit;
+    }
+    return true;
+}
+
+static void append_utf8(std::string* out, uint32_t code) {
+    if (code < 0x80) {
+        out->push_back((char)code);
+    } else if (code < 0x800) {
+        out->push_back((char)(0xc0 | (code >> 6)));
+        out->push_back((char)(0x80 | (code & 0x3f)));
+    } else if (code < 0x10000) {
+        out->push_back((char)(0xe0 | (code >> 12)));
+        out->push_back((char)(0x80 | ((code >> 6) & 0x3f)));
+        out->push_back((char)(0x80 | (code & 0x3f)));
+    } else {
+        out->push_back((char)(0xf0 | (code >> 18)));
+        out->push_back((char)(0x80 | ((code >> 12) & 0x3f)));
+        out->push_back((char)(0x80 | ((code >> 6) & 0x3f)));
+        out->push_back((char)(0x80 | (code & 0x3f)));
+    }
+}
+
+bool json_read_string(const std::string& json, size_t pos, std::string* out) {
+    pos = json_skip_whitespace(json, pos);
+    if (pos >= json.size() || json[pos] != '"') return false;
+
+    out->clear();
+    for (pos++; pos < json.size(); pos++) {
+        char c = json[pos];
+        if (c == '"') return true;
+        if (c != '\\') {
+            out->push_back(c);
+            continue;
+        }
+        if (++pos >= json.size()) return false;
+        switch (json[pos]) {
+            case 'b': out->push_back('\b'); break;
+            case 'f': out->push_back('\f'); break;
+            case 'n': out->push_back('\n'); break;
+            case 'r': out->push_back('\r'); break;
+            case 't': out->push_back('\t'); break;
+            case 'u': {
+                uint32_t code;
+                if (!read_hex4(json, pos + 1, &code)) return false;
+                pos += 4;
+                uint32_t low;
+                if (code >= 0xd800 && code < 0xdc00 && pos + 2 < json.size() && json[pos + 1] == '\\' && json[pos + 2] == 'u' &&
+                    read_hex4(json, pos + 3, &low) && low >= 0xdc00 && low < 0xe000) {
+                    code = 0x10000 + ((code - 0xd800) << 10) + (low - 0xdc00);
+                    pos += 6;
+                }
+                append_utf8(out, code);
+                break;
+            }
+            default: out->push_back(json[pos]); break;
+        }
+    }
+    return false;
+}
+
+bool json_for_each_member(const std::string& json, size_t pos,
+                          const std::function<bool(const std::string& key, size_t begin, size_t end)>& fn) {
+    pos = json_skip_whitespace(json, pos);
+    if (pos >= json.size() || json[pos] != '{') return false;
+
+    pos = json_skip_whitespace(json, pos + 1);
+    if (pos < json.size() && json[pos] == '}') return true;
+
+    std::string key;
+    while (pos < json.size()) {
+        size_t key_end;
+        if (!json_read_string(json, pos, &key) || !skip_string(json, pos, &key_end)) return false;
+        pos = json_skip_whitespace(json, key_end);
+        if (pos >= json.size() || json[pos] != ':') return false;
+
+        size_t begin = json_skip_whitespace(json, pos + 1);
+        size_t end;
+        if (!json_skip_value(json, begin, &end) || !fn(key, begin, end)) return false;
+
+        pos = json_skip_whitespace(json, end);
+        if (pos < json.size() && json[pos] == '}') return true;
+        if (pos >= json.size() || json[pos] != ',') return false;
+        pos = json_skip_whitespace(json, pos + 1);
+    }
+    return false;
+}
+
+bool json_for_each_element(const std::string& json, size_t pos, const std::function<bool(size_t begin, size_t end)>& fn) {
+    pos = json_skip_whitespace(json, pos);
+    if (pos >= json.size() || json[pos] != '[') return false;
+
+    pos = json_skip_whitespace(json, pos + 1);
+    if (pos < json.size() && json[pos] == ']') return true;
+
+    while (pos < json.size()) {
+        size_t end;
+        if (!json_skip_value(json, pos, &end) || !fn(pos, end)) return false;
+
+        pos = json_skip_whitespace(json, end);
+        if (pos < json.size() && json[pos] == ']') return true;
+        if (pos >= json.size() || json[pos] != ',') return false;
+        pos = json_skip_whitespace(json, pos + 1);
+    }
+    return false;
+}
\ No newline at end of file
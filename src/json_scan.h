@@ -0,0 +1,24 @@
+#ifndef JSON_SCAN_H
+#define JSON_SCAN_H
+
+#include <cstddef>
+#include <functional>
+#include <string>
+
+// Forward scanner for reading or patching a few values of a JSON document
+// without building a tree. Positions are byte offsets into `json`; value
+// ranges are [begin, end). Structure is only checked as far as the scan needs
+// it, so the full document should still go through a real parser.
+size_t json_skip_whitespace(const std::string& json, size_t pos);
+// Sets *end to one past the value starting at pos.
+bool json_skip_value(const std::string& json, size_t pos, size_t* end);
+// Decodes the string value starting at pos.
+bool json_read_string(const std::string& json, size_t pos, std::string* out);
+// Calls fn(key, begin, end) for each member of the object starting at pos.
+// Returning false from fn stops the scan and fails it.
+bool json_for_each_member(const std::string& json, size_t pos,
+                          const std::function<bool(const std::string& key, size_t begin, size_t end)>& fn);
+// Calls fn(begin, end) for each element of the array starting at pos.
+bool json_for_each_element(const std::string& json, size_t pos, const std::function<bool(size_t begin, size_t end)>& fn);
+
+#endif // JSON_SCAN_H
\ No newline at end of file
@@ -0,0 +1,410 @@
+#include "lottie_animation.h"
+#include "addon.h"
+#include "animation_cache.h"
+#include "animation_registry.h"
+#include "exports.h"
+#include "utils.h"
+
+struct LoadData {
+    napi_env env;
+    napi_deferred deferred;
+    // Holds the Buffer or mapped file the animation is loaded from.
+    ConverterData* input;
+    std::string resource_path;
+    std::string animation_id;
+    std::shared_ptr<AnimationHandle> animation;
+    std::string error_msg;
+};
+
+static void finalize_animation(napi_env env, void* data, void* hint) {
+    delete static_cast<std::shared_ptr<AnimationHandle>*>(data);
+}
+
+static std::shared_ptr<AnimationHandle>* unwrap_animation(napi_env env, napi_value object) {
+    void* handle = nullptr;
+    napi_status status = napi_unwrap(env, object, &handle);
+    if (status != napi_ok || !handle) {
+        napi_throw_error(env, nullptr, "Invalid LottieAnimation instance");
+        return nullptr;
+    }
+    return static_cast<std::shared_ptr<AnimationHandle>*>(handle);
+}
+
+static std::shared_ptr<AnimationHandle>* this_animation(napi_env env, napi_callback_info info, size_t* argc, napi_value* args) {
+    napi_value self;
+    napi_status status = napi_get_cb_info(env, info, argc, args, &self, nullptr);
+    if (status != napi_ok) {
+        napi_throw_error(env, nullptr, "Failed to get callback info");
+        return nullptr;
+    }
+    return unwrap_animation(env, self);
+}
+
+static napi_value animationConstructor(napi_env env, napi_callback_info info) {
+    size_t argc = 1;
+    napi_value args[1];
+    napi_value self;
+    napi_status status = napi_get_cb_info(env, info, &argc, args, &self, nullptr);
+    CHECK_STATUS(env, status, "Failed to get callback info");
+
+    napi_valuetype arg_type = napi_undefined;
+    if (argc >= 1) {
+        status = napi_typeof(env, args[0], &arg_type);
+        CHECK_STATUS(env, status, "Failed to get type of constructor argument");
+    }
+    if (arg_type != napi_external) {
+        THROW_ERROR(env, "LottieAnimation cannot be constructed directly, use loadAnimation()");
+    }
+
+    void* source;
+    status = napi_get_value_external(env, args[0], &source);
+    CHECK_STATUS(env, status, "Failed to get animation handle");
+
+    std::shared_ptr<AnimationHandle>* handle = new std::shared_ptr<AnimationHandle>(*static_cast<std::shared_ptr<AnimationHandle>*>(source));
+    status = napi_wrap(env, self, handle, finalize_animation, nullptr, nullptr);
+    if (status != napi_ok) {
+        delete handle;
+        THROW_ERROR(env, "Failed to wrap animation handle");
+    }
+
+    return self;
+}
+
+static napi_value animationTotalFrames(napi_env env, napi_callback_info info) {
+    size_t argc = 0;
+    std::shared_ptr<AnimationHandle>* animation = this_animation(env, info, &argc, nullptr);
+    if (!animation) return nullptr;
+
+    napi_value result;
+    napi_status status = napi_create_uint32(env, (uint32_t)(*animation)->total_frames, &result);
+    CHECK_STATUS(env, status, "Failed to create totalFrames value");
+    return result;
+}
+
+static napi_value animationFrameRate(napi_env env, napi_callback_info info) {
+    size_t argc = 0;
+    std::shared_ptr<AnimationHandle>* animation = this_animation(env, info, &argc, nullptr);
+    if (!animation) return nullptr;
+
+    napi_value result;
+    napi_status status = napi_create_double(env, (*animation)->frame_rate, &result);
+    CHECK_STATUS(env, status, "Failed to create frameRate value");
+    return result;
+}
+
+static napi_value animationDuration(napi_env env, napi_callback_info info) {
+    size_t argc = 0;
+    std::shared_ptr<AnimationHandle>* animation = this_animation(env, info, &argc, nullptr);
+    if (!animation) return nullptr;
+
+    napi_value result;
+    napi_status status = napi_create_double(env, (*animation)->duration, &result);
+    CHECK_STATUS(env, status, "Failed to create duration value");
+    return result;
+}
+
+static napi_value animationSize(napi_env env, napi_callback_info info) {
+    size_t argc = 0;
+    std::shared_ptr<AnimationHandle>* animation = this_animation(env, info, &argc, nullptr);
+    if (!animation) return nullptr;
+
+    napi_value result, width, height;
+    napi_status status = napi_create_object(env, &result);
+    CHECK_STATUS(env, status, "Failed to create size object");
+    status = napi_create_uint32(env, (uint32_t)(*animation)->width, &width);
+    CHECK_STATUS(env, status, "Failed to create width value");
+    status = napi_create_uint32(env, (uint32_t)(*animation)->height, &height);
+    CHECK_STATUS(env, status, "Failed to create height value");
+    status = napi_set_named_property(env, result, "width", width);
+    CHECK_STATUS(env, status, "Failed to set width property");
+    status = napi_set_named_property(env, result, "height", height);
+    CHECK_STATUS(env, status, "Failed to set height property");
+    return result;
+}
+
+static ConverterData* create_render_data(napi_env env, napi_callback_info info) {
+    size_t argc = 1;
+    napi_value args[1];
+    std::shared_ptr<AnimationHandle>* animation = this_animation(env, info, &argc, args);
+    if (!animation) return nullptr;
+
+    ConverterData* data = create_converter_data(env, nullptr, 0);
+    if (!data) {
+        napi_throw_error(env, nullptr, "Failed to allocate converter data");
+        return nullptr;
+    }
+    data->animation = *animation;
+
+    if (argc >= 1 && args[0] != nullptr) {
+        const char* error = parse_converter_options(env, args[0], data);
+        if (!error && data->viewport.enabled) {
+            error = "Viewport, scale, tileSize and sizes above 4096 are not supported on loaded animations";
+        }
+        if (error) {
+            destroy_converter_data(data);
+            napi_throw_error(env, nullptr, error);
+            return nullptr;
+        }
+    }
+
+    return data;
+}
+
+static napi_value animationRenderFrame(napi_env env, napi_callback_info info) {
+    ConverterData* data = create_render_data(env, info);
+    if (!data) return nullptr;
+    return queue_converter_work(env, data);
+}
+
+static napi_value animationRenderFrameSync(napi_env env, napi_callback_info info) {
+    ConverterData* data = create_render_data(env, info);
+    if (!data) return nullptr;
+    return run_converter_sync(env, data);
+}
+
+static napi_value animationShare(napi_env env, napi_callback_info info) {
+    size_t argc = 0;
+    std::shared_ptr<AnimationHandle>* animation = this_animation(env, info, &argc, nullptr);
+    if (!animation) return nullptr;
+
+    napi_value result;
+    napi_status status = napi_create_uint32(env, share_animation(*animation), &result);
+    CHECK_STATUS(env, status, "Failed to create shared animation ID");
+    return result;
+}
+
+static bool get_shared_animation_id(napi_env env, napi_callback_info info, uint32_t* id) {
+    size_t argc = 1;
+    napi_value args[1];
+    napi_status status = napi_get_cb_info(env, info, &argc, args, nullptr, nullptr);
+    if (status != napi_ok) {
+        napi_throw_error(env, nullptr, "Failed to get callback info");
+        return false;
+    }
+    if (argc < 1 || napi_get_value_uint32(env, args[0], id) != napi_ok) {
+        napi_throw_error(env, nullptr, "Expected 1 argument: shared animation ID");
+        return false;
+    }
+    return true;
+}
+
+napi_status define_lottie_animation_class(napi_env env, napi_value* result) {
+    napi_property_descriptor properties[] = {
+        {"totalFrames", nullptr, nullptr, animationTotalFrames, nullptr, nullptr, napi_default, nullptr},
+        {"frameRate", nullptr, nullptr, animationFrameRate, nullptr, nullptr, napi_default, nullptr},
+        {"duration", nullptr, nullptr, animationDuration, nullptr, nullptr, napi_default, nullptr},
+        {"size", nullptr, nullptr, animationSize, nullptr, nullptr, napi_default, nullptr},
+        {"renderFrame", nullptr, animationRenderFrame, nullptr, nullptr, nullptr, napi_default, nullptr},
+        {"renderFrameSync", nullptr, animationRenderFrameSync, nullptr, nullptr, nullptr, napi_default, nullptr},
+        {"share", nullptr, animationShare, nullptr, nullptr, nullptr, napi_default, nullptr},
+    };
+
+    napi_status status = napi_define_class(env, "LottieAnimation", NAPI_AUTO_LENGTH, animationConstructor, nullptr,
+                                           sizeof(properties) / sizeof(properties[0]), properties, result);
+    if (status != napi_ok) return status;
+
+    AddonData* addon = get_addon_data(env);
+    if (!addon) return napi_generic_failure;
+    return napi_create_reference(env, *result, 1, &addon->lottie_animation_constructor);
+}
+
+napi_status new_lottie_animation(napi_env env, std::shared_ptr<AnimationHandle> animation, napi_value* result) {
+    AddonData* addon = get_addon_data(env);
+    if (!addon) return napi_generic_failure;
+
+    napi_value constructor, external;
+    napi_status status = napi_get_reference_value(env, addon->lottie_animation_constructor, &constructor);
+    if (status != napi_ok) return status;
+
+    status = napi_create_external(env, &animation, nullptr, nullptr, &external);
+    if (status != napi_ok) return status;
+
+    return napi_new_instance(env, constructor, 1, &external, result);
+}
+
+static const char* parse_load_options(napi_env env, size_t argc, napi_value* args, std::string& resource_path, std::string& animation_id) {
+    if (argc < 2 || args[1] == nullptr) return nullptr;
+
+    napi_valuetype arg_type;
+    napi_status status = napi_typeof(env, args[1], &arg_type);
+    if (status != napi_ok) return "Failed to get type of options argument";
+
+    if (arg_type == napi_object) {
+        if (has_own_property(env, args[1], "resourcePath")) {
+            napi_value prop;
+            status = napi_get_named_property(env, args[1], "resourcePath", &prop);
+            if (status != napi_ok || !get_string_value(env, prop, resource_path)) {
+                return "Resource path must be a string";
+            }
+        }
+        if (has_own_property(env, args[1], "animationId")) {
+            napi_value prop;
+            status = napi_get_named_property(env, args[1], "animationId", &prop);
+            if (status != napi_ok || !get_string_value(env, prop, animation_id)) {
+                return "Animation ID must be a string";
+            }
+        }
+    } else if (arg_type != napi_undefined && arg_type != napi_null) {
+        return "Options argument must be an object";
+    }
+
+    return nullptr;
+}
+
+static void execute_load_work(napi_env env, void* data) {
+    LoadData* load_data = static_cast<LoadData*>(data);
+    ConverterData* input = load_data->input;
+    if (!open_converter_input(input)) {
+        load_data->error_msg = input->error_msg;
+        return;
+    }
+    load_data->animation = load_cached_animation(input->in_data, input->in_size, load_data->resource_path,
+                                                load_data->animation_id, load_data->error_msg);
+}
+
+static void abandon_load_work(void* data) {
+    LoadData* load_data = static_cast<LoadData*>(data);
+    drop_converter_refs(load_data->input);
+    destroy_converter_data(load_data->input);
+    delete load_data;
+}
+
+static void complete_load_work(napi_env env, napi_status status, void* data) {
+    LoadData* load_data = static_cast<LoadData*>(data);
+    napi_value result;
+
+    if (load_data->animation) {
+        status = new_lottie_animation(env, load_data->animation, &result);
+        if (status != napi_ok) {
+            napi_create_string_utf8(env, "Failed to create LottieAnimation instance", NAPI_AUTO_LENGTH, &result);
+            napi_reject_deferred(env, load_data->deferred, result);
+        } else {
+            napi_resolve_deferred(env, load_data->deferred, result);
+        }
+    } else {
+        status = napi_create_string_utf8(env, load_data->error_msg.c_str(), NAPI_AUTO_LENGTH, &result);
+        if (status == napi_ok) {
+            napi_reject_deferred(env, load_data->deferred, result);
+        }
+    }
+
+    destroy_converter_data(load_data->input);
+    delete load_data;
+}
+
+napi_value loadAnimation(napi_env env, napi_callback_info info) {
+    size_t argc = 2;
+    napi_value args[2];
+    napi_status status = napi_get_cb_info(env, info, &argc, args, nullptr, nullptr);
+    CHECK_STATUS(env, status, "Failed to get callback info");
+
+    if (argc < 1) {
+        THROW_ERROR(env, "Expected at least 1 argument: Lottie JSON buffer");
+    }
+
+    std::string resource_path, animation_id;
+    const char* error = parse_load_options(env, argc, args, resource_path, animation_id);
+    if (error) {
+        THROW_ERROR(env, error);
+    }
+
+    ConverterData* input = create_converter_data(env, nullptr, 0);
+    error = get_converter_input(env, args[0], input, true);
+    if (error) {
+        destroy_converter_data(input);
+        THROW_ERROR(env, error);
+    }
+
+    LoadData* data = new LoadData();
+    data->env = env;
+    data->input = input;
+    data->resource_path = resource_path;
+    data->animation_id = animation_id;
+
+    napi_value promise;
+    status = napi_create_promise(env, &data->deferred, &promise);
+    if (status != napi_ok) {
+        destroy_converter_data(input);
+        delete data;
+        THROW_ERROR(env, "Failed to create promise");
+    }
+
+    status = queue_pool_work(env, execute_load_work, complete_load_work, abandon_load_work, data, JOB_PRIORITY_NORMAL, nullptr);
+    if (status != napi_ok) {
+        destroy_converter_data(input);
+        delete data;
+        THROW_ERROR(env, "Failed to queue async work");
+    }
+
+    return promise;
+}
+
+napi_value loadAnimationSync(napi_env env, napi_callback_info info) {
+    size_t argc = 2;
+    napi_value args[2];
+    napi_status status = napi_get_cb_info(env, info, &argc, args, nullptr, nullptr);
+    CHECK_STATUS(env, status, "Failed to get callback info");
+
+    if (argc < 1) {
+        THROW_ERROR(env, "Expected at least 1 argument: Lottie JSON buffer");
+    }
+
+    std::string resource_path, animation_id;
+    const char* error = parse_load_options(env, argc, args, resource_path, animation_id);
+    if (error) {
+        THROW_ERROR(env, error);
+    }
+
+    ConverterData* input = create_converter_data(env, nullptr, 0);
+    error = get_converter_input(env, args[0], input, false);
+    if (error) {
+        destroy_converter_data(input);
+        THROW_ERROR(env, error);
+    }
+
+    std::string error_msg;
+    std::shared_ptr<AnimationHandle> animation;
+    if (open_converter_input(input)) {
+        animation = load_cached_animation(input->in_data, input->in_size, resource_path, animation_id, error_msg);
+    } else {
+        error_msg = input->error_msg;
+    }
+    destroy_converter_data(input);
+    if (!animation) {
+        THROW_ERROR(env, error_msg.c_str());
+    }
+
+    napi_value result;
+    status = new_lottie_animation(env, animation, &result);
+    CHECK_STATUS(env, status, "Failed to create LottieAnimation instance");
+    return result;
+}
+
+napi_value openSharedAnimation(napi_env env, napi_callback_info info) {
+    uint32_t id;
+    if (!get_shared_animation_id(env, info, &id)) return nullptr;
+
+    std::shared_ptr<const AnimationSource> source = find_shared_animation(id);
+    if (!source) {
+        THROW_ERROR(env, "Unknown shared animation ID");
+    }
+    std::shared_ptr<AnimationHandle> animation = open_animation_handle(source);
+    if (!animation) {
+        THROW_ERROR(env, "Failed to load Lottie animation from provided JSON data");
+    }
+
+    napi_value result;
+    napi_status status = new_lottie_animation(env, animation, &result);
+    CHECK_STATUS(env, status, "Failed to create LottieAnimation instance");
+    return result;
+}
+
+napi_value releaseSharedAnimation(napi_env env, napi_callback_info info) {
+    uint32_t id;
+    if (!get_shared_animation_id(env, info, &id)) return nullptr;
+
+    napi_value result;
+    napi_status status = napi_get_boolean(env, release_shared_animation(id), &result);
+    CHECK_STATUS(env, status, "Failed to create boolean");
+    return result;
+}
\ No newline at end of file
@@ -0,0 +1,15 @@
+#ifndef LOTTIE_ANIMATION_H
+#define LOTTIE_ANIMATION_H
+
+#include <napi.h>
+#include <memory>
+#include "animation.h"
+
+napi_status define_lottie_animation_class(napi_env env, napi_value* result);
+napi_status new_lottie_animation(napi_env env, std::shared_ptr<AnimationHandle> animation, napi_value* result);
+napi_value loadAnimation(napi_env env, napi_callback_info info);
+napi_value loadAnimationSync(napi_env env, napi_callback_info info);
+napi_value openSharedAnimation(napi_env env, napi_callback_info info);
+napi_value releaseSharedAnimation(napi_env env, napi_callback_info info);
+
+#endif // LOTTIE_ANIMATION_H
\ No newline at end of file
@@ -0,0 +1,122 @@
+#include "mapped_file.h"
+#include <cstring>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile() : data_(nullptr), size_(0), open_(false) {
+#ifdef _WIN32
+    file_ = INVALID_HANDLE_VALUE;
+    mapping_ = nullptr;
+#endif
+}
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+#ifdef _WIN32
+
+bool MappedFile::open(const std::string& path, std::string& error_msg) {
+    close();
+    int length = MultiByteToWideChar(CP_UTF8, 0, path.c_str(), -1, nullptr, 0);
+    std::wstring wide(length > 0 ? length : 0, L'\0');
+    if (length <= 0 || !MultiByteToWideChar(CP_UTF8, 0, path.c_str(), -1, &wide[0], length)) {
+        error_msg = "Invalid animation path: " + path;
+        return false;
+    }
+
+    HANDLE file = CreateFileW(wide.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                              FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        error_msg = "Failed to open animation file: " + path;
+        return false;
+    }
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size)) {
+        CloseHandle(file);
+        error_msg = "Failed to read animation file: " + path;
+        return false;
+    }
+    file_ = file;
+    open_ = true;
+    // Empty files cannot be mapped; they fail to parse like an empty Buffer.
+    if (size.QuadPart == 0) return true;
+
+    mapping_ = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    const void* view = mapping_ ? MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0) : nullptr;
+    if (!view) {
+        close();
+        error_msg = "Failed to map animation file: " + path;
+        return false;
+    }
+    data_ = static_cast<const uint8_t*>(view);
+    size_ = (size_t)size.QuadPart;
+    return true;
+}
+
+void MappedFile::close() {
+    if (data_) UnmapViewOfFile(data_);
+    if (mapping_) CloseHandle(mapping_);
+    if (file_ != INVALID_HANDLE_VALUE) CloseHandle(file_);
+    data_ = nullptr;
+    size_ = 0;
+    open_ = false;
+    file_ = INVALID_HANDLE_VALUE;
+    mapping_ = nullptr;
+}
+
+#else
+
+bool MappedFile::open(const std::string& path, std::string& error_msg) {
+    close();
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        error_msg = "Failed to open animation file: " + path + " (" + strerror(errno) + ")";
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || !S_ISREG(info.st_mode)) {
+        ::close(fd);
+        error_msg = "Animation path is not a regular file: " + path;
+        return false;
+    }
+    open_ = true;
+    // Empty files cannot be mapped; they fail to parse like an empty Buffer.
+    if (info.st_size == 0) {
+        ::close(fd);
+        return true;
+    }
+
+    void* view = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    int map_errno = errno;
+    // The mapping keeps the file referenced on its own.
+    ::close(fd);
+    if (view == MAP_FAILED) {
+        open_ = false;
+        error_msg = "Failed to map animation file: " + path + " (" + strerror(map_errno) + ")";
+        return false;
+    }
+    // The decoder and the hash read the input front to back, once.
+    madvise(view, (size_t)info.st_size, MADV_SEQUENTIAL);
+    data_ = static_cast<const uint8_t*>(view);
+    size_ = (size_t)info.st_size;
+    return true;
+}
+
+void MappedFile::close() {
+    if (data_) munmap(const_cast<uint8_t*>(data_), size_);
+    data_ = nullptr;
+    size_ = 0;
+    open_ = false;
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,36 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// A read-only memory mapping of a whole file, so that large animations are
+// parsed from the page cache instead of being read into a JS Buffer first.
+// Pages are faulted in on first access, which happens on the thread that
+// decodes the input.
+class MappedFile {
+public:
+    MappedFile();
+    ~MappedFile();
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool open(const std::string& path, std::string& error_msg);
+    void close();
+
+    const uint8_t* data() const { return data_; }
+    size_t size() const { return size_; }
+    bool is_open() const { return open_; }
+
+private:
+    const uint8_t* data_;
+    size_t size_;
+    bool open_;
+#ifdef _WIN32
+    void* file_;
+    void* mapping_;
+#endif
+};
+
+#endif // MAPPED_FILE_H
\ No newline at end of file
@@ -0,0 +1,125 @@
+#include "metrics.h"
+#include <atomic>
+#include <chrono>
+
+// Bucket 0 holds everything under 2^li_HISTOGRAM_MIN_EXPONENT ns (~1us); each
+// power of two above it gets li_HISTOGRAM_SUB_BUCKETS buckets, up to ~18 min.
+#define li_HISTOGRAM_MIN_EXPONENT 10
+#define li_HISTOGRAM_MAX_EXPONENT 40
+#define li_HISTOGRAM_SUB_BITS 2
+#define li_HISTOGRAM_SUB_BUCKETS (1 << li_HISTOGRAM_SUB_BITS)
+#define li_HISTOGRAM_BUCKETS (1 + (li_HISTOGRAM_MAX_EXPONENT - li_HISTOGRAM_MIN_EXPONENT) * li_HISTOGRAM_SUB_BUCKETS)
+
+struct AtomicHistogram {
+    std::atomic<uint64_t> sum_ns{0};
+    std::atomic<uint64_t> max_ns{0};
+    std::atomic<uint64_t> buckets[li_HISTOGRAM_BUCKETS] = {};
+};
+
+static std::atomic<uint64_t> total_calls(0);
+static std::atomic<uint64_t> total_failures(0);
+static std::atomic<uint64_t> in_flight(0);
+static std::atomic<uint64_t> total_input_bytes(0);
+static std::atomic<uint64_t> total_output_bytes(0);
+static AtomicHistogram histograms[METRIC_STAGE_COUNT];
+
+static const char* const stage_names[METRIC_STAGE_COUNT] = {"queue", "parse", "render", "encode", "total"};
+
+static int floor_log2(uint64_t value) {
+    int exponent = 0;
+    while (value >>= 1) exponent++;
+    return exponent;
+}
+
+static size_t bucket_index(uint64_t ns) {
+    if (ns < (1ull << li_HISTOGRAM_MIN_EXPONENT)) return 0;
+    int exponent = floor_log2(ns);
+    if (exponent >= li_HISTOGRAM_MAX_EXPONENT) return li_HISTOGRAM_BUCKETS - 1;
+    size_t sub = (size_t)(ns >> (exponent - li_HISTOGRAM_SUB_BITS)) & (li_HISTOGRAM_SUB_BUCKETS - 1);
+    return 1 + (size_t)(exponent - li_HISTOGRAM_MIN_EXPONENT) * li_HISTOGRAM_SUB_BUCKETS + sub;
+}
+
+static uint64_t bucket_upper_ns(size_t index) {
+    if (index == 0) return 1ull << li_HISTOGRAM_MIN_EXPONENT;
+    int exponent = li_HISTOGRAM_MIN_EXPONENT + (int)((index - 1) / li_HISTOGRAM_SUB_BUCKETS);
+    uint64_t sub = (index - 1) % li_HISTOGRAM_SUB_BUCKETS;
+    return (li_HISTOGRAM_SUB_BUCKETS + sub + 1) << (exponent - li_HISTOGRAM_SUB_BITS);
+}
+
+static void record_latency(AtomicHistogram& histogram, uint64_t ns) {
+    histogram.sum_ns.fetch_add(ns, std::memory_order_relaxed);
+    histogram.buckets[bucket_index(ns)].fetch_add(1, std::memory_order_relaxed);
+    uint64_t max = histogram.max_ns.load(std::memory_order_relaxed);
+    while (ns > max && !histogram.max_ns.compare_exchange_weak(max, ns, std::memory_order_relaxed)) {
+    }
+}
+
+uint64_t metrics_now_ns() {
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+const char* metric_stage_name(MetricStage stage) {
+    return stage_names[stage];
+}
+
+void begin_frame_metrics() {
+    in_flight.fetch_add(1, std::memory_order_relaxed);
+}
+
+void end_frame_metrics(const FrameTimings& timings, bool success) {
+    in_flight.fetch_sub(1, std::memory_order_relaxed);
+    total_calls.fetch_add(1, std::memory_order_relaxed);
+    if (!success) {
+        total_failures.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    total_input_bytes.fetch_add(timings.input_bytes, std::memory_order_relaxed);
+    total_output_bytes.fetch_add(timings.output_bytes, std::memory_order_relaxed);
+    for (int stage = 0; stage < METRIC_STAGE_COUNT; stage++) {
+        // A stage that did not run is not a zero-latency sample.
+        if (timings.stage_ns[stage] == 0 && stage != METRIC_STAGE_TOTAL) continue;
+        record_latency(histograms[stage], timings.stage_ns[stage]);
+    }
+}
+
+MetricsSnapshot get_metrics_snapshot() {
+    MetricsSnapshot snapshot;
+    snapshot.calls = total_calls.load(std::memory_order_relaxed);
+    snapshot.failures = total_failures.load(std::memory_order_relaxed);
+    snapshot.in_flight = in_flight.load(std::memory_order_relaxed);
+    snapshot.input_bytes = total_input_bytes.load(std::memory_order_relaxed);
+    snapshot.output_bytes = total_output_bytes.load(std::memory_order_relaxed);
+
+    for (int stage = 0; stage < METRIC_STAGE_COUNT; stage++) {
+        AtomicHistogram& source = histograms[stage];
+        StageHistogram& histogram = snapshot.stages[stage];
+        histogram.count = 0;
+        histogram.sum_ns = source.sum_ns.load(std::memory_order_relaxed);
+        histogram.max_ns = source.max_ns.load(std::memory_order_relaxed);
+        // Counted from the buckets so that quantiles stay consistent with the
+        // count even while other threads are recording.
+        for (size_t i = 0; i < li_HISTOGRAM_BUCKETS; i++) {
+            uint64_t count = source.buckets[i].load(std::memory_order_relaxed);
+            if (count == 0) continue;
+            histogram.buckets.push_back(HistogramBucket{bucket_upper_ns(i), count});
+            histogram.count += count;
+        }
+    }
+    return snapshot;
+}
+
+uint64_t histogram_quantile(const StageHistogram& histogram, double quantile) {
+    if (histogram.count == 0) return 0;
+    uint64_t rank = (uint64_t)(quantile * histogram.count + 0.5);
+    if (rank < 1) rank = 1;
+    uint64_t seen = 0;
+    for (const HistogramBucket& bucket : histogram.buckets) {
+        seen += bucket.count;
+        if (seen >= rank) {
+            return bucket.upper_ns < histogram.max_ns ? bucket.upper_ns : histogram.max_ns;
+        }
+    }
+    return histogram.max_ns;
+}
\ No newline at end of file
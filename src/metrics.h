@@ -0,0 +1,61 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+enum MetricStage {
+    METRIC_STAGE_QUEUE,
+    METRIC_STAGE_PARSE,
+    METRIC_STAGE_RENDER,
+    METRIC_STAGE_ENCODE,
+    METRIC_STAGE_TOTAL,
+    METRIC_STAGE_COUNT
+};
+
+// Per-call breakdown of a single-frame export. Stages that did not run stay 0:
+// queue for synchronous calls, parse when the animation was already loaded.
+// "encode" is PNG compression, or pixel conversion for raw formats.
+struct FrameTimings {
+    uint64_t stage_ns[METRIC_STAGE_COUNT];
+    size_t input_bytes;
+    size_t output_bytes;
+    size_t surface_bytes;
+};
+
+struct HistogramBucket {
+    uint64_t upper_ns;
+    uint64_t count;
+};
+
+struct StageHistogram {
+    uint64_t count;
+    uint64_t sum_ns;
+    uint64_t max_ns;
+    // Non-empty buckets only, in ascending order.
+    std::vector<HistogramBucket> buckets;
+};
+
+struct MetricsSnapshot {
+    uint64_t calls;
+    uint64_t failures;
+    uint64_t in_flight;
+    uint64_t input_bytes;
+    uint64_t output_bytes;
+    StageHistogram stages[METRIC_STAGE_COUNT];
+};
+
+uint64_t metrics_now_ns();
+const char* metric_stage_name(MetricStage stage);
+
+// Process-wide counters, updated with relaxed atomics only so that recording
+// never blocks a render. Latencies go into log-linear histograms with four
+// buckets per power of two, i.e. within 25% of the true value.
+void begin_frame_metrics();
+void end_frame_metrics(const FrameTimings& timings, bool success);
+MetricsSnapshot get_metrics_snapshot();
+// Smallest bucket bound at or above the given quantile (0-1), capped at max_ns.
+uint64_t histogram_quantile(const StageHistogram& histogram, double quantile);
+
+#endif // METRICS_H
\ No newline at end of file
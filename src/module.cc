@@ -1,20 +1,59 @@
 #include <napi.h>
+#include "addon.h"
+#include "apng.h"
+#include "batch.h"
 #include "exports.h"
+#include "lottie_animation.h"
+#include "probe.h"
+#include "spritesheet.h"
+#include "stream.h"
+
+#define ln_EXPORT_ATTRIBUTES (napi_property_attributes)(napi_writable | napi_enumerable | napi_configurable)
+#define EXPORT_FUNCTION(name) {#name, nullptr, name, nullptr, nullptr, nullptr, ln_EXPORT_ATTRIBUTES, nullptr}
 
 napi_value init(napi_env env, napi_value exports) {
     napi_status status;
 
-    napi_value exportFrame_fn, exportFrameSync_fn;
-    status = napi_create_function(env, "exportFrame", NAPI_AUTO_LENGTH, exportFrame, nullptr, &exportFrame_fn);
+    // Runs once per environment; with worker threads the addon is loaded
+    // into each of them and shares one native process state.
+    status = create_addon_data(env);
     if (status != napi_ok) return nullptr;
 
-    status = napi_create_function(env, "exportFrameSync", NAPI_AUTO_LENGTH, exportFrameSync, nullptr, &exportFrameSync_fn);
+    napi_value LottieAnimation_class;
+    status = define_lottie_animation_class(env, &LottieAnimation_class);
     if (status != napi_ok) return nullptr;
 
-    status = napi_set_named_property(env, exports, "exportFrame", exportFrame_fn);
-    if (status != napi_ok) return nullptr;
+    napi_property_descriptor properties[] = {
+        EXPORT_FUNCTION(exportFrame),
+        EXPORT_FUNCTION(exportFrameSync),
+        EXPORT_FUNCTION(exportFrames),
+        EXPORT_FUNCTION(exportAnimation),
+        EXPORT_FUNCTION(exportSpriteSheet),
+        EXPORT_FUNCTION(createFrameStream),
+        EXPORT_FUNCTION(ackFrameStream),
+        EXPORT_FUNCTION(cancelFrameStream),
+        EXPORT_FUNCTION(loadAnimation),
+        EXPORT_FUNCTION(loadAnimationSync),
+        EXPORT_FUNCTION(openSharedAnimation),
+        EXPORT_FUNCTION(releaseSharedAnimation),
+        EXPORT_FUNCTION(probe),
+        EXPORT_FUNCTION(probeSync),
+        EXPORT_FUNCTION(configureAnimationCache),
+        EXPORT_FUNCTION(clearAnimationCache),
+        EXPORT_FUNCTION(getAnimationCacheStats),
+        EXPORT_FUNCTION(configureFrameCache),
+        EXPORT_FUNCTION(clearFrameCache),
+        EXPORT_FUNCTION(getFrameCacheStats),
+        EXPORT_FUNCTION(getBufferPoolStats),
+        EXPORT_FUNCTION(setConcurrency),
+        EXPORT_FUNCTION(getQueueStats),
+        EXPORT_FUNCTION(createCancelToken),
+        EXPORT_FUNCTION(cancelToken),
+        EXPORT_FUNCTION(getStats),
+        {"LottieAnimation", nullptr, nullptr, nullptr, nullptr, LottieAnimation_class, ln_EXPORT_ATTRIBUTES, nullptr},
+    };
 
-    status = napi_set_named_property(env, exports, "exportFrameSync", exportFrameSync_fn);
+    status = napi_define_properties(env, exports, sizeof(properties) / sizeof(properties[0]), properties);
     if (status != napi_ok) return nullptr;
 
     return exports;
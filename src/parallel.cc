@@ -0,0 +1,62 @@
+#include "parallel.h"
+#include <atomic>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+static std::atomic<ParallelRunner> parallel_runner(nullptr);
+
+size_t default_concurrency() {
+    unsigned int threads = std::thread::hardware_concurrency();
+    return threads ? threads : 1;
+}
+
+void set_parallel_runner(ParallelRunner runner) {
+    parallel_runner.store(runner);
+}
+
+static void run_on_threads(size_t helpers, const std::function<void(size_t worker)>& fn) {
+    std::vector<std::thread> threads;
+    threads.reserve(helpers);
+    for (size_t worker = 1; worker <= helpers; worker++) {
+        try {
+            threads.emplace_back(fn, worker);
+        } catch (const std::system_error&) {
+            // Out of threads: the ones already started pick up the remaining work.
+            break;
+        }
+    }
+    fn(0);
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+}
+
+bool parallel_for(size_t count, size_t concurrency, const std::function<bool(size_t worker, size_t index)>& fn) {
+    if (concurrency > count) concurrency = count;
+    if (concurrency == 0) return true;
+
+    std::atomic<size_t> next(0);
+    std::atomic<bool> ok(true);
+
+    auto run = [&](size_t worker) {
+        while (ok.load(std::memory_order_relaxed)) {
+            size_t index = next.fetch_add(1, std::memory_order_relaxed);
+            if (index >= count) break;
+            if (!fn(worker, index)) {
+                ok.store(false, std::memory_order_relaxed);
+            }
+        }
+    };
+
+    ParallelRunner runner = parallel_runner.load();
+    if (concurrency == 1) {
+        run(0);
+    } else if (runner) {
+        runner(concurrency - 1, run);
+    } else {
+        run_on_threads(concurrency - 1, run);
+    }
+
+    return ok.load();
+}
\ No newline at end of file
@@ -0,0 +1,24 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <cstddef>
+#include <functional>
+
+size_t default_concurrency();
+
+// Runs fn(0) on the calling thread and fn(1) to fn(helpers) on whatever other
+// threads the runner has to spare, returning once every call that started has
+// returned. Calls that never found a thread are simply skipped.
+typedef void (*ParallelRunner)(size_t helpers, const std::function<void(size_t worker)>& fn);
+
+// The addon routes parallel_for onto its worker pool. Without a runner, as in
+// the native benchmark, parallel_for starts threads of its own.
+void set_parallel_runner(ParallelRunner runner);
+
+// Calls fn(worker, index) for every index in [0, count) on up to `concurrency`
+// threads, the calling thread included. `worker` is stable per thread, so callers
+// can keep per-thread state in a vector of `concurrency` slots. Once fn returns
+// false no further indices are started and parallel_for returns false.
+bool parallel_for(size_t count, size_t concurrency, const std::function<bool(size_t worker, size_t index)>& fn);
+
+#endif // PARALLEL_H
\ No newline at end of file
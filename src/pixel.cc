@@ -0,0 +1,253 @@
+#include "pixel.h"
+#include <utility>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define PIXEL_X86 1
+#include <emmintrin.h>
+#if defined(__GNUC__) || defined(__clang__)
+#define PIXEL_AVX2 1
+#include <immintrin.h>
+#endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define PIXEL_NEON 1
+#include <arm_neon.h>
+#endif
+
+static inline uint8_t unpremultiply(uint32_t c, uint32_t a) {
+    uint32_t v = (c * 255 + a / 2) / a;
+    return (uint8_t)(v > 255 ? 255 : v);
+}
+
+// BGRA kernels differ from RGBA ones only in where red and blue are stored.
+template <bool kBgra>
+static void convert_scalar(const uint32_t* src, uint8_t* dst, size_t count) {
+    const int r_index = kBgra ? 2 : 0;
+    const int b_index = kBgra ? 0 : 2;
+    for (size_t i = 0; i < count; i++) {
+        uint32_t p = src[i];
+        uint32_t a = p >> 24;
+        uint8_t* out = dst + i * 4;
+        if (a == 255) {
+            out[r_index] = (uint8_t)(p >> 16);
+            out[1] = (uint8_t)(p >> 8);
+            out[b_index] = (uint8_t)p;
+            out[3] = 255;
+        } else if (a == 0) {
+            out[0] = out[1] = out[2] = out[3] = 0;
+        } else {
+            out[r_index] = unpremultiply((p >> 16) & 0xFF, a);
+            out[1] = unpremultiply((p >> 8) & 0xFF, a);
+            out[b_index] = unpremultiply(p & 0xFF, a);
+            out[3] = (uint8_t)a;
+        }
+    }
+}
+
+void premultiplied_argb_to_rgba_scalar(const uint32_t* src, uint8_t* dst, size_t count) {
+    convert_scalar<false>(src, dst, count);
+}
+
+void premultiplied_argb_to_bgra_scalar(const uint32_t* src, uint8_t* dst, size_t count) {
+    convert_scalar<true>(src, dst, count);
+}
+
+// The vector kernels divide in single precision. (c * 255 + a / 2) is below 2^16,
+// and a non-integer quotient is at least 1/255 away from the next integer, so
+// truncating the correctly rounded float quotient gives the exact integer result.
+
+#ifdef PIXEL_X86
+static inline __m128i swizzle_sse2(__m128i p) {
+    const __m128i mask_ag = _mm_set1_epi32((int)0xFF00FF00);
+    const __m128i mask_lo = _mm_set1_epi32(0xFF);
+    __m128i r = _mm_and_si128(_mm_srli_epi32(p, 16), mask_lo);
+    __m128i b = _mm_slli_epi32(_mm_and_si128(p, mask_lo), 16);
+    return _mm_or_si128(_mm_and_si128(p, mask_ag), _mm_or_si128(r, b));
+}
+
+static inline __m128i unpremultiply_channel_sse2(__m128i c, __m128 num_bias, __m128 alpha) {
+    __m128 num = _mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(c), _mm_set1_ps(255.0f)), num_bias);
+    __m128 q = _mm_min_ps(_mm_div_ps(num, alpha), _mm_set1_ps(255.0f));
+    return _mm_cvttps_epi32(q);
+}
+
+template <bool kBgra>
+static void convert_sse2(const uint32_t* src, uint8_t* dst, size_t count) {
+    const __m128i mask_lo = _mm_set1_epi32(0xFF);
+    const __m128i opaque = _mm_set1_epi32((int)0xFF000000);
+    const __m128i zero = _mm_setzero_si128();
+    size_t i = 0;
+
+    for (; i + 4 <= count; i += 4) {
+        __m128i p = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        __m128i a = _mm_and_si128(p, opaque);
+        int opaque_mask = _mm_movemask_epi8(_mm_cmpeq_epi32(a, opaque));
+        if (opaque_mask == 0xFFFF) {
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 4), kBgra ? p : swizzle_sse2(p));
+            continue;
+        }
+        if (_mm_movemask_epi8(_mm_cmpeq_epi32(a, zero)) == 0xFFFF) {
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 4), zero);
+            continue;
+        }
+
+        __m128i a_int = _mm_srli_epi32(p, 24);
+        __m128 alpha = _mm_cvtepi32_ps(a_int);
+        __m128 bias = _mm_cvtepi32_ps(_mm_srli_epi32(a_int, 1));
+        __m128i keep = _mm_xor_si128(_mm_cmpeq_epi32(a_int, zero), _mm_set1_epi32(-1));
+
+        __m128i r = unpremultiply_channel_sse2(_mm_and_si128(_mm_srli_epi32(p, 16), mask_lo), bias, alpha);
+        __m128i g = unpremultiply_channel_sse2(_mm_and_si128(_mm_srli_epi32(p, 8), mask_lo), bias, alpha);
+        __m128i b = unpremultiply_channel_sse2(_mm_and_si128(p, mask_lo), bias, alpha);
+
+        if (kBgra) std::swap(r, b);
+        __m128i out = _mm_or_si128(_mm_or_si128(r, _mm_slli_epi32(g, 8)), _mm_or_si128(_mm_slli_epi32(b, 16), a));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 4), _mm_and_si128(out, keep));
+    }
+
+    convert_scalar<kBgra>(src + i, dst + i * 4, count - i);
+}
+#endif
+
+#ifdef PIXEL_AVX2
+__attribute__((target("avx2")))
+static inline __m256i unpremultiply_channel_avx2(__m256i c, __m256 num_bias, __m256 alpha) {
+    __m256 num = _mm256_add_ps(_mm256_mul_ps(_mm256_cvtepi32_ps(c), _mm256_set1_ps(255.0f)), num_bias);
+    __m256 q = _mm256_min_ps(_mm256_div_ps(num, alpha), _mm256_set1_ps(255.0f));
+    return _mm256_cvttps_epi32(q);
+}
+
+template <bool kBgra>
+__attribute__((target("avx2")))
+static void convert_avx2(const uint32_t* src, uint8_t* dst, size_t count) {
+    const __m256i shuffle = _mm256_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15,
+                                             2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+    const __m256i mask_lo = _mm256_set1_epi32(0xFF);
+    const __m256i opaque = _mm256_set1_epi32((int)0xFF000000);
+    const __m256i zero = _mm256_setzero_si256();
+    size_t i = 0;
+
+    for (; i + 8 <= count; i += 8) {
+        __m256i p = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+        __m256i a = _mm256_and_si256(p, opaque);
+        if (_mm256_movemask_epi8(_mm256_cmpeq_epi32(a, opaque)) == -1) {
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i * 4), kBgra ? p : _mm256_shuffle_epi8(p, shuffle));
+            continue;
+        }
+        if (_mm256_movemask_epi8(_mm256_cmpeq_epi32(a, zero)) == -1) {
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i * 4), zero);
+            continue;
+        }
+
+        __m256i a_int = _mm256_srli_epi32(p, 24);
+        __m256 alpha = _mm256_cvtepi32_ps(a_int);
+        __m256 bias = _mm256_cvtepi32_ps(_mm256_srli_epi32(a_int, 1));
+        __m256i keep = _mm256_xor_si256(_mm256_cmpeq_epi32(a_int, zero), _mm256_set1_epi32(-1));
+
+        __m256i r = unpremultiply_channel_avx2(_mm256_and_si256(_mm256_srli_epi32(p, 16), mask_lo), bias, alpha);
+        __m256i g = unpremultiply_channel_avx2(_mm256_and_si256(_mm256_srli_epi32(p, 8), mask_lo), bias, alpha);
+        __m256i b = unpremultiply_channel_avx2(_mm256_and_si256(p, mask_lo), bias, alpha);
+
+        if (kBgra) std::swap(r, b);
+        __m256i out = _mm256_or_si256(_mm256_or_si256(r, _mm256_slli_epi32(g, 8)), _mm256_or_si256(_mm256_slli_epi32(b, 16), a));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i * 4), _mm256_and_si256(out, keep));
+    }
+
+    convert_sse2<kBgra>(src + i, dst + i * 4, count - i);
+}
+#endif
+
+#ifdef PIXEL_NEON
+static inline uint8x16_t unpremultiply_plane_neon(uint8x16_t c, uint8x16_t a) {
+    const float32x4_t max_value = vdupq_n_f32(255.0f);
+    uint16x8_t c16[2] = {vmovl_u8(vget_low_u8(c)), vmovl_u8(vget_high_u8(c))};
+    uint16x8_t a16[2] = {vmovl_u8(vget_low_u8(a)), vmovl_u8(vget_high_u8(a))};
+    uint16x4_t out[4];
+
+    for (int half = 0; half < 2; half++) {
+        uint32x4_t cs[2] = {vmovl_u16(vget_low_u16(c16[half])), vmovl_u16(vget_high_u16(c16[half]))};
+        uint32x4_t as[2] = {vmovl_u16(vget_low_u16(a16[half])), vmovl_u16(vget_high_u16(a16[half]))};
+        for (int quarter = 0; quarter < 2; quarter++) {
+            float32x4_t alpha = vcvtq_f32_u32(as[quarter]);
+            float32x4_t num = vaddq_f32(vmulq_f32(vcvtq_f32_u32(cs[quarter]), max_value), vcvtq_f32_u32(vshrq_n_u32(as[quarter], 1)));
+            uint32x4_t q = vcvtq_u32_f32(vminq_f32(vdivq_f32(num, alpha), max_value));
+            q = vbicq_u32(q, vceqq_u32(as[quarter], vdupq_n_u32(0)));
+            out[half * 2 + quarter] = vmovn_u32(q);
+        }
+    }
+
+    return vcombine_u8(vmovn_u16(vcombine_u16(out[0], out[1])), vmovn_u16(vcombine_u16(out[2], out[3])));
+}
+
+template <bool kBgra>
+static void convert_neon(const uint32_t* src, uint8_t* dst, size_t count) {
+    size_t i = 0;
+
+    for (; i + 16 <= count; i += 16) {
+        // Little-endian ARGB32 is stored as B, G, R, A bytes.
+        uint8x16x4_t bgra = vld4q_u8(reinterpret_cast<const uint8_t*>(src + i));
+        uint8x16x4_t out;
+        const int r_index = kBgra ? 2 : 0;
+        const int b_index = kBgra ? 0 : 2;
+        out.val[3] = bgra.val[3];
+        if (vminvq_u8(bgra.val[3]) == 255) {
+            out.val[r_index] = bgra.val[2];
+            out.val[1] = bgra.val[1];
+            out.val[b_index] = bgra.val[0];
+        } else {
+            out.val[r_index] = unpremultiply_plane_neon(bgra.val[2], bgra.val[3]);
+            out.val[1] = unpremultiply_plane_neon(bgra.val[1], bgra.val[3]);
+            out.val[b_index] = unpremultiply_plane_neon(bgra.val[0], bgra.val[3]);
+        }
+        vst4q_u8(dst + i * 4, out);
+    }
+
+    convert_scalar<kBgra>(src + i, dst + i * 4, count - i);
+}
+#endif
+
+static PixelKernel select_kernel() {
+#ifdef PIXEL_AVX2
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return {convert_avx2<false>, convert_avx2<true>, "avx2"};
+#endif
+#ifdef PIXEL_X86
+    return {convert_sse2<false>, convert_sse2<true>, "sse2"};
+#elif defined(PIXEL_NEON)
+    return {convert_neon<false>, convert_neon<true>, "neon"};
+#else
+    return {convert_scalar<false>, convert_scalar<true>, "scalar"};
+#endif
+}
+
+static const PixelKernel& kernel() {
+    static const PixelKernel selected = select_kernel();
+    return selected;
+}
+
+void premultiplied_argb_to_rgba(const uint32_t* src, uint8_t* dst, size_t count) {
+    kernel().to_rgba(src, dst, count);
+}
+
+void premultiplied_argb_to_bgra(const uint32_t* src, uint8_t* dst, size_t count) {
+    kernel().to_bgra(src, dst, count);
+}
+
+const char* pixel_kernel_name() {
+    return kernel().name;
+}
+
+std::vector<PixelKernel> supported_pixel_kernels() {
+    std::vector<PixelKernel> kernels;
+    kernels.push_back({convert_scalar<false>, convert_scalar<true>, "scalar"});
+#ifdef PIXEL_X86
+    kernels.push_back({convert_sse2<false>, convert_sse2<true>, "sse2"});
+#endif
+#ifdef PIXEL_AVX2
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) kernels.push_back({convert_avx2<false>, convert_avx2<true>, "avx2"});
+#endif
+#ifdef PIXEL_NEON
+    kernels.push_back({convert_neon<false>, convert_neon<true>, "neon"});
+#endif
+    return kernels;
+}
\ No newline at end of file
@@ -0,0 +1,31 @@
+#ifndef PIXEL_H
+#define PIXEL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Converts rlottie's premultiplied ARGB32 pixels to straight (un-premultiplied)
+// RGBA bytes. Picks an SSE2, AVX2 or NEON kernel at runtime; every kernel
+// produces exactly the same bytes as the scalar reference:
+//   c' = min(255, (c * 255 + a / 2) / a), and 0 when a == 0.
+// The BGRA variants store blue first. src and dst may be the same memory.
+void premultiplied_argb_to_rgba(const uint32_t* src, uint8_t* dst, size_t count);
+void premultiplied_argb_to_bgra(const uint32_t* src, uint8_t* dst, size_t count);
+void premultiplied_argb_to_rgba_scalar(const uint32_t* src, uint8_t* dst, size_t count);
+void premultiplied_argb_to_bgra_scalar(const uint32_t* src, uint8_t* dst, size_t count);
+const char* pixel_kernel_name();
+
+typedef void (*ConvertKernel)(const uint32_t* src, uint8_t* dst, size_t count);
+
+struct PixelKernel {
+    ConvertKernel to_rgba;
+    ConvertKernel to_bgra;
+    const char* name;
+};
+
+// Every kernel this build can run on this CPU, the scalar reference first, so
+// tests can check each one and not just the one picked at runtime.
+std::vector<PixelKernel> supported_pixel_kernels();
+
+#endif // PIXEL_H
\ No newline at end of file
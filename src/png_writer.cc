@@ -1,27 +1,74 @@
 #include "png_writer.h"
+#include "buffer_pool.h"
+#include "parallel.h"
+#include "pixel.h"
+#include <algorithm>
 #include <cstring>
+#include <vector>
+#include <zlib.h>
 
 #define lp_COLOR_BYTES 4
+#define li_PNG_OVERHEAD 1024
+#define li_MIN_STRIP_BYTES (256 * 1024)
+#define li_DEFLATE_WINDOW 32768
+#define li_DEFLATE_MEM_LEVEL 8
 
-bool write_png(ConverterData* data, uint32_t* buffer) {
-    struct PngBuffer {
-        byte* buffer;
-        size_t size;
-        size_t capacity;
-    } png_data = {nullptr, 0, 0};
+static const byte png_signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+
+static bool reserve_png_buffer(PngBuffer* buf, size_t capacity) {
+    byte* new_buffer = (byte*)realloc(buf->buffer, capacity);
+    if (!new_buffer) return false;
+    count_output_allocation();
+    buf->buffer = new_buffer;
+    buf->capacity = capacity;
+    return true;
+}
+
+// Level 0 stores the filtered rows verbatim; otherwise start from a guess that
+// fits typical flat Lottie art and let the buffer double from there.
+static size_t estimate_png_size(int width, int height, int compression_level) {
+    size_t raw_size = ((size_t)width * lp_COLOR_BYTES + 1) * height;
+    if (compression_level == 0) {
+        return raw_size + raw_size / 65535 * 5 + li_PNG_OVERHEAD;
+    }
+    return raw_size / 8 + li_PNG_OVERHEAD;
+}
+
+static int zlib_strategy(const PngOptions& options) {
+    switch (options.strategy) {
+        case PNG_STRATEGY_FILTERED: return Z_FILTERED;
+        case PNG_STRATEGY_HUFFMAN: return Z_HUFFMAN_ONLY;
+        case PNG_STRATEGY_RLE: return Z_RLE;
+        default:
+            // libpng's own default.
+            return options.filter == PNG_FILTER_MODE_NONE ? Z_DEFAULT_STRATEGY : Z_FILTERED;
+    }
+}
+
+static int libpng_filter_flags(PngFilterMode mode) {
+    switch (mode) {
+        case PNG_FILTER_MODE_NONE: return PNG_FILTER_NONE;
+        case PNG_FILTER_MODE_SUB: return PNG_FILTER_SUB;
+        case PNG_FILTER_MODE_UP: return PNG_FILTER_UP;
+        case PNG_FILTER_MODE_AVERAGE: return PNG_FILTER_AVG;
+        case PNG_FILTER_MODE_PAETH: return PNG_FILTER_PAETH;
+        default: return PNG_ALL_FILTERS;
+    }
+}
+
+static bool encode_png_single(const byte* rgba, int width, int height, const PngOptions& options,
+                              byte** out_buffer, size_t* out_size, std::string& error_msg) {
+    PngBuffer png_data = {nullptr, 0, 0};
 
     auto write_func = [](png_structp png_ptr, png_bytep data, png_size_t length) {
         PngBuffer* buf = (PngBuffer*)png_get_io_ptr(png_ptr);
         if (buf->size + length > buf->capacity) {
             size_t new_capacity = buf->capacity == 0 ? 1024 : buf->capacity * 2;
             while (new_capacity < buf->size + length) new_capacity *= 2;
-            byte* new_buffer = (byte*)realloc(buf->buffer, new_capacity);
-            if (!new_buffer) {
+            if (!reserve_png_buffer(buf, new_capacity)) {
                 png_error(png_ptr, "Failed to allocate memory for PNG");
                 return;
             }
-            buf->buffer = new_buffer;
-            buf->capacity = new_capacity;
         }
         memcpy(buf->buffer + buf->size, data, length);
         buf->size += length;
@@ -29,71 +76,599 @@ bool write_png(ConverterData* data, uint32_t* buffer) {
 
     auto flush_func = [](png_structp png_ptr) {};
 
+    ScratchBuffer rows((size_t)height * sizeof(byte*));
+    if (!rows) {
+        error_msg = "Failed to allocate row buffer";
+        return false;
+    }
+
+    byte** row_pointers = reinterpret_cast<byte**>(rows.data());
+    for (int y = 0; y < height; y++) {
+        row_pointers[y] = const_cast<byte*>(rgba) + (size_t)y * width * lp_COLOR_BYTES;
+    }
+
+    if (!reserve_png_buffer(&png_data, estimate_png_size(width, height, options.compression_level))) {
+        error_msg = "Failed to allocate memory for PNG";
+        return false;
+    }
+
     png_structp png_ptr = png_create_write_struct(PNG_LIBPNG_VER_STRING, nullptr, nullptr, nullptr);
     if (!png_ptr) {
-        data->error_msg = "Failed to create PNG write struct";
+        free(png_data.buffer);
+        error_msg = "Failed to create PNG write struct";
         return false;
     }
 
     png_infop info_ptr = png_create_info_struct(png_ptr);
     if (!info_ptr) {
         png_destroy_write_struct(&png_ptr, nullptr);
-        data->error_msg = "Failed to create PNG info struct";
+        free(png_data.buffer);
+        error_msg = "Failed to create PNG info struct";
         return false;
     }
 
     if (setjmp(png_jmpbuf(png_ptr))) {
         png_destroy_write_struct(&png_ptr, &info_ptr);
         free(png_data.buffer);
-        data->error_msg = "Error during PNG creation";
+        error_msg = "Error during PNG creation";
         return false;
     }
 
     png_set_write_fn(png_ptr, &png_data, write_func, flush_func);
-    png_set_IHDR(png_ptr, info_ptr, data->width, data->height, 8, PNG_COLOR_TYPE_RGBA,
+    png_set_IHDR(png_ptr, info_ptr, width, height, 8, PNG_COLOR_TYPE_RGBA,
                  PNG_INTERLACE_NONE, PNG_COMPRESSION_TYPE_DEFAULT, PNG_FILTER_TYPE_DEFAULT);
+    png_set_compression_level(png_ptr, options.compression_level);
+    if (options.filter != PNG_FILTER_MODE_ADAPTIVE) {
+        png_set_filter(png_ptr, PNG_FILTER_TYPE_BASE, libpng_filter_flags(options.filter));
+    }
+    if (options.strategy != PNG_STRATEGY_DEFAULT) {
+        png_set_compression_strategy(png_ptr, zlib_strategy(options));
+    }
 
-    int compression_level = (int)((1.0f - data->quality) * 9);
-    png_set_compression_level(png_ptr, compression_level);
+    png_set_rows(png_ptr, info_ptr, row_pointers);
+    png_write_png(png_ptr, info_ptr, PNG_TRANSFORM_IDENTITY, nullptr);
 
-    byte** row_pointers = (byte**)malloc(data->height * sizeof(byte*));
-    if (!row_pointers) {
-        png_destroy_write_struct(&png_ptr, &info_ptr);
-        free(png_data.buffer);
-        data->error_msg = "Failed to allocate row pointers";
+    png_destroy_write_struct(&png_ptr, &info_ptr);
+
+    // The buffer is handed to JS as is, so give back a generous over-estimate.
+    if (png_data.capacity - png_data.size > png_data.capacity / 4) {
+        byte* shrunk = (byte*)realloc(png_data.buffer, png_data.size);
+        if (shrunk) png_data.buffer = shrunk;
+    }
+
+    *out_buffer = png_data.buffer;
+    *out_size = png_data.size;
+    return true;
+}
+
+// PNG row filters for 4 bytes per pixel. `prev` is the unfiltered previous
+// row, all zeros for the first row.
+static inline byte paeth_predictor(int a, int b, int c) {
+    int p = a + b - c;
+    int pa = abs(p - a);
+    int pb = abs(p - b);
+    int pc = abs(p - c);
+    if (pa <= pb && pa <= pc) return (byte)a;
+    if (pb <= pc) return (byte)b;
+    return (byte)c;
+}
+
+static void filter_row(int type, const byte* row, const byte* prev, size_t length, byte* out) {
+    size_t i = 0;
+    switch (type) {
+        case 1:
+            for (; i < lp_COLOR_BYTES; i++) out[i] = row[i];
+            for (; i < length; i++) out[i] = row[i] - row[i - lp_COLOR_BYTES];
+            break;
+        case 2:
+            for (; i < length; i++) out[i] = row[i] - prev[i];
+            break;
+        case 3:
+            for (; i < lp_COLOR_BYTES; i++) out[i] = row[i] - (prev[i] >> 1);
+            for (; i < length; i++) out[i] = row[i] - ((row[i - lp_COLOR_BYTES] + prev[i]) >> 1);
+            break;
+        case 4:
+            for (; i < lp_COLOR_BYTES; i++) out[i] = row[i] - paeth_predictor(0, prev[i], 0);
+            for (; i < length; i++) {
+                out[i] = row[i] - paeth_predictor(row[i - lp_COLOR_BYTES], prev[i], prev[i - lp_COLOR_BYTES]);
+            }
+            break;
+        default:
+            memcpy(out, row, length);
+            break;
+    }
+}
+
+// The minimum sum of absolute differences heuristic, as libpng uses for
+// adaptive filtering.
+static size_t filtered_row_cost(const byte* row, size_t length) {
+    size_t sum = 0;
+    for (size_t i = 0; i < length; i++) {
+        sum += row[i] < 128 ? row[i] : 256 - row[i];
+    }
+    return sum;
+}
+
+static void filter_png_row(PngFilterMode mode, const byte* row, const byte* prev, size_t length, byte* out, byte* candidate) {
+    if (mode != PNG_FILTER_MODE_ADAPTIVE) {
+        int type = mode - PNG_FILTER_MODE_NONE;
+        out[0] = (byte)type;
+        filter_row(type, row, prev, length, out + 1);
+        return;
+    }
+
+    out[0] = 0;
+    filter_row(0, row, prev, length, out + 1);
+    size_t best_cost = filtered_row_cost(out + 1, length);
+    for (int type = 1; type <= 4; type++) {
+        filter_row(type, row, prev, length, candidate);
+        size_t cost = filtered_row_cost(candidate, length);
+        if (cost < best_cost) {
+            best_cost = cost;
+            out[0] = (byte)type;
+            memcpy(out + 1, candidate, length);
+        }
+    }
+}
+
+struct PngStrip {
+    size_t first_row;
+    size_t row_count;
+    std::vector<byte> deflated;
+    uLong adler;
+};
+
+static bool deflate_strip(const byte* filtered, size_t offset, size_t length, bool last,
+                          const PngOptions& options, PngStrip& strip) {
+    z_stream stream;
+    memset(&stream, 0, sizeof(stream));
+    if (deflateInit2(&stream, options.compression_level, Z_DEFLATED, -15, li_DEFLATE_MEM_LEVEL, zlib_strategy(options)) != Z_OK) {
         return false;
     }
 
-    byte* byte_buffer_raw = reinterpret_cast<byte*>(buffer);
-    for (int y = 0; y < data->height; y++) {
-        row_pointers[y] = (byte*)malloc(data->width * lp_COLOR_BYTES);
-        if (!row_pointers[y]) {
-            for (int i = 0; i < y; i++) free(row_pointers[i]);
-            free(row_pointers);
-            png_destroy_write_struct(&png_ptr, &info_ptr);
-            free(png_data.buffer);
-            data->error_msg = "Failed to allocate row buffer";
+    // Priming each strip with the tail of the one before it keeps matches
+    // across strip boundaries, so the ratio stays close to a single stream.
+    if (offset > 0) {
+        size_t dictionary = std::min((size_t)li_DEFLATE_WINDOW, offset);
+        deflateSetDictionary(&stream, filtered + offset - dictionary, (uInt)dictionary);
+    }
+
+    strip.deflated.resize(deflateBound(&stream, length) + 16);
+    stream.next_in = const_cast<byte*>(filtered + offset);
+    stream.avail_in = (uInt)length;
+    stream.next_out = strip.deflated.data();
+    stream.avail_out = (uInt)strip.deflated.size();
+
+    // Inner strips end on a byte boundary with a sync flush so that the raw
+    // deflate streams can simply be concatenated.
+    int flush = last ? Z_FINISH : Z_SYNC_FLUSH;
+    bool ok = true;
+    for (;;) {
+        if (stream.avail_out == 0) {
+            size_t used = strip.deflated.size();
+            strip.deflated.resize(used * 2);
+            stream.next_out = strip.deflated.data() + used;
+            stream.avail_out = (uInt)(strip.deflated.size() - used);
+        }
+        int ret = deflate(&stream, flush);
+        if (ret == Z_STREAM_END) break;
+        if (ret != Z_OK && ret != Z_BUF_ERROR) {
+            ok = false;
+            break;
+        }
+        if (!last && stream.avail_in == 0 && stream.avail_out != 0) break;
+    }
+
+    strip.deflated.resize(stream.total_out);
+    strip.adler = adler32(adler32(0L, Z_NULL, 0), filtered + offset, (uInt)length);
+    deflateEnd(&stream);
+    return ok;
+}
+
+// "png-fast" deflate: fixed-Huffman blocks holding literals and distance-1
+// matches only. After the sub filter, flat fills and transparent areas are
+// long runs of zeros, which this finds with word compares and no hash chains;
+// everything else costs 8 or 9 bits a byte.
+struct FastDeflateCodes {
+    // Bit-reversed so they can be written LSB first.
+    uint16_t literal_code[256];
+    uint8_t literal_bits[256];
+    // Length symbol, length extra bits and the 5-bit zero distance code.
+    uint32_t match_code[259];
+    uint8_t match_bits[259];
+};
+
+static uint32_t reverse_bits(uint32_t code, int length) {
+    uint32_t reversed = 0;
+    for (int i = 0; i < length; i++) {
+        reversed = (reversed << 1) | (code & 1);
+        code >>= 1;
+    }
+    return reversed;
+}
+
+static FastDeflateCodes build_fast_deflate_codes() {
+    static const uint16_t length_base[29] = {3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+                                             35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+    static const uint8_t length_extra[29] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+                                             3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+    FastDeflateCodes codes;
+    for (int value = 0; value < 256; value++) {
+        if (value < 144) {
+            codes.literal_code[value] = (uint16_t)reverse_bits(0x30 + value, 8);
+            codes.literal_bits[value] = 8;
+        } else {
+            codes.literal_code[value] = (uint16_t)reverse_bits(0x190 + value - 144, 9);
+            codes.literal_bits[value] = 9;
+        }
+    }
+    codes.match_code[0] = codes.match_code[1] = codes.match_code[2] = 0;
+    codes.match_bits[0] = codes.match_bits[1] = codes.match_bits[2] = 0;
+    int symbol = 0;
+    for (int length = 3; length <= 258; length++) {
+        while (symbol < 28 && length >= length_base[symbol + 1]) symbol++;
+        // Symbols 257-279 have 7-bit codes starting at 0, 280-285 8-bit codes
+        // starting at 0xC0.
+        int code = symbol + 1 < 24 ? reverse_bits(symbol + 1, 7) : reverse_bits(0xC0 + symbol + 1 - 24, 8);
+        int bits = symbol + 1 < 24 ? 7 : 8;
+        uint32_t value = code | (uint32_t)(length - length_base[symbol]) << bits;
+        bits += length_extra[symbol];
+        codes.match_code[length] = value;  // distance code 0 is five zero bits
+        codes.match_bits[length] = (uint8_t)(bits + 5);
+    }
+    return codes;
+}
+
+static const FastDeflateCodes& fast_deflate_codes() {
+    static const FastDeflateCodes codes = build_fast_deflate_codes();
+    return codes;
+}
+
+struct BitWriter {
+    byte* out;
+    uint64_t bits;
+    int count;
+
+    void put(uint32_t value, int length) {
+        bits |= (uint64_t)value << count;
+        count += length;
+        if (count >= 32) {
+            out[0] = (byte)bits;
+            out[1] = (byte)(bits >> 8);
+            out[2] = (byte)(bits >> 16);
+            out[3] = (byte)(bits >> 24);
+            out += 4;
+            bits >>= 32;
+            count -= 32;
+        }
+    }
+
+    void align() {
+        while (count > 0) {
+            *out++ = (byte)bits;
+            bits >>= 8;
+            count = count > 8 ? count - 8 : 0;
+        }
+        bits = 0;
+    }
+};
+
+static size_t run_length(const byte* data, size_t start, size_t end, byte value) {
+    uint64_t pattern = value * 0x0101010101010101ULL;
+    size_t i = start;
+    for (; i + 8 <= end; i += 8) {
+        uint64_t word;
+        memcpy(&word, data + i, sizeof(word));
+        if (word != pattern) break;
+    }
+    while (i < end && data[i] == value) i++;
+    return i - start;
+}
+
+// Adler-32 of the filtered bytes, kept from the literals and runs the encoder
+// emits, so a run costs the same few operations whatever its length. 64 bits
+// hold a whole row before reducing.
+struct RunningAdler {
+    uint64_t a;
+    uint64_t b;
+
+    void literal(byte value) {
+        a += value;
+        b += a;
+    }
+
+    void run(byte value, uint64_t length) {
+        b += length * a + value * (length * (length + 1) / 2);
+        a += length * value;
+    }
+
+    void reduce() {
+        a %= 65521;
+        b %= 65521;
+    }
+};
+
+static void fast_deflate_row(const FastDeflateCodes& codes, const byte* data, size_t length, BitWriter& writer, RunningAdler& adler) {
+    size_t i = 0;
+    while (i < length) {
+        byte value = data[i];
+        writer.put(codes.literal_code[value], codes.literal_bits[value]);
+        adler.literal(value);
+        i++;
+        size_t run = run_length(data, i, length, value);
+        adler.run(value, run);
+        i += run;
+        while (run >= 3) {
+            size_t match = run < 258 ? run : 258;
+            // Don't leave a tail too short to be a match when splitting.
+            if (run - match > 0 && run - match < 3) match = run - 3;
+            writer.put(codes.match_code[match], codes.match_bits[match]);
+            run -= match;
+        }
+        while (run-- > 0) {
+            writer.put(codes.literal_code[value], codes.literal_bits[value]);
+        }
+    }
+    adler.reduce();
+}
+
+// A row as stored blocks of at most 65535 bytes each; they leave the stream
+// byte aligned.
+static void store_deflate_row(const byte* data, size_t length, bool final, BitWriter& writer) {
+    size_t offset = 0;
+    do {
+        size_t block = std::min<size_t>(length - offset, 65535);
+        writer.put(final && offset + block == length ? 1 : 0, 3);  // BFINAL, stored
+        writer.align();
+        byte* out = writer.out;
+        out[0] = (byte)block;
+        out[1] = (byte)(block >> 8);
+        out[2] = (byte)~block;
+        out[3] = (byte)(~block >> 8);
+        memcpy(out + 4, data + offset, block);
+        writer.out = out + 4 + block;
+        offset += block;
+    } while (offset < length);
+}
+
+// Converts, filters and deflates a strip one row at a time, so every step
+// works on a row that is still in cache. A row whose runs don't pay for its
+// literals is rolled back and stored instead, which keeps noise at the size
+// decoders expect of a stored stream.
+static bool fast_compress_strip(const uint32_t* pixels, size_t pitch, int width, bool last, PngStrip& strip) {
+    const FastDeflateCodes& codes = fast_deflate_codes();
+    size_t stride = (size_t)width * lp_COLOR_BYTES;
+    size_t row_bytes = stride + 1;
+    size_t stored_row_size = row_bytes + 5 * ((row_bytes + 65534) / 65535);
+
+    std::vector<byte> rows(stride + row_bytes);
+    byte* rgba = rows.data();
+    byte* filtered = rgba + stride;
+    filtered[0] = 1;  // sub
+
+    // Every row ends up no larger than stored, and a try at Huffman coding
+    // can overshoot by a ninth before it is rolled back.
+    strip.deflated.resize(strip.row_count * stored_row_size + row_bytes / 8 + 32);
+    byte* start = strip.deflated.data();
+    BitWriter writer = {start, 0, 0};
+    RunningAdler adler = {1, 0};
+    bool in_block = false;
+
+    for (size_t y = strip.first_row; y < strip.first_row + strip.row_count; y++) {
+        premultiplied_argb_to_rgba(pixels + y * pitch, rgba, width);
+        filter_row(1, rgba, nullptr, stride, filtered + 1);
+
+        BitWriter saved = writer;
+        if (!in_block) writer.put(2, 3);  // fixed Huffman
+        fast_deflate_row(codes, filtered, row_bytes, writer, adler);
+        // Leaves room for closing the block and padding a stored header.
+        size_t bits = (writer.out - saved.out) * 8 + writer.count - saved.count;
+        if (bits + 24 <= stored_row_size * 8) {
+            in_block = true;
+            continue;
+        }
+
+        writer = saved;
+        if (in_block) writer.put(0, 7);  // end of block
+        in_block = false;
+        store_deflate_row(filtered, row_bytes, last && y + 1 == strip.first_row + strip.row_count, writer);
+    }
+
+    // A stored last row has already closed the strip.
+    if (in_block) {
+        writer.put(0, 7);  // end of block
+        if (last) {
+            // An empty final block, as the open one was started without BFINAL.
+            writer.put(3, 3);
+            writer.put(0, 7);
+        } else {
+            // Sync flush: an empty stored block leaves the stream byte
+            // aligned for the next strip.
+            writer.put(0, 3);
+            writer.align();
+            static const byte empty_stored[4] = {0, 0, 0xFF, 0xFF};
+            memcpy(writer.out, empty_stored, sizeof(empty_stored));
+            writer.out += sizeof(empty_stored);
+        }
+        writer.align();
+    }
+
+    strip.deflated.resize(writer.out - start);
+    strip.adler = (uLong)(adler.b << 16 | adler.a);
+    return true;
+}
+
+static size_t png_strip_count(int width, int height, size_t threads) {
+    size_t raw_size = ((size_t)width * lp_COLOR_BYTES + 1) * height;
+    size_t strip_count = std::min(threads, raw_size / li_MIN_STRIP_BYTES);
+    if (strip_count > (size_t)height) strip_count = height;
+    return strip_count ? strip_count : 1;
+}
+
+static byte* put_u32(byte* p, uint32_t value) {
+    p[0] = (byte)(value >> 24);
+    p[1] = (byte)(value >> 16);
+    p[2] = (byte)(value >> 8);
+    p[3] = (byte)value;
+    return p + 4;
+}
+
+// One zlib header, the concatenated strips and the combined checksum.
+static void finish_png_image(const std::vector<PngStrip>& strips, size_t stride, int level, std::vector<byte>& out) {
+    int flevel = level < 2 ? 0 : level < 6 ? 1 : level == 6 ? 2 : 3;
+    unsigned header = 0x7800 | (flevel << 6);
+    header += (31 - header % 31) % 31;
+    out.push_back((byte)(header >> 8));
+    out.push_back((byte)header);
+
+    uLong adler = strips[0].adler;
+    for (size_t i = 0; i < strips.size(); i++) {
+        out.insert(out.end(), strips[i].deflated.begin(), strips[i].deflated.end());
+        if (i > 0) adler = adler32_combine(adler, strips[i].adler, (z_off_t)(strips[i].row_count * (stride + 1)));
+    }
+
+    byte trailer[4];
+    put_u32(trailer, (uint32_t)adler);
+    out.insert(out.end(), trailer, trailer + 4);
+}
+
+// Large blocks are filtered and deflated in row strips in parallel, like
+// pigz, and stitched into a single zlib stream: one header, the concatenated
+// raw deflate data, and the strip checksums combined with adler32_combine.
+bool compress_png_image(const uint32_t* pixels, size_t pitch, int width, int height, const PngOptions& options, std::vector<byte>& out) {
+    size_t stride = (size_t)width * lp_COLOR_BYTES;
+    size_t strip_count = png_strip_count(width, height, options.threads);
+    size_t rows_per_strip = (height + strip_count - 1) / strip_count;
+    strip_count = (height + rows_per_strip - 1) / rows_per_strip;
+
+    std::vector<PngStrip> strips(strip_count);
+    for (size_t i = 0; i < strip_count; i++) {
+        strips[i].first_row = i * rows_per_strip;
+        strips[i].row_count = std::min(rows_per_strip, (size_t)height - strips[i].first_row);
+    }
+
+    size_t concurrency = std::min(options.threads, strip_count);
+    if (options.fast) {
+        if (!parallel_for(strip_count, concurrency, [&](size_t worker, size_t index) {
+                return fast_compress_strip(pixels, pitch, width, index == strip_count - 1, strips[index]);
+            })) {
             return false;
         }
-        for (int x = 0; x < data->width; x++) {
-            byte b = *byte_buffer_raw++, g = *byte_buffer_raw++, r = *byte_buffer_raw++, a = *byte_buffer_raw++;
-            row_pointers[y][x * 4 + 0] = r;
-            row_pointers[y][x * 4 + 1] = g;
-            row_pointers[y][x * 4 + 2] = b;
-            row_pointers[y][x * 4 + 3] = a;
+        finish_png_image(strips, stride, 0, out);
+        return true;
+    }
+
+    ScratchBuffer filtered((stride + 1) * height);
+    if (!filtered) return false;
+
+    bool ok = parallel_for(strip_count, concurrency, [&](size_t worker, size_t index) {
+        // Each strip converts the row above it itself, so strips don't wait
+        // on each other.
+        std::vector<byte> rows(stride * 3, 0);
+        byte* prev = rows.data();
+        byte* row = prev + stride;
+        byte* candidate = row + stride;
+        PngStrip& strip = strips[index];
+        if (strip.first_row > 0) {
+            premultiplied_argb_to_rgba(pixels + (strip.first_row - 1) * pitch, prev, width);
+        }
+        for (size_t y = strip.first_row; y < strip.first_row + strip.row_count; y++) {
+            premultiplied_argb_to_rgba(pixels + y * pitch, row, width);
+            filter_png_row(options.filter, row, prev, stride, filtered.data() + y * (stride + 1), candidate);
+            std::swap(prev, row);
         }
+        return true;
+    });
+    ok = ok && parallel_for(strip_count, concurrency, [&](size_t worker, size_t index) {
+        PngStrip& strip = strips[index];
+        return deflate_strip(filtered.data(), strip.first_row * (stride + 1), strip.row_count * (stride + 1),
+                             index == strip_count - 1, options, strip);
+    });
+    if (!ok) return false;
+    finish_png_image(strips, stride, options.compression_level, out);
+    return true;
+}
+
+
+bool append_png_bytes(PngBuffer* buf, const void* data, size_t length) {
+    if (buf->size + length > buf->capacity) {
+        size_t new_capacity = buf->capacity == 0 ? 1024 : buf->capacity * 2;
+        while (new_capacity < buf->size + length) new_capacity *= 2;
+        if (!reserve_png_buffer(buf, new_capacity)) return false;
     }
+    memcpy(buf->buffer + buf->size, data, length);
+    buf->size += length;
+    return true;
+}
 
-    png_set_rows(png_ptr, info_ptr, row_pointers);
-    png_write_png(png_ptr, info_ptr, PNG_TRANSFORM_IDENTITY, nullptr);
+bool append_png_chunk(PngBuffer* buf, const char* type, const byte* data, size_t length) {
+    byte header[8];
+    put_u32(header, (uint32_t)length);
+    memcpy(header + 4, type, 4);
+    uLong crc = crc32(crc32(0L, Z_NULL, 0), header + 4, 4);
+    if (length) crc = crc32(crc, data, (uInt)length);
+    byte trailer[4];
+    put_u32(trailer, (uint32_t)crc);
+    return append_png_bytes(buf, header, sizeof(header)) &&
+           (!length || append_png_bytes(buf, data, length)) &&
+           append_png_bytes(buf, trailer, sizeof(trailer));
+}
+
+void update_png_chunk_crc(PngBuffer* buf, size_t offset) {
+    byte* chunk = buf->buffer + offset;
+    uint32_t length = ((uint32_t)chunk[0] << 24) | ((uint32_t)chunk[1] << 16) | ((uint32_t)chunk[2] << 8) | chunk[3];
+    uLong crc = crc32(crc32(0L, Z_NULL, 0), chunk + 4, length + 4);
+    put_u32(chunk + 8 + length, (uint32_t)crc);
+}
+
+bool append_png_header(PngBuffer* buf, int width, int height) {
+    byte ihdr[13];
+    put_u32(ihdr, width);
+    put_u32(ihdr + 4, height);
+    ihdr[8] = 8;   // bit depth
+    ihdr[9] = 6;   // RGBA
+    ihdr[10] = 0;  // deflate
+    ihdr[11] = 0;  // adaptive filtering
+    ihdr[12] = 0;  // no interlace
+    return append_png_bytes(buf, png_signature, sizeof(png_signature)) &&
+           append_png_chunk(buf, "IHDR", ihdr, sizeof(ihdr));
+}
 
-    for (int y = 0; y < data->height; y++) {
-        free(row_pointers[y]);
+static bool encode_png_strips(const uint32_t* buffer, int width, int height, const PngOptions& options,
+                              byte** out_buffer, size_t* out_size, std::string& error_msg) {
+    std::vector<byte> image;
+    if (!compress_png_image(buffer, width, width, height, options, image)) {
+        error_msg = "Failed to compress PNG data";
+        return false;
     }
-    free(row_pointers);
-    png_destroy_write_struct(&png_ptr, &info_ptr);
 
-    data->result_buffer = png_data.buffer;
-    data->result_size = png_data.size;
+    PngBuffer png_data = {nullptr, 0, 0};
+    size_t total = sizeof(png_signature) + (12 + 13) + (12 + image.size()) + 12;
+    if (!reserve_png_buffer(&png_data, total) ||
+        !append_png_header(&png_data, width, height) ||
+        !append_png_chunk(&png_data, "IDAT", image.data(), image.size()) ||
+        !append_png_chunk(&png_data, "IEND", nullptr, 0)) {
+        free(png_data.buffer);
+        error_msg = "Failed to allocate memory for PNG";
+        return false;
+    }
+
+    *out_buffer = png_data.buffer;
+    *out_size = png_data.size;
     return true;
+}
+
+bool encode_png(const uint32_t* buffer, int width, int height, const PngOptions& options, byte** out_buffer, size_t* out_size, std::string& error_msg) {
+    if (options.fast || png_strip_count(width, height, options.threads) > 1) {
+        return encode_png_strips(buffer, width, height, options, out_buffer, out_size, error_msg);
+    }
+
+    // Rows point straight into one pooled conversion buffer.
+    ScratchBuffer rgba((size_t)width * height * lp_COLOR_BYTES);
+    if (!rgba) {
+        error_msg = "Failed to allocate row buffer";
+        return false;
+    }
+    premultiplied_argb_to_rgba(buffer, rgba.data(), (size_t)width * height);
+    return encode_png_single(rgba.data(), width, height, options, out_buffer, out_size, error_msg);
 }
\ No newline at end of file
@@ -3,7 +3,28 @@
 
 #include "converter.h"
 #include <png.h>
+#include <string>
+#include <vector>
 
-bool write_png(ConverterData* data, uint32_t* buffer);
+// A growable, malloc'd output buffer that can be handed to JS as is.
+struct PngBuffer {
+    byte* buffer;
+    size_t size;
+    size_t capacity;
+};
+
+bool encode_png(const uint32_t* buffer, int width, int height, const PngOptions& options, byte** out_buffer, size_t* out_size, std::string& error_msg);
+
+// Building blocks for writers that assemble their own chunk sequence.
+// compress_png_image appends the zlib stream of a block of premultiplied ARGB
+// pixels (`pitch` pixels between rows), filtered and ready for an IDAT or fdAT
+// chunk.
+bool compress_png_image(const uint32_t* pixels, size_t pitch, int width, int height, const PngOptions& options, std::vector<byte>& out);
+bool append_png_bytes(PngBuffer* buf, const void* data, size_t length);
+bool append_png_chunk(PngBuffer* buf, const char* type, const byte* data, size_t length);
+// Writes the signature and IHDR of an 8-bit RGBA image.
+bool append_png_header(PngBuffer* buf, int width, int height);
+// Recomputes the CRC of the chunk at `offset` after its data was patched.
+void update_png_chunk_crc(PngBuffer* buf, size_t offset);
 
 #endif // PNG_WRITER_H
\ No newline at end of file
@@ -0,0 +1,373 @@
+#include "probe.h"
+#include "animation.h"
+#include "animation_input.h"
+#include "json_scan.h"
+#include "utils.h"
+#include <zlib.h>
+
+#define lp_COLOR_BYTES 4
+#define li_MAX_CANVAS_DIMENSION 16384
+// Signature, IHDR, one IDAT header and IEND.
+#define li_PNG_OVERHEAD_BYTES 57
+
+static bool count_shapes(const std::string& json, size_t pos, AnimationComplexity* complexity) {
+    return json_for_each_element(json, pos, [&](size_t begin, size_t end) {
+        complexity->shapes++;
+        if (json[begin] != '{') return true;
+        // Groups keep their items in "it".
+        return json_for_each_member(json, begin, [&](const std::string& key, size_t value, size_t value_end) {
+            return key != "it" || json[value] != '[' || count_shapes(json, value, complexity);
+        });
+    });
+}
+
+static bool count_layers(const std::string& json, size_t pos, AnimationComplexity* complexity) {
+    return json_for_each_element(json, pos, [&](size_t begin, size_t end) {
+        complexity->layers++;
+        if (json[begin] != '{') return true;
+        return json_for_each_member(json, begin, [&](const std::string& key, size_t value, size_t value_end) {
+            if (json[value] != '[') return true;
+            if (key == "shapes") return count_shapes(json, value, complexity);
+            if (key == "masksProperties") {
+                return json_for_each_element(json, value, [&](size_t, size_t) {
+                    complexity->masks++;
+                    return true;
+                });
+            }
+            return true;
+        });
+    });
+}
+
+static bool count_assets(const std::string& json, size_t pos, AnimationComplexity* complexity) {
+    return json_for_each_element(json, pos, [&](size_t begin, size_t end) {
+        if (json[begin] != '{') return true;
+        size_t layers = 0;
+        bool has_path = false;
+        bool ok = json_for_each_member(json, begin, [&](const std::string& key, size_t value, size_t value_end) {
+            if (key == "layers" && json[value] == '[') layers = value;
+            if (key == "p") has_path = true;
+            return true;
+        });
+        if (!ok) return false;
+        if (layers) {
+            complexity->precomps++;
+            return count_layers(json, layers, complexity);
+        }
+        if (has_path) complexity->images++;
+        return true;
+    });
+}
+
+static bool scan_complexity(const std::string& json, AnimationComplexity* complexity) {
+    *complexity = AnimationComplexity{0, 0, 0, 0, 0};
+    return json_for_each_member(json, json_skip_whitespace(json, 0), [&](const std::string& key, size_t value, size_t value_end) {
+        if (json[value] != '[') return true;
+        if (key == "layers") return count_layers(json, value, complexity);
+        if (key == "assets") return count_assets(json, value, complexity);
+        return true;
+    });
+}
+
+static ProbeEstimate estimate_frame(const ProbeData* data, uint32_t width, uint32_t height) {
+    ProbeEstimate estimate;
+    estimate.width = width;
+    estimate.height = height;
+    estimate.surface_bytes = (size_t)width * height * lp_COLOR_BYTES;
+    // Each row gets a filter byte in front.
+    estimate.png_bytes = (size_t)compressBound((uLong)((size_t)height * ((size_t)width * lp_COLOR_BYTES + 1))) + li_PNG_OVERHEAD_BYTES;
+    estimate.peak_bytes = data->input->in_size + 2 * data->json_bytes + estimate.surface_bytes + estimate.png_bytes;
+    const AnimationComplexity& complexity = data->complexity;
+    estimate.render_cost = (double)width * height / 1e6 * (double)(complexity.layers + complexity.shapes + complexity.masks);
+    return estimate;
+}
+
+bool probe_animation_sync(ProbeData* data) {
+    ConverterData* input = data->input;
+    if (!open_converter_input(input)) return false;
+
+    std::string json;
+    if (!decode_animation_input(input->in_data, input->in_size, input->animation_id, json, input->error_msg)) return false;
+    data->json_bytes = json.size();
+    if (!scan_complexity(json, &data->complexity)) {
+        input->error_msg = "Failed to scan Lottie JSON";
+        return false;
+    }
+
+    // Parsing builds the model only; nothing is rasterized.
+    std::unique_ptr<rlottie::Animation> animation = load_animation_from_data(std::move(json), input->resource_path);
+    if (!animation) {
+        input->error_msg = "Failed to load Lottie animation from provided JSON data";
+        return false;
+    }
+
+    data->total_frames = get_total_frames(animation);
+    data->frame_rate = animation->frameRate();
+    data->duration = animation->duration();
+    animation->size(data->width, data->height);
+    for (const auto& layer : animation->layers()) {
+        data->layers.push_back(ProbeNamedRange{std::get<0>(layer), std::get<1>(layer), std::get<2>(layer)});
+    }
+    for (const auto& marker : animation->markers()) {
+        data->markers.push_back(ProbeNamedRange{std::get<0>(marker), std::get<1>(marker), std::get<2>(marker)});
+    }
+
+    if (data->estimates.empty()) {
+        data->estimates.push_back(estimate_frame(data, (uint32_t)data->width, (uint32_t)data->height));
+    } else {
+        for (ProbeEstimate& estimate : data->estimates) {
+            estimate = estimate_frame(data, estimate.width, estimate.height);
+        }
+    }
+    return true;
+}
+
+static ProbeData* create_probe_data(napi_env env) {
+    ConverterData* input = create_converter_data(env, nullptr, 0);
+    if (!input) return nullptr;
+
+    ProbeData* data = new ProbeData();
+    data->env = env;
+    data->deferred = nullptr;
+    data->input = input;
+    data->json_bytes = 0;
+    data->total_frames = 0;
+    data->frame_rate = 0;
+    data->duration = 0;
+    data->width = 0;
+    data->height = 0;
+    data->complexity = AnimationComplexity{0, 0, 0, 0, 0};
+    return data;
+}
+
+static void destroy_probe_data(ProbeData* data) {
+    if (data) {
+        destroy_converter_data(data->input);
+        delete data;
+    }
+}
+
+static const char* parse_probe_sizes(napi_env env, napi_value sizes, ProbeData* data) {
+    bool is_array = false;
+    if (napi_is_array(env, sizes, &is_array) != napi_ok || !is_array) {
+        return "Sizes must be an array of { width, height } objects";
+    }
+    uint32_t length;
+    if (napi_get_array_length(env, sizes, &length) != napi_ok) {
+        return "Failed to get sizes length";
+    }
+    for (uint32_t i = 0; i < length; i++) {
+        napi_value element, prop;
+        napi_valuetype element_type;
+        uint32_t width, height;
+        if (napi_get_element(env, sizes, i, &element) != napi_ok ||
+            napi_typeof(env, element, &element_type) != napi_ok || element_type != napi_object ||
+            napi_get_named_property(env, element, "width", &prop) != napi_ok ||
+            napi_get_value_uint32(env, prop, &width) != napi_ok ||
+            napi_get_named_property(env, element, "height", &prop) != napi_ok ||
+            napi_get_value_uint32(env, prop, &height) != napi_ok) {
+            return "Sizes must be an array of { width, height } objects";
+        }
+        if (width < 1 || width > li_MAX_CANVAS_DIMENSION || height < 1 || height > li_MAX_CANVAS_DIMENSION) {
+            return "Size width and height must be between 1 and 16384";
+        }
+        ProbeEstimate estimate = ProbeEstimate();
+        estimate.width = width;
+        estimate.height = height;
+        data->estimates.push_back(estimate);
+    }
+    return nullptr;
+}
+
+static const char* parse_probe_options(napi_env env, napi_value options, ProbeData* data) {
+    napi_valuetype options_type;
+    napi_status status = napi_typeof(env, options, &options_type);
+    if (status != napi_ok) return "Failed to get type of options argument";
+    if (options_type == napi_undefined || options_type == napi_null) return nullptr;
+    if (options_type != napi_object) return "Options argument must be an object";
+
+    napi_value prop;
+    if (has_own_property(env, options, "animationId")) {
+        status = napi_get_named_property(env, options, "animationId", &prop);
+        if (status != napi_ok || !get_string_value(env, prop, data->input->animation_id)) {
+            return "Animation ID must be a string";
+        }
+    }
+    if (has_own_property(env, options, "resourcePath")) {
+        status = napi_get_named_property(env, options, "resourcePath", &prop);
+        if (status != napi_ok || !get_string_value(env, prop, data->input->resource_path)) {
+            return "Resource path must be a string";
+        }
+    }
+    if (has_own_property(env, options, "sizes")) {
+        status = napi_get_named_property(env, options, "sizes", &prop);
+        if (status != napi_ok) return "Failed to get sizes";
+        return parse_probe_sizes(env, prop, data);
+    }
+    return nullptr;
+}
+
+static ProbeData* create_probe_request(napi_env env, napi_callback_info info, bool retain) {
+    size_t argc = 2;
+    napi_value args[2];
+    napi_status status = napi_get_cb_info(env, info, &argc, args, nullptr, nullptr);
+    if (status != napi_ok) {
+        napi_throw_error(env, nullptr, "Failed to get callback info");
+        return nullptr;
+    }
+    if (argc < 1) {
+        napi_throw_error(env, nullptr, "Expected at least 1 argument: Lottie JSON buffer");
+        return nullptr;
+    }
+
+    ProbeData* data = create_probe_data(env);
+    if (!data) {
+        napi_throw_error(env, nullptr, "Failed to allocate probe data");
+        return nullptr;
+    }
+    const char* error = get_converter_input(env, args[0], data->input, retain);
+    if (!error && argc >= 2 && args[1] != nullptr) {
+        error = parse_probe_options(env, args[1], data);
+    }
+    if (error) {
+        destroy_probe_data(data);
+        napi_throw_error(env, nullptr, error);
+        return nullptr;
+    }
+    return data;
+}
+
+static napi_status create_named_ranges(napi_env env, const std::vector<ProbeNamedRange>& ranges, const char* begin_key,
+                                       const char* end_key, napi_value* result) {
+    napi_status status = napi_create_array_with_length(env, ranges.size(), result);
+    for (size_t i = 0; status == napi_ok && i < ranges.size(); i++) {
+        napi_value range, name;
+        status = napi_create_object(env, &range);
+        if (status == napi_ok) status = napi_create_string_utf8(env, ranges[i].name.c_str(), ranges[i].name.size(), &name);
+        if (status == napi_ok) status = napi_set_named_property(env, range, "name", name);
+        if (status == napi_ok && (!set_number_property(env, range, begin_key, ranges[i].begin) ||
+                                  !set_number_property(env, range, end_key, ranges[i].end))) {
+            status = napi_generic_failure;
+        }
+        if (status == napi_ok) status = napi_set_element(env, *result, (uint32_t)i, range);
+    }
+    return status;
+}
+
+static napi_status create_probe_result(napi_env env, const ProbeData* data, napi_value* result) {
+    napi_value size, complexity, layers, markers, estimates;
+    napi_status status = napi_create_object(env, result);
+    if (status == napi_ok) status = napi_create_object(env, &size);
+    if (status == napi_ok) status = napi_create_object(env, &complexity);
+    if (status != napi_ok) return status;
+
+    const AnimationComplexity& counts = data->complexity;
+    if (!set_number_property(env, *result, "totalFrames", (double)data->total_frames) ||
+        !set_number_property(env, *result, "frameRate", data->frame_rate) ||
+        !set_number_property(env, *result, "duration", data->duration) ||
+        !set_number_property(env, *result, "inputBytes", (double)data->input->in_size) ||
+        !set_number_property(env, *result, "jsonBytes", (double)data->json_bytes) ||
+        !set_number_property(env, size, "width", (double)data->width) ||
+        !set_number_property(env, size, "height", (double)data->height) ||
+        !set_number_property(env, complexity, "layers", (double)counts.layers) ||
+        !set_number_property(env, complexity, "shapes", (double)counts.shapes) ||
+        !set_number_property(env, complexity, "masks", (double)counts.masks) ||
+        !set_number_property(env, complexity, "precomps", (double)counts.precomps) ||
+        !set_number_property(env, complexity, "images", (double)counts.images)) {
+        return napi_generic_failure;
+    }
+
+    status = create_named_ranges(env, data->layers, "inFrame", "outFrame", &layers);
+    if (status == napi_ok) status = create_named_ranges(env, data->markers, "startFrame", "endFrame", &markers);
+    if (status == napi_ok) status = napi_create_array_with_length(env, data->estimates.size(), &estimates);
+    for (size_t i = 0; status == napi_ok && i < data->estimates.size(); i++) {
+        const ProbeEstimate& estimate = data->estimates[i];
+        napi_value object;
+        status = napi_create_object(env, &object);
+        if (status == napi_ok && (!set_number_property(env, object, "width", estimate.width) ||
+                                  !set_number_property(env, object, "height", estimate.height) ||
+                                  !set_number_property(env, object, "surfaceBytes", (double)estimate.surface_bytes) ||
+                                  !set_number_property(env, object, "pngBytes", (double)estimate.png_bytes) ||
+                                  !set_number_property(env, object, "peakBytes", (double)estimate.peak_bytes) ||
+                                  !set_number_property(env, object, "renderCost", estimate.render_cost))) {
+            status = napi_generic_failure;
+        }
+        if (status == napi_ok) status = napi_set_element(env, estimates, (uint32_t)i, object);
+    }
+    if (status == napi_ok) status = napi_set_named_property(env, *result, "size", size);
+    if (status == napi_ok) status = napi_set_named_property(env, *result, "layers", layers);
+    if (status == napi_ok) status = napi_set_named_property(env, *result, "markers", markers);
+    if (status == napi_ok) status = napi_set_named_property(env, *result, "complexity", complexity);
+    if (status == napi_ok) status = napi_set_named_property(env, *result, "estimates", estimates);
+    return status;
+}
+
+static void execute_probe_work(napi_env env, void* data) {
+    ProbeData* probe_data = static_cast<ProbeData*>(data);
+    probe_data->input->success = probe_animation_sync(probe_data);
+}
+
+static void abandon_probe_work(void* data) {
+    ProbeData* probe_data = static_cast<ProbeData*>(data);
+    drop_converter_refs(probe_data->input);
+    destroy_probe_data(probe_data);
+}
+
+static void complete_probe_work(napi_env env, napi_status status, void* data) {
+    ProbeData* probe_data = static_cast<ProbeData*>(data);
+    ConverterData* input = probe_data->input;
+    napi_value result;
+
+    if (status == napi_cancelled) {
+        input->success = false;
+        input->error_msg = ls_ABORTED_MESSAGE;
+    }
+
+    if (input->success && create_probe_result(env, probe_data, &result) == napi_ok) {
+        napi_resolve_deferred(env, probe_data->deferred, result);
+    } else {
+        const std::string& message = input->success ? "Failed to create probe result" : input->error_msg;
+        if (napi_create_string_utf8(env, message.c_str(), NAPI_AUTO_LENGTH, &result) == napi_ok) {
+            napi_reject_deferred(env, probe_data->deferred, result);
+        }
+    }
+
+    destroy_probe_data(probe_data);
+}
+
+napi_value probe(napi_env env, napi_callback_info info) {
+    ProbeData* data = create_probe_request(env, info, true);
+    if (!data) return nullptr;
+
+    napi_value promise;
+    napi_status status = napi_create_promise(env, &data->deferred, &promise);
+    if (status != napi_ok) {
+        destroy_probe_data(data);
+        THROW_ERROR(env, "Failed to create promise");
+    }
+
+    status = queue_pool_work(env, execute_probe_work, complete_probe_work, abandon_probe_work, data, JOB_PRIORITY_NORMAL, nullptr);
+    if (status != napi_ok) {
+        destroy_probe_data(data);
+        THROW_ERROR(env, "Failed to queue async work");
+    }
+
+    return promise;
+}
+
+napi_value probeSync(napi_env env, napi_callback_info info) {
+    ProbeData* data = create_probe_request(env, info, false);
+    if (!data) return nullptr;
+
+    if (!probe_animation_sync(data)) {
+        std::string msg = data->input->error_msg;
+        destroy_probe_data(data);
+        THROW_ERROR(env, msg.c_str());
+    }
+
+    napi_value result;
+    napi_status status = create_probe_result(env, data, &result);
+    destroy_probe_data(data);
+    CHECK_STATUS(env, status, "Failed to create probe result");
+    return result;
+}
\ No newline at end of file
@@ -0,0 +1,64 @@
+#ifndef PROBE_H
+#define PROBE_H
+
+#include <napi.h>
+#include <string>
+#include <vector>
+#include "converter.h"
+
+// Structure counts read from the Lottie JSON. Layers and shapes inside
+// precomps are counted once per definition, not per instance.
+struct AnimationComplexity {
+    size_t layers;
+    size_t shapes;
+    size_t masks;
+    size_t precomps;
+    size_t images;
+};
+
+struct ProbeNamedRange {
+    std::string name;
+    int begin;
+    int end;
+};
+
+// What a single PNG export at one output size would cost.
+struct ProbeEstimate {
+    uint32_t width;
+    uint32_t height;
+    size_t surface_bytes;
+    // Worst-case size of the encoded PNG.
+    size_t png_bytes;
+    // Input, decoded JSON, parsed model (approximated by the JSON size),
+    // surface and encoded PNG held at once.
+    size_t peak_bytes;
+    // Output megapixels times the layer, shape and mask count; a relative
+    // figure for comparing jobs, not a time.
+    double render_cost;
+};
+
+struct ProbeData {
+    napi_env env;
+    napi_deferred deferred;
+    // Holds the Buffer or mapped file being probed.
+    ConverterData* input;
+    std::vector<ProbeEstimate> estimates;
+    size_t json_bytes;
+    size_t total_frames;
+    double frame_rate;
+    double duration;
+    size_t width;
+    size_t height;
+    AnimationComplexity complexity;
+    std::vector<ProbeNamedRange> layers;
+    std::vector<ProbeNamedRange> markers;
+};
+
+// Decodes and parses the input for its metadata without rendering, then
+// fills in the estimates for every requested size, or for the intrinsic size
+// if none were given.
+bool probe_animation_sync(ProbeData* data);
+napi_value probe(napi_env env, napi_callback_info info);
+napi_value probeSync(napi_env env, napi_callback_info info);
+
+#endif // PROBE_H
\ No newline at end of file
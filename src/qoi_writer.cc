@@ -0,0 +1,130 @@
+#include "qoi_writer.h"
+#include "buffer_pool.h"
+#include "pixel.h"
+#include <cstdlib>
+#include <cstring>
+
+#define lp_COLOR_BYTES 4
+#define li_QOI_HEADER_SIZE 14
+#define li_QOI_MAX_RUN 62
+
+#define ld_QOI_OP_INDEX 0x00
+#define ld_QOI_OP_DIFF 0x40
+#define ld_QOI_OP_LUMA 0x80
+#define ld_QOI_OP_RUN 0xC0
+#define ld_QOI_OP_RGB 0xFE
+#define ld_QOI_OP_RGBA 0xFF
+
+static const byte qoi_end_marker[8] = {0, 0, 0, 0, 0, 0, 0, 1};
+
+static byte* put_u32(byte* p, uint32_t value) {
+    p[0] = (byte)(value >> 24);
+    p[1] = (byte)(value >> 16);
+    p[2] = (byte)(value >> 8);
+    p[3] = (byte)value;
+    return p + 4;
+}
+
+static inline uint32_t load_pixel(const byte* p) {
+    uint32_t value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+// Runs, the 64-entry index and small deltas cover nearly every pixel of flat
+// vector art, so most pixels cost one byte and a couple of compares.
+static byte* encode_qoi_row(const byte* rgba, int width, byte* out, uint32_t* index, uint32_t* prev, int* run, bool last_row) {
+    for (int x = 0; x < width; x++, rgba += lp_COLOR_BYTES) {
+        uint32_t px = load_pixel(rgba);
+        if (px == *prev) {
+            if (++*run == li_QOI_MAX_RUN || (last_row && x == width - 1)) {
+                *out++ = (byte)(ld_QOI_OP_RUN | (*run - 1));
+                *run = 0;
+            }
+            continue;
+        }
+        if (*run > 0) {
+            *out++ = (byte)(ld_QOI_OP_RUN | (*run - 1));
+            *run = 0;
+        }
+
+        byte r = rgba[0], g = rgba[1], b = rgba[2], a = rgba[3];
+        int slot = (r * 3 + g * 5 + b * 7 + a * 11) % 64;
+        if (index[slot] == px) {
+            *out++ = (byte)(ld_QOI_OP_INDEX | slot);
+        } else {
+            index[slot] = px;
+            byte prev_bytes[lp_COLOR_BYTES];
+            memcpy(prev_bytes, prev, sizeof(prev_bytes));
+            if (a == prev_bytes[3]) {
+                int8_t vr = (int8_t)(r - prev_bytes[0]);
+                int8_t vg = (int8_t)(g - prev_bytes[1]);
+                int8_t vb = (int8_t)(b - prev_bytes[2]);
+                int8_t vg_r = (int8_t)(vr - vg);
+                int8_t vg_b = (int8_t)(vb - vg);
+                if (vr > -3 && vr < 2 && vg > -3 && vg < 2 && vb > -3 && vb < 2) {
+                    *out++ = (byte)(ld_QOI_OP_DIFF | (vr + 2) << 4 | (vg + 2) << 2 | (vb + 2));
+                } else if (vg_r > -9 && vg_r < 8 && vg > -33 && vg < 32 && vg_b > -9 && vg_b < 8) {
+                    *out++ = (byte)(ld_QOI_OP_LUMA | (vg + 32));
+                    *out++ = (byte)((vg_r + 8) << 4 | (vg_b + 8));
+                } else {
+                    *out++ = ld_QOI_OP_RGB;
+                    *out++ = r;
+                    *out++ = g;
+                    *out++ = b;
+                }
+            } else {
+                *out++ = ld_QOI_OP_RGBA;
+                memcpy(out, rgba, lp_COLOR_BYTES);
+                out += lp_COLOR_BYTES;
+            }
+        }
+        *prev = px;
+    }
+    return out;
+}
+
+bool encode_qoi(const uint32_t* pixels, int width, int height, byte** out_buffer, size_t* out_size, std::string& error_msg) {
+    // Every pixel is at most one tag byte plus its four channels.
+    size_t capacity = (size_t)width * height * (lp_COLOR_BYTES + 1) + li_QOI_HEADER_SIZE + sizeof(qoi_end_marker);
+    byte* buffer = (byte*)malloc(capacity);
+    if (!buffer) {
+        error_msg = "Failed to allocate memory for QOI";
+        return false;
+    }
+    count_output_allocation();
+
+    // Rows are un-premultiplied one at a time so they stay in cache.
+    ScratchBuffer row((size_t)width * lp_COLOR_BYTES);
+    if (!row) {
+        free(buffer);
+        error_msg = "Failed to allocate row buffer";
+        return false;
+    }
+
+    byte* out = buffer;
+    memcpy(out, "qoif", 4);
+    out = put_u32(out + 4, width);
+    out = put_u32(out, height);
+    *out++ = lp_COLOR_BYTES;
+    *out++ = 0;  // sRGB with linear alpha
+
+    uint32_t index[64] = {0};
+    const byte opaque_black[lp_COLOR_BYTES] = {0, 0, 0, 255};
+    uint32_t prev = load_pixel(opaque_black);
+    int run = 0;
+    for (int y = 0; y < height; y++) {
+        premultiplied_argb_to_rgba(pixels + (size_t)y * width, row.data(), width);
+        out = encode_qoi_row(row.data(), width, out, index, &prev, &run, y == height - 1);
+    }
+    memcpy(out, qoi_end_marker, sizeof(qoi_end_marker));
+    out += sizeof(qoi_end_marker);
+
+    // The buffer is handed to JS as is, so give back the worst-case slack.
+    size_t size = out - buffer;
+    byte* shrunk = (byte*)realloc(buffer, size);
+    if (shrunk) buffer = shrunk;
+    *out_buffer = buffer;
+    *out_size = size;
+    return true;
+}
\ No newline at end of file
@@ -0,0 +1,11 @@
+#ifndef QOI_WRITER_H
+#define QOI_WRITER_H
+
+#include "converter.h"
+#include <string>
+
+// Encodes premultiplied ARGB32 pixels as a QOI image (https://qoiformat.org):
+// straight RGBA, sRGB with linear alpha, into a new malloc'd buffer.
+bool encode_qoi(const uint32_t* pixels, int width, int height, byte** out_buffer, size_t* out_size, std::string& error_msg);
+
+#endif // QOI_WRITER_H
\ No newline at end of file
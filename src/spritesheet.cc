@@ -0,0 +1,351 @@
+#include "spritesheet.h"
+#include "animation.h"
+#include "animation_input.h"
+#include "buffer_pool.h"
+#include "exports.h"
+#include "parallel.h"
+#include "utils.h"
+#include <cmath>
+#include <cstring>
+#include <mutex>
+
+#define lp_COLOR_BYTES 4
+#define li_MAX_DIMENSION 4096
+
+SpriteSheetData* create_sprite_sheet_data(napi_env env, const byte* in_data, size_t size) {
+    BatchData* batch = create_batch_data(env, in_data, size);
+    if (!batch) return nullptr;
+
+    SpriteSheetData* data = new SpriteSheetData();
+    data->batch = batch;
+    data->columns = 0;
+    data->rows = 0;
+    data->padding = 0;
+    data->sheet_width = 0;
+    data->sheet_height = 0;
+    data->frame_rate = 0;
+    return data;
+}
+
+void destroy_sprite_sheet_data(SpriteSheetData* data) {
+    if (data) {
+        destroy_batch_data(data->batch);
+        delete data;
+    }
+}
+
+// Lays the selected frames out row by row and checks the sheet against the
+// dimension limit, which applies to the sheet rather than to each cell.
+static bool layout_sprite_sheet(SpriteSheetData* data) {
+    BatchData* batch = data->batch;
+    ConverterData* base = batch->base;
+    uint64_t count = batch->frames.size();
+
+    uint64_t columns = data->columns ? data->columns : (uint64_t)std::ceil(std::sqrt((double)count));
+    if (columns > count) columns = count;
+    uint64_t rows = (count + columns - 1) / columns;
+    uint64_t width = columns * base->width + (columns - 1) * data->padding;
+    uint64_t height = rows * base->height + (rows - 1) * data->padding;
+    if (width > li_MAX_DIMENSION || height > li_MAX_DIMENSION) {
+        base->error_msg = "Sprite sheet size " + std::to_string(width) + "x" + std::to_string(height) + " exceeds the maximum of 4096x4096";
+        return false;
+    }
+
+    data->columns = (uint32_t)columns;
+    data->rows = (uint32_t)rows;
+    data->sheet_width = (uint32_t)width;
+    data->sheet_height = (uint32_t)height;
+    data->cells.resize(count);
+    for (size_t i = 0; i < count; i++) {
+        data->cells[i].frame = batch->frames[i];
+        data->cells[i].x = (uint32_t)(i % columns) * (base->width + data->padding);
+        data->cells[i].y = (uint32_t)(i / columns) * (base->height + data->padding);
+    }
+    return true;
+}
+
+bool export_sprite_sheet_sync(SpriteSheetData* data) {
+    BatchData* batch = data->batch;
+    ConverterData* base = batch->base;
+    if (!open_converter_input(base)) return false;
+    std::string json_data;
+    if (!decode_animation_input(base->in_data, base->in_size, base->animation_id, json_data, base->error_msg)) {
+        return false;
+    }
+    std::string key = animation_model_key(base->in_data, base->in_size, base->resource_path, base->animation_id);
+
+    std::unique_ptr<rlottie::Animation> animation = load_shared_animation_from_data(json_data, key, base->resource_path);
+    if (!animation) {
+        base->error_msg = "Failed to load Lottie animation from provided JSON data";
+        return false;
+    }
+    if (!resolve_batch_frames(batch, get_total_frames(animation), animation->frameRate())) {
+        return false;
+    }
+    if (batch->frames.empty()) {
+        base->error_msg = "No frames selected";
+        return false;
+    }
+    if (!layout_sprite_sheet(data)) {
+        return false;
+    }
+    data->frame_rate = animation->frameRate();
+
+    size_t stride = (size_t)data->sheet_width * lp_COLOR_BYTES;
+    ScratchBuffer sheet(stride * data->sheet_height);
+    if (!sheet) {
+        base->error_msg = "Failed to allocate sprite sheet (width: " + std::to_string(data->sheet_width) + ", height: " + std::to_string(data->sheet_height) + ")";
+        return false;
+    }
+    // Padding and the unused cells of the last row stay transparent.
+    memset(sheet.data(), 0, sheet.size());
+
+    size_t count = data->cells.size();
+    size_t concurrency = batch->concurrency ? batch->concurrency : default_concurrency();
+    if (concurrency > count) concurrency = count;
+
+    std::vector<std::unique_ptr<rlottie::Animation>> workers(concurrency ? concurrency : 1);
+    workers[0] = std::move(animation);
+    std::mutex error_mutex;
+
+    // Each cell is a surface over its sub-rectangle of the sheet, so frames
+    // render straight into place with no copy or composite step.
+    bool ok = parallel_for(count, concurrency, [&](size_t worker_index, size_t index) {
+        std::unique_ptr<rlottie::Animation>& worker = workers[worker_index];
+        if (!worker) {
+            worker = load_shared_animation_from_data(json_data, key, base->resource_path);
+            if (!worker) {
+                std::lock_guard<std::mutex> lock(error_mutex);
+                base->error_msg = "Failed to load Lottie animation from provided JSON data";
+                return false;
+            }
+        }
+
+        if (is_cancelled(base->cancel)) {
+            std::lock_guard<std::mutex> lock(error_mutex);
+            base->error_msg = ls_ABORTED_MESSAGE;
+            return false;
+        }
+
+        const SpriteCell& cell = data->cells[index];
+        uint32_t* origin = reinterpret_cast<uint32_t*>(sheet.data() + cell.y * stride) + cell.x;
+        rlottie::Surface surface(origin, base->width, base->height, stride);
+        render_frame_sync(worker, cell.frame, surface);
+        return true;
+    });
+    if (!ok) return false;
+    if (is_cancelled(base->cancel)) {
+        base->error_msg = ls_ABORTED_MESSAGE;
+        return false;
+    }
+
+    return encode_frame(sheet.pixels(), data->sheet_width, data->sheet_height, base->png, base->format,
+                        &base->result_buffer, &base->result_size, base->error_msg);
+}
+
+static const char* parse_sprite_sheet_options(napi_env env, napi_value options, SpriteSheetData* data) {
+    BatchData* batch = data->batch;
+    const char* error = parse_batch_options(env, options, batch);
+    if (error) return error;
+
+    napi_valuetype arg_type;
+    napi_status status = napi_typeof(env, options, &arg_type);
+    if (status != napi_ok || arg_type != napi_object) return nullptr;
+
+    napi_value prop;
+    if (has_own_property(env, options, "columns")) {
+        status = napi_get_named_property(env, options, "columns", &prop);
+        if (status == napi_ok) {
+            if (napi_get_value_uint32(env, prop, &data->columns) != napi_ok) {
+                return "Columns must be a valid integer";
+            }
+            if (data->columns < 1 || data->columns > li_MAX_DIMENSION) {
+                return "Columns must be between 1 and 4096";
+            }
+        }
+    }
+
+    if (has_own_property(env, options, "frameStep")) {
+        if (has_own_property(env, options, "frames") || has_own_property(env, options, "times") ||
+            has_own_property(env, options, "fps")) {
+            return "Frame step cannot be combined with frames, times or fps";
+        }
+        status = napi_get_named_property(env, options, "frameStep", &prop);
+        if (status == napi_ok) {
+            if (napi_get_value_uint32(env, prop, &batch->range_step) != napi_ok || batch->range_step == 0) {
+                return "Frame step must be a positive integer";
+            }
+        }
+    }
+
+    if (has_own_property(env, options, "cellWidth")) {
+        status = napi_get_named_property(env, options, "cellWidth", &prop);
+        if (status == napi_ok) {
+            uint32_t width;
+            if (napi_get_value_uint32(env, prop, &width) != napi_ok) {
+                return "Cell width must be a valid integer";
+            }
+            if (width == 0 || width > li_MAX_DIMENSION) {
+                return "Cell width must be between 1 and 4096";
+            }
+            batch->base->width = width;
+        }
+    }
+
+    if (has_own_property(env, options, "cellHeight")) {
+        status = napi_get_named_property(env, options, "cellHeight", &prop);
+        if (status == napi_ok) {
+            uint32_t height;
+            if (napi_get_value_uint32(env, prop, &height) != napi_ok) {
+                return "Cell height must be a valid integer";
+            }
+            if (height == 0 || height > li_MAX_DIMENSION) {
+                return "Cell height must be between 1 and 4096";
+            }
+            batch->base->height = height;
+        }
+    }
+
+    if (has_own_property(env, options, "padding")) {
+        status = napi_get_named_property(env, options, "padding", &prop);
+        if (status == napi_ok) {
+            if (napi_get_value_uint32(env, prop, &data->padding) != napi_ok) {
+                return "Padding must be a valid integer";
+            }
+            if (data->padding > li_MAX_DIMENSION) {
+                return "Padding must be at most 4096";
+            }
+        }
+    }
+
+    return nullptr;
+}
+
+static napi_status set_uint32_property(napi_env env, napi_value object, const char* name, uint32_t value) {
+    napi_value prop;
+    napi_status status = napi_create_uint32(env, value, &prop);
+    if (status != napi_ok) return status;
+    return napi_set_named_property(env, object, name, prop);
+}
+
+// { width, height, cellWidth, cellHeight, columns, rows, frameRate,
+//   frames: [{ frame, x, y, width, height }] }
+static napi_status create_frame_map(napi_env env, SpriteSheetData* data, napi_value* result) {
+    ConverterData* base = data->batch->base;
+    napi_value map, frames, prop;
+    napi_status status = napi_create_object(env, &map);
+    if (status == napi_ok) status = set_uint32_property(env, map, "width", data->sheet_width);
+    if (status == napi_ok) status = set_uint32_property(env, map, "height", data->sheet_height);
+    if (status == napi_ok) status = set_uint32_property(env, map, "cellWidth", base->width);
+    if (status == napi_ok) status = set_uint32_property(env, map, "cellHeight", base->height);
+    if (status == napi_ok) status = set_uint32_property(env, map, "columns", data->columns);
+    if (status == napi_ok) status = set_uint32_property(env, map, "rows", data->rows);
+    if (status == napi_ok) status = napi_create_double(env, data->frame_rate, &prop);
+    if (status == napi_ok) status = napi_set_named_property(env, map, "frameRate", prop);
+    if (status == napi_ok) status = napi_create_array_with_length(env, data->cells.size(), &frames);
+
+    for (size_t i = 0; status == napi_ok && i < data->cells.size(); i++) {
+        const SpriteCell& cell = data->cells[i];
+        napi_value entry;
+        status = napi_create_object(env, &entry);
+        if (status == napi_ok) status = set_uint32_property(env, entry, "frame", cell.frame);
+        if (status == napi_ok) status = set_uint32_property(env, entry, "x", cell.x);
+        if (status == napi_ok) status = set_uint32_property(env, entry, "y", cell.y);
+        if (status == napi_ok) status = set_uint32_property(env, entry, "width", base->width);
+        if (status == napi_ok) status = set_uint32_property(env, entry, "height", base->height);
+        if (status == napi_ok) status = napi_set_element(env, frames, (uint32_t)i, entry);
+    }
+
+    if (status == napi_ok) status = napi_set_named_property(env, map, "frames", frames);
+    if (status == napi_ok) *result = map;
+    return status;
+}
+
+static void execute_sprite_sheet_work(napi_env env, void* data) {
+    SpriteSheetData* sheet_data = static_cast<SpriteSheetData*>(data);
+    sheet_data->batch->base->success = export_sprite_sheet_sync(sheet_data);
+}
+
+static void abandon_sprite_sheet_work(void* data) {
+    SpriteSheetData* sheet_data = static_cast<SpriteSheetData*>(data);
+    drop_converter_refs(sheet_data->batch->base);
+    destroy_sprite_sheet_data(sheet_data);
+}
+
+static void complete_sprite_sheet_work(napi_env env, napi_status status, void* data) {
+    SpriteSheetData* sheet_data = static_cast<SpriteSheetData*>(data);
+    ConverterData* base = sheet_data->batch->base;
+    napi_value result;
+
+    if (status == napi_cancelled) {
+        base->error_msg = ls_ABORTED_MESSAGE;
+    }
+
+    if (base->success) {
+        napi_value image, map;
+        status = create_owned_buffer(env, base->result_buffer, base->result_size, &image);
+        base->result_buffer = nullptr;
+        if (status == napi_ok) status = create_frame_map(env, sheet_data, &map);
+        if (status == napi_ok) status = napi_create_object(env, &result);
+        if (status == napi_ok) status = napi_set_named_property(env, result, "image", image);
+        if (status == napi_ok) status = napi_set_named_property(env, result, "map", map);
+        if (status == napi_ok) {
+            napi_resolve_deferred(env, base->deferred, result);
+        } else {
+            napi_create_string_utf8(env, "Failed to create sprite sheet result", NAPI_AUTO_LENGTH, &result);
+            napi_reject_deferred(env, base->deferred, result);
+        }
+    } else {
+        status = napi_create_string_utf8(env, base->error_msg.c_str(), NAPI_AUTO_LENGTH, &result);
+        if (status == napi_ok) {
+            napi_reject_deferred(env, base->deferred, result);
+        }
+    }
+
+    destroy_sprite_sheet_data(sheet_data);
+}
+
+napi_value exportSpriteSheet(napi_env env, napi_callback_info info) {
+    size_t argc = 2;
+    napi_value args[2];
+    napi_status status = napi_get_cb_info(env, info, &argc, args, nullptr, nullptr);
+    CHECK_STATUS(env, status, "Failed to get callback info");
+
+    if (argc < 1) {
+        THROW_ERROR(env, "Expected at least 1 argument: Lottie JSON buffer");
+    }
+
+    SpriteSheetData* data = create_sprite_sheet_data(env, nullptr, 0);
+    if (!data) {
+        THROW_ERROR(env, "Failed to allocate converter data");
+    }
+    ConverterData* base = data->batch->base;
+    const char* input_error = get_converter_input(env, args[0], base, true);
+    if (input_error) {
+        destroy_sprite_sheet_data(data);
+        THROW_ERROR(env, input_error);
+    }
+
+    if (argc >= 2 && args[1] != nullptr) {
+        const char* error = parse_sprite_sheet_options(env, args[1], data);
+        if (error) {
+            destroy_sprite_sheet_data(data);
+            THROW_ERROR(env, error);
+        }
+    }
+
+    napi_value promise;
+    status = napi_create_promise(env, &base->deferred, &promise);
+    if (status != napi_ok) {
+        destroy_sprite_sheet_data(data);
+        THROW_ERROR(env, "Failed to create promise");
+    }
+
+    status = queue_pool_work(env, execute_sprite_sheet_work, complete_sprite_sheet_work, abandon_sprite_sheet_work, data, base->priority, base->cancel);
+    if (status != napi_ok) {
+        destroy_sprite_sheet_data(data);
+        THROW_ERROR(env, "Failed to queue async work");
+    }
+
+    return promise;
+}
\ No newline at end of file
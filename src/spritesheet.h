@@ -0,0 +1,29 @@
+#ifndef SPRITESHEET_H
+#define SPRITESHEET_H
+
+#include <napi.h>
+#include "batch.h"
+
+struct SpriteCell {
+    uint32_t frame;
+    uint32_t x;
+    uint32_t y;
+};
+
+struct SpriteSheetData {
+    BatchData* batch;
+    uint32_t columns;
+    uint32_t rows;
+    uint32_t padding;
+    uint32_t sheet_width;
+    uint32_t sheet_height;
+    double frame_rate;
+    std::vector<SpriteCell> cells;
+};
+
+SpriteSheetData* create_sprite_sheet_data(napi_env env, const byte* in_data, size_t size);
+void destroy_sprite_sheet_data(SpriteSheetData* data);
+bool export_sprite_sheet_sync(SpriteSheetData* data);
+napi_value exportSpriteSheet(napi_env env, napi_callback_info info);
+
+#endif // SPRITESHEET_H
\ No newline at end of file
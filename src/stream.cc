@@ -0,0 +1,445 @@
+#include "stream.h"
+#include "animation.h"
+#include "animation_input.h"
+#include "batch.h"
+#include "buffer_pool.h"
+#include "utils.h"
+#include "worker_pool.h"
+#include <cstring>
+#include <memory>
+#include <mutex>
+
+#define lp_COLOR_BYTES 4
+#define DEFAULT_WINDOW 4
+#define li_MAX_WINDOW 64
+
+enum StreamMessageType {
+    STREAM_FRAME,
+    STREAM_END,
+    STREAM_ERROR
+};
+
+struct StreamMessage {
+    StreamMessageType type;
+    uint32_t frame;
+    byte* buffer;
+    size_t size;
+    std::string error_msg;
+    // The frame rendered identically to the previous one; JS receives the
+    // previous frame's Buffer again instead of a new encode.
+    bool duplicate;
+};
+
+// Frames are rendered and encoded ahead of the consumer by a chain of jobs on
+// the worker pool, one at a time. At most `window` frames are in flight
+// (produced but not yet acknowledged by JS); a job that finds the window full
+// ends, and the acknowledgement that frees a slot queues the next one, so a
+// stalled consumer holds no pool thread.
+struct FrameStream {
+    BatchData* config;
+    napi_env env;
+    napi_threadsafe_function tsfn;
+    std::mutex mutex;
+    uint32_t window;
+    uint32_t in_flight;
+    bool cancelled;
+    // Guarded by mutex: a job for this stream is queued or running.
+    bool scheduled;
+    // Guarded by mutex: the producer has released the tsfn, or the tsfn has
+    // been finalized, so it must not be called again.
+    bool finished;
+    bool closed;
+    // Producer state, only touched by the stream's current job.
+    bool started;
+    std::unique_ptr<rlottie::Animation> animation;
+    std::unique_ptr<ScratchBuffer> buffer;
+    std::unique_ptr<ScratchBuffer> previous;
+    size_t next;
+    bool has_previous;
+    uint32_t previous_frame;
+    // Main thread only: frames delivered to JS and not yet acknowledged.
+    uint32_t js_pending;
+    // Main thread only: the last delivered Buffer, handed out again for
+    // duplicate frames.
+    napi_ref last_frame;
+
+    ~FrameStream() {
+        destroy_batch_data(config);
+    }
+};
+
+static void release_stream(FrameStream* stream) {
+    bool release;
+    {
+        std::lock_guard<std::mutex> lock(stream->mutex);
+        release = !stream->finished && !stream->closed;
+        stream->finished = true;
+        stream->scheduled = false;
+    }
+    if (release) napi_release_threadsafe_function(stream->tsfn, napi_tsfn_release);
+}
+
+static void cancel_stream(FrameStream* stream) {
+    bool idle;
+    {
+        std::lock_guard<std::mutex> lock(stream->mutex);
+        stream->cancelled = true;
+        idle = !stream->scheduled;
+    }
+    // A queued or running job notices the cancellation and releases the tsfn.
+    if (idle) release_stream(stream);
+}
+
+static void send_message(FrameStream* stream, StreamMessage* message) {
+    std::lock_guard<std::mutex> lock(stream->mutex);
+    if (stream->closed || napi_call_threadsafe_function(stream->tsfn, message, napi_tsfn_nonblocking) != napi_ok) {
+        free(message->buffer);
+        delete message;
+    }
+}
+
+static void send_error(FrameStream* stream, const std::string& error_msg) {
+    send_message(stream, new StreamMessage{STREAM_ERROR, 0, nullptr, 0, error_msg, false});
+}
+
+static bool start_stream(FrameStream* stream) {
+    ConverterData* base = stream->config->base;
+    std::string json_data;
+    if (open_converter_input(base) &&
+        decode_animation_input(base->in_data, base->in_size, base->animation_id, json_data, base->error_msg)) {
+        std::string key = animation_model_key(base->in_data, base->in_size, base->resource_path, base->animation_id);
+        stream->animation = load_shared_animation_from_data(std::move(json_data), key, base->resource_path);
+    }
+    size_t frame_bytes = (size_t)base->width * base->height * lp_COLOR_BYTES;
+    if (!stream->animation) {
+        send_error(stream, base->error_msg.empty() ? "Failed to load Lottie animation from provided JSON data" : base->error_msg);
+        return false;
+    }
+    if (!resolve_batch_frames(stream->config, get_total_frames(stream->animation), stream->animation->frameRate())) {
+        send_error(stream, base->error_msg);
+        return false;
+    }
+    stream->buffer.reset(new ScratchBuffer(frame_bytes));
+    if (stream->config->dedupe) stream->previous.reset(new ScratchBuffer(frame_bytes));
+    if (!*stream->buffer || (stream->config->dedupe && !*stream->previous)) {
+        send_error(stream, "Failed to allocate frame buffer (width: " + std::to_string(base->width) + ", height: " + std::to_string(base->height) + ")");
+        return false;
+    }
+    return true;
+}
+
+// Produces frames until the window is full, the stream is cancelled or every
+// frame is out. Returns false once the stream is done.
+static bool produce_frames(FrameStream* stream) {
+    ConverterData* base = stream->config->base;
+    const std::vector<uint32_t>& frames = stream->config->frames;
+    size_t frame_bytes = (size_t)base->width * base->height * lp_COLOR_BYTES;
+    while (stream->next < frames.size()) {
+        {
+            std::lock_guard<std::mutex> lock(stream->mutex);
+            if (stream->cancelled) return false;
+            if (stream->in_flight >= stream->window) {
+                stream->scheduled = false;
+                return true;
+            }
+        }
+
+        uint32_t frame = frames[stream->next++];
+        // A frame repeated by resampling is not even rendered again.
+        bool repeated = stream->has_previous && frame == stream->previous_frame;
+        if (!repeated) {
+            rlottie::Surface surface(stream->buffer->pixels(), base->width, base->height, base->width * lp_COLOR_BYTES);
+            render_frame_sync(stream->animation, frame, surface);
+        }
+
+        StreamMessage* message = new StreamMessage{STREAM_FRAME, frame, nullptr, 0, "", false};
+        stream->previous_frame = frame;
+        if (repeated || (stream->has_previous && memcmp(stream->buffer->data(), stream->previous->data(), frame_bytes) == 0)) {
+            message->duplicate = true;
+        } else if (!encode_frame(stream->buffer->pixels(), base->width, base->height, base->png, base->format, &message->buffer, &message->size, message->error_msg)) {
+            message->type = STREAM_ERROR;
+            send_message(stream, message);
+            return false;
+        } else if (stream->config->dedupe) {
+            std::swap(stream->buffer, stream->previous);
+            stream->has_previous = true;
+        }
+        {
+            std::lock_guard<std::mutex> lock(stream->mutex);
+            stream->in_flight++;
+        }
+        send_message(stream, message);
+    }
+    send_message(stream, new StreamMessage{STREAM_END, 0, nullptr, 0, "", false});
+    return false;
+}
+
+static void execute_stream_work(napi_env env, void* data) {
+    FrameStream* stream = static_cast<std::shared_ptr<FrameStream>*>(data)->get();
+    bool more = true;
+    if (!stream->started) {
+        stream->started = true;
+        more = start_stream(stream);
+    }
+    if (more) more = produce_frames(stream);
+    if (!more) release_stream(stream);
+}
+
+static void complete_stream_work(napi_env env, napi_status status, void* data) {
+    delete static_cast<std::shared_ptr<FrameStream>*>(data);
+}
+
+static void abandon_stream_work(void* data) {
+    std::shared_ptr<FrameStream>* stream = static_cast<std::shared_ptr<FrameStream>*>(data);
+    drop_converter_refs((*stream)->config->base);
+    delete stream;
+}
+
+static bool schedule_stream(const std::shared_ptr<FrameStream>& stream) {
+    std::shared_ptr<FrameStream>* job = new std::shared_ptr<FrameStream>(stream);
+    napi_status status = queue_pool_work(stream->env, execute_stream_work, complete_stream_work, abandon_stream_work, job,
+                                         stream->config->base->priority, nullptr);
+    if (status != napi_ok) {
+        delete job;
+        return false;
+    }
+    return true;
+}
+
+static void call_js_stream(napi_env env, napi_value js_callback, void* context, void* data) {
+    StreamMessage* message = static_cast<StreamMessage*>(data);
+    // Without an env the tsfn is being torn down, after its finalizer has
+    // already freed the context.
+    if (env == nullptr) {
+        free(message->buffer);
+        delete message;
+        return;
+    }
+    std::shared_ptr<FrameStream>& stream = *static_cast<std::shared_ptr<FrameStream>*>(context);
+
+    bool cancelled;
+    {
+        std::lock_guard<std::mutex> lock(stream->mutex);
+        cancelled = stream->cancelled;
+    }
+
+    if (!cancelled) {
+        napi_value argv[4];
+        napi_get_null(env, &argv[0]);
+        napi_get_null(env, &argv[1]);
+        napi_get_null(env, &argv[2]);
+        napi_get_boolean(env, message->duplicate, &argv[3]);
+
+        if (message->type == STREAM_ERROR) {
+            napi_create_string_utf8(env, message->error_msg.c_str(), NAPI_AUTO_LENGTH, &argv[0]);
+        } else if (message->type == STREAM_FRAME) {
+            napi_create_uint32(env, message->frame, &argv[1]);
+            napi_status status;
+            if (message->duplicate) {
+                status = napi_get_reference_value(env, stream->last_frame, &argv[2]);
+            } else {
+                status = create_owned_buffer(env, message->buffer, message->size, &argv[2]);
+                message->buffer = nullptr;
+                if (status == napi_ok && stream->last_frame) {
+                    status = napi_delete_reference(env, stream->last_frame);
+                    stream->last_frame = nullptr;
+                }
+                if (status == napi_ok) {
+                    status = napi_create_reference(env, argv[2], 1, &stream->last_frame);
+                }
+            }
+            if (status != napi_ok) {
+                napi_create_string_utf8(env, "Failed to create result buffer", NAPI_AUTO_LENGTH, &argv[0]);
+                napi_get_null(env, &argv[1]);
+                napi_get_null(env, &argv[2]);
+            } else if (++stream->js_pending == stream->window) {
+                // A stalled consumer must not keep the event loop alive.
+                napi_unref_threadsafe_function(env, stream->tsfn);
+            }
+        }
+
+        napi_value global;
+        napi_get_global(env, &global);
+        napi_call_function(env, global, js_callback, 4, argv, nullptr);
+    }
+
+    free(message->buffer);
+    delete message;
+}
+
+static void finalize_stream_tsfn(napi_env env, void* finalize_data, void* hint) {
+    std::shared_ptr<FrameStream>* stream = static_cast<std::shared_ptr<FrameStream>*>(finalize_data);
+    {
+        std::lock_guard<std::mutex> lock((*stream)->mutex);
+        (*stream)->closed = true;
+        (*stream)->cancelled = true;
+    }
+    if ((*stream)->last_frame) {
+        napi_delete_reference(env, (*stream)->last_frame);
+    }
+    delete stream;
+}
+
+static void finalize_stream_handle(napi_env env, void* data, void* hint) {
+    std::shared_ptr<FrameStream>* stream = static_cast<std::shared_ptr<FrameStream>*>(data);
+    cancel_stream(stream->get());
+    delete stream;
+}
+
+static std::shared_ptr<FrameStream>* get_stream_handle(napi_env env, napi_value value) {
+    napi_valuetype value_type;
+    void* handle = nullptr;
+    if (napi_typeof(env, value, &value_type) != napi_ok || value_type != napi_external ||
+        napi_get_value_external(env, value, &handle) != napi_ok || !handle) {
+        napi_throw_error(env, nullptr, "Invalid frame stream handle");
+        return nullptr;
+    }
+    return static_cast<std::shared_ptr<FrameStream>*>(handle);
+}
+
+napi_value createFrameStream(napi_env env, napi_callback_info info) {
+    size_t argc = 3;
+    napi_value args[3];
+    napi_status status = napi_get_cb_info(env, info, &argc, args, nullptr, nullptr);
+    CHECK_STATUS(env, status, "Failed to get callback info");
+
+    if (argc < 3) {
+        THROW_ERROR(env, "Expected 3 arguments: Lottie JSON buffer, options and frame callback");
+    }
+
+    napi_valuetype callback_type;
+    status = napi_typeof(env, args[2], &callback_type);
+    if (status != napi_ok || callback_type != napi_function) {
+        THROW_ERROR(env, "Frame callback must be a function");
+    }
+
+    BatchData* config = create_batch_data(env, nullptr, 0);
+    if (!config) {
+        THROW_ERROR(env, "Failed to allocate converter data");
+    }
+    const char* input_error = get_converter_input(env, args[0], config->base, true);
+    if (input_error) {
+        destroy_batch_data(config);
+        THROW_ERROR(env, input_error);
+    }
+
+    std::shared_ptr<FrameStream> stream = std::make_shared<FrameStream>();
+    stream->config = config;
+    stream->env = env;
+    stream->tsfn = nullptr;
+    stream->window = DEFAULT_WINDOW;
+    stream->in_flight = 0;
+    stream->cancelled = false;
+    stream->scheduled = true;
+    stream->finished = false;
+    stream->closed = false;
+    stream->started = false;
+    stream->next = 0;
+    stream->has_previous = false;
+    stream->previous_frame = 0;
+    stream->js_pending = 0;
+    stream->last_frame = nullptr;
+
+    const char* error = parse_batch_options(env, args[1], config);
+    if (error) {
+        THROW_ERROR(env, error);
+    }
+
+    napi_valuetype options_type;
+    status = napi_typeof(env, args[1], &options_type);
+    if (status == napi_ok && options_type == napi_object && has_own_property(env, args[1], "window")) {
+        napi_value prop;
+        uint32_t window;
+        status = napi_get_named_property(env, args[1], "window", &prop);
+        if (status != napi_ok || napi_get_value_uint32(env, prop, &window) != napi_ok) {
+            THROW_ERROR(env, "Window must be a valid integer");
+        }
+        if (window < 1 || window > li_MAX_WINDOW) {
+            THROW_ERROR(env, "Window must be between 1 and 64");
+        }
+        stream->window = window;
+    }
+
+    napi_value resource_name;
+    status = napi_create_string_utf8(env, "LottieFrameStream", NAPI_AUTO_LENGTH, &resource_name);
+    CHECK_STATUS(env, status, "Failed to create resource name");
+
+    std::shared_ptr<FrameStream>* tsfn_context = new std::shared_ptr<FrameStream>(stream);
+    status = napi_create_threadsafe_function(env, args[2], nullptr, resource_name, 0, 1, tsfn_context, finalize_stream_tsfn,
+                                             tsfn_context, call_js_stream, &stream->tsfn);
+    if (status != napi_ok) {
+        delete tsfn_context;
+        THROW_ERROR(env, "Failed to create frame stream callback");
+    }
+
+    napi_value handle;
+    std::shared_ptr<FrameStream>* handle_data = new std::shared_ptr<FrameStream>(stream);
+    status = napi_create_external(env, handle_data, finalize_stream_handle, nullptr, &handle);
+    if (status != napi_ok) {
+        delete handle_data;
+        napi_release_threadsafe_function(stream->tsfn, napi_tsfn_abort);
+        THROW_ERROR(env, "Failed to create frame stream handle");
+    }
+
+    if (!schedule_stream(stream)) {
+        {
+            std::lock_guard<std::mutex> lock(stream->mutex);
+            stream->cancelled = true;
+            stream->finished = true;
+        }
+        napi_release_threadsafe_function(stream->tsfn, napi_tsfn_abort);
+        THROW_ERROR(env, "Failed to queue frame stream work");
+    }
+
+    return handle;
+}
+
+napi_value ackFrameStream(napi_env env, napi_callback_info info) {
+    size_t argc = 1;
+    napi_value args[1];
+    napi_status status = napi_get_cb_info(env, info, &argc, args, nullptr, nullptr);
+    CHECK_STATUS(env, status, "Failed to get callback info");
+
+    if (argc < 1) {
+        THROW_ERROR(env, "Expected 1 argument: frame stream handle");
+    }
+
+    std::shared_ptr<FrameStream>* stream = get_stream_handle(env, args[0]);
+    if (!stream) return nullptr;
+
+    bool resume;
+    {
+        std::lock_guard<std::mutex> lock((*stream)->mutex);
+        if ((*stream)->js_pending == 0) {
+            THROW_ERROR(env, "No frame to acknowledge");
+        }
+        if ((*stream)->js_pending-- == (*stream)->window && !(*stream)->cancelled) {
+            napi_ref_threadsafe_function(env, (*stream)->tsfn);
+        }
+        (*stream)->in_flight--;
+        resume = !(*stream)->scheduled && !(*stream)->finished && !(*stream)->cancelled;
+        if (resume) (*stream)->scheduled = true;
+    }
+    if (resume && !schedule_stream(*stream)) {
+        send_error(stream->get(), "Failed to queue frame stream work");
+        release_stream(stream->get());
+    }
+    return nullptr;
+}
+
+napi_value cancelFrameStream(napi_env env, napi_callback_info info) {
+    size_t argc = 1;
+    napi_value args[1];
+    napi_status status = napi_get_cb_info(env, info, &argc, args, nullptr, nullptr);
+    CHECK_STATUS(env, status, "Failed to get callback info");
+
+    if (argc < 1) {
+        THROW_ERROR(env, "Expected 1 argument: frame stream handle");
+    }
+
+    std::shared_ptr<FrameStream>* stream = get_stream_handle(env, args[0]);
+    if (!stream) return nullptr;
+
+    cancel_stream(stream->get());
+    return nullptr;
+}
\ No newline at end of file
@@ -0,0 +1,10 @@
+#ifndef STREAM_H
+#define STREAM_H
+
+#include <napi.h>
+
+napi_value createFrameStream(napi_env env, napi_callback_info info);
+napi_value ackFrameStream(napi_env env, napi_callback_info info);
+napi_value cancelFrameStream(napi_env env, napi_callback_info info);
+
+#endif // STREAM_H
\ No newline at end of file
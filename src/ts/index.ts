@@ -3,27 +3,663 @@ import { join } from "node:path";
 
 const moduleDir = __dirname;
 
+/**
+ * Output format of an exported frame. `png`, `png-fast` and `qoi` encode the
+ * frame; the others are raw pixels, 4 bytes per pixel with rows packed.
+ * `png-fast` is a standard PNG from a run-length-only encoder that is much
+ * faster on flat art but compresses less, and ignores `compressionLevel`,
+ * `filter` and `strategy`. `qoi` is a lossless QOI image (https://qoiformat.org).
+ * `rgba` and `bgra` have straight alpha; `argb-premul` is the renderer's own
+ * premultiplied ARGB32 in native byte order (B, G, R, A bytes on little-endian
+ * machines).
+ * @typedef {"png" | "png-fast" | "qoi" | "rgba" | "bgra" | "argb-premul"} PixelFormat
+ */
+export type PixelFormat = "png" | "png-fast" | "qoi" | "rgba" | "bgra" | "argb-premul";
+
+/**
+ * PNG row filter. `adaptive` picks the best filter per row.
+ * @typedef {"none" | "sub" | "up" | "average" | "paeth" | "adaptive"} PngFilter
+ */
+export type PngFilter = "none" | "sub" | "up" | "average" | "paeth" | "adaptive";
+
+/**
+ * zlib compression strategy for PNG data.
+ * @typedef {"default" | "filtered" | "huffman" | "rle"} PngStrategy
+ */
+export type PngStrategy = "default" | "filtered" | "huffman" | "rle";
+
+/**
+ * Scheduling class of a job on the addon's worker pool. Queued jobs of a
+ * higher class always start before those of a lower one.
+ * @typedef {"high" | "normal" | "low"} JobPriority
+ */
+export type JobPriority = "high" | "normal" | "low";
+
+/**
+ * Memory a raw frame can be rendered into.
+ * @typedef {ArrayBuffer | SharedArrayBuffer | ArrayBufferView} FrameTarget
+ */
+export type FrameTarget = ArrayBuffer | SharedArrayBuffer | ArrayBufferView;
+
+/**
+ * An animation file to read natively instead of passing its contents. The
+ * file is memory-mapped on the worker thread and decoded in place, so large
+ * files never pass through a JS Buffer.
+ * @typedef {Object} FileInput
+ * @property {string} path - Path of the JSON, .tgs or .lottie file.
+ */
+export interface FileInput {
+  path: string;
+}
+
+/**
+ * Animation data, either in memory or as a file to read.
+ * @typedef {Buffer | FileInput} LottieInput
+ */
+export type LottieInput = Buffer | FileInput;
+
 /**
  * Options for exporting a frame from a Lottie animation.
  * @typedef {Object} Options
  * @property {number} [frame] - The frame number to export (non-negative integer, default: 0).
- * @property {number} [width] - The width of the exported PNG (integer between 1 and 4096, default: 100).
- * @property {number} [height] - The height of the exported PNG (integer between 1 and 4096, default: 100).
- * @property {number} [quality] - The PNG compression quality (integer between 1 and 100, default: 100).
+ * @property {number} [width] - The width of the exported frame (integer between 1 and 4096, default: 100). Single frames allow up to 16384.
+ * @property {number} [height] - The height of the exported frame (integer between 1 and 4096, default: 100). Single frames allow up to 16384.
+ * @property {number} [quality] - The legacy PNG compression quality (integer between 1 and 100); 100 maps to level 0, i.e. stored. Superseded by `compressionLevel`.
+ * @property {number} [compressionLevel] - The zlib compression level of PNG data (integer between 0 and 9, default: 1).
+ * @property {PngFilter} [filter] - The PNG row filter (default: "adaptive").
+ * @property {PngStrategy} [strategy] - The zlib strategy (default: "default").
+ * @property {number} [compressionThreads] - Threads to filter and compress large PNG frames on (integer between 1 and 64, default: 1).
+ * @property {string} [resourcePath] - Directory that external image assets are resolved against.
+ * @property {string} [animationId] - Which animation of a dotLottie archive to use (default: the first in its manifest). Ignored for other inputs.
+ * @property {PixelFormat} [format] - The output format (default: "png").
+ * @property {JobPriority} [priority] - Scheduling class on the worker pool (default: "normal"). Asynchronous calls only.
+ * @property {AbortSignal} [signal] - Aborts the call: a queued job is dropped and a running one stops before encoding. Asynchronous calls only.
  */
 export interface Options {
   frame?: number;
   height?: number;
   width?: number;
   quality?: number;
+  compressionLevel?: number;
+  filter?: PngFilter;
+  strategy?: PngStrategy;
+  compressionThreads?: number;
+  resourcePath?: string;
+  animationId?: string;
+  format?: PixelFormat;
+  priority?: JobPriority;
+  signal?: AbortSignal;
+}
+
+/**
+ * A region of the `width` x `height` canvas, in canvas pixels.
+ * @typedef {Object} Viewport
+ * @property {number} x - Left edge (non-negative).
+ * @property {number} y - Top edge (non-negative).
+ * @property {number} width - Width of the region (positive).
+ * @property {number} height - Height of the region (positive).
+ */
+export interface Viewport {
+  x: number;
+  y: number;
+  width: number;
+  height: number;
+}
+
+/**
+ * Options for exporting a single frame.
+ * @typedef {Object} FrameOptions
+ * @property {FrameTarget} [target] - Memory to render a raw frame into instead of a new Buffer. Must hold at least `width * height * 4` bytes of the output size.
+ * @property {boolean} [timings] - Attach a `timings` breakdown of the call to the result (default: false).
+ * @property {boolean} [shareCached] - Return a result served by the frame cache as a view of the cached memory instead of a copy (default: false). The view must not be written to.
+ * @property {Viewport} [viewport] - Render only this region of the canvas (default: the whole canvas).
+ * @property {number} [scale] - Magnification of the viewport: the output is `viewport * scale` pixels (greater than 0 and at most 16, default: 1).
+ * @property {number} [tileSize] - Render in parallel tiles of at most this many pixels square (integer between 64 and 4096, default: one tile up to 4096, else 2048).
+ * @property {number} [time] - Render the frame nearest to this many milliseconds into the animation, instead of `frame` (non-negative, clamped to the last frame).
+ * @property {number} [progress] - Render the frame at this position through the animation, instead of `frame` (between 0 and 1).
+ */
+export interface FrameOptions extends Options {
+  target?: FrameTarget;
+  timings?: boolean;
+  shareCached?: boolean;
+  viewport?: Viewport;
+  scale?: number;
+  tileSize?: number;
+  time?: number;
+  progress?: number;
+}
+
+/**
+ * Where the time and memory of one single-frame export went. A stage that
+ * did not run reports 0: `queueNs` for synchronous calls, `parseNs` when the
+ * animation was already loaded.
+ * @typedef {Object} FrameTimings
+ * @property {number} queueNs - Time waiting on the worker pool.
+ * @property {number} parseNs - Time decoding and parsing the animation, or looking it up in the cache.
+ * @property {number} renderNs - Time rasterizing the frame.
+ * @property {number} encodeNs - Time encoding the PNG or QOI image, or converting raw pixels.
+ * @property {number} totalNs - Time from start to finish on the worker, excluding the queue.
+ * @property {number} inputBytes - Size of the animation data.
+ * @property {number} outputBytes - Size of the encoded or raw frame.
+ * @property {number} surfaceBytes - Size of the render surface.
+ */
+export interface FrameTimings {
+  queueNs: number;
+  parseNs: number;
+  renderNs: number;
+  encodeNs: number;
+  totalNs: number;
+  inputBytes: number;
+  outputBytes: number;
+  surfaceBytes: number;
+}
+
+/**
+ * A frame result, carrying `timings` when they were requested.
+ */
+export type Timed<T> = T & { timings?: FrameTimings };
+
+/**
+ * A range of frames, with an inclusive end.
+ * @typedef {Object} FrameRange
+ * @property {number} [start] - The first frame to export (default: 0).
+ * @property {number} [end] - The last frame to export (default: the last frame of the animation).
+ * @property {number} [step] - The distance between exported frames (positive integer, default: 1).
+ */
+export interface FrameRange {
+  start?: number;
+  end?: number;
+  step?: number;
+}
+
+/**
+ * Options for exporting several frames of a Lottie animation at once.
+ * @typedef {Object} BatchOptions
+ * @property {number[] | FrameRange} [frames] - The frames to export (default: every frame).
+ * @property {number} [concurrency] - Number of worker pool threads to render on (integer between 1 and 64, default: number of CPUs), capped by the pool's size.
+ * @property {boolean} [dedupe] - Reuse the previous frame's output when a frame renders identically, and render a frame requested several times once (default: true).
+ * @property {number[]} [times] - Export the frames nearest to these times in milliseconds, instead of `frames`.
+ * @property {number} [fps] - Resample the whole animation to this frame rate, instead of `frames` (greater than 0 and at most 1000).
+ */
+export interface BatchOptions extends Omit<Options, "frame"> {
+  frames?: number[] | FrameRange;
+  concurrency?: number;
+  dedupe?: boolean;
+  times?: number[];
+  fps?: number;
+}
+
+/**
+ * The frames produced by `exportFrames`. Frames that rendered identically to
+ * the frame before them, or that were requested more than once, share a
+ * Buffer instance.
+ * @typedef {Buffer[]} BatchResult
+ * @property {Array<[number, number]>} duplicates - An `[index, sourceIndex]` pair for each deduplicated result, in order: `result[index]` is the same Buffer as `result[sourceIndex]`, the entry that was encoded.
+ * @property {number[]} frames - The frame number of each result, which is how `times` and `fps` samples map onto the animation.
+ */
+export type BatchResult = Buffer[] & { duplicates: Array<[number, number]>; frames: number[] };
+
+/**
+ * Options for exporting a whole Lottie animation as one animated image.
+ * @typedef {Object} AnimationOptions
+ * @property {"apng"} [format] - The animated image format (default: "apng").
+ * @property {FrameRange} [frameRange] - The frames to include (default: every frame).
+ * @property {number} [fpsOverride] - Playback frame rate, instead of the animation's own (greater than 0, at most 1000).
+ * @property {number} [loop] - Number of times to play the animation, 0 for forever (default: 0).
+ */
+export interface AnimationOptions extends Omit<Options, "frame" | "format"> {
+  format?: "apng";
+  frameRange?: FrameRange;
+  fpsOverride?: number;
+  loop?: number;
+}
+
+/**
+ * Options for exporting frames of a Lottie animation as one sprite sheet.
+ * @typedef {Object} SpriteSheetOptions
+ * @property {number} [columns] - Number of cells per row (integer between 1 and 4096, default: the square root of the frame count, rounded up).
+ * @property {number} [frameStep] - Include every Nth frame (positive integer, default: 1). Cannot be combined with `frames`.
+ * @property {number} [cellWidth] - Width of each cell in pixels (integer between 1 and 4096, default: 100).
+ * @property {number} [cellHeight] - Height of each cell in pixels (integer between 1 and 4096, default: 100).
+ * @property {number} [padding] - Transparent gap between cells in pixels (integer between 0 and 4096, default: 0).
+ */
+export interface SpriteSheetOptions
+  extends Omit<BatchOptions, "width" | "height" | "dedupe"> {
+  columns?: number;
+  frameStep?: number;
+  cellWidth?: number;
+  cellHeight?: number;
+  padding?: number;
+}
+
+/**
+ * The position of one frame in a sprite sheet.
+ * @typedef {Object} SpriteSheetFrame
+ * @property {number} frame - The frame number.
+ * @property {number} x - Left edge of the cell in pixels.
+ * @property {number} y - Top edge of the cell in pixels.
+ * @property {number} width - Width of the cell in pixels.
+ * @property {number} height - Height of the cell in pixels.
+ */
+export interface SpriteSheetFrame {
+  frame: number;
+  x: number;
+  y: number;
+  width: number;
+  height: number;
+}
+
+/**
+ * The layout of a sprite sheet. Plain data, so it can be serialized with
+ * `JSON.stringify` and shipped next to the image.
+ * @typedef {Object} SpriteSheetMap
+ * @property {number} width - Width of the sheet in pixels.
+ * @property {number} height - Height of the sheet in pixels.
+ * @property {number} cellWidth - Width of each cell in pixels.
+ * @property {number} cellHeight - Height of each cell in pixels.
+ * @property {number} columns - Number of cells per row.
+ * @property {number} rows - Number of rows.
+ * @property {number} frameRate - The animation's frame rate in frames per second.
+ * @property {SpriteSheetFrame[]} frames - The cells, in frame order.
+ */
+export interface SpriteSheetMap {
+  width: number;
+  height: number;
+  cellWidth: number;
+  cellHeight: number;
+  columns: number;
+  rows: number;
+  frameRate: number;
+  frames: SpriteSheetFrame[];
+}
+
+/**
+ * A sprite sheet produced by `exportSpriteSheet`.
+ * @typedef {Object} SpriteSheet
+ * @property {Buffer} image - The sheet in the requested format.
+ * @property {SpriteSheetMap} map - The position of every frame in the sheet.
+ */
+export interface SpriteSheet {
+  image: Buffer;
+  map: SpriteSheetMap;
+}
+
+/**
+ * Options for streaming frames of a Lottie animation.
+ * @typedef {Object} StreamOptions
+ * @property {number} [window] - Maximum number of frames rendered ahead of the consumer (integer between 1 and 64, default: 4).
+ */
+export interface StreamOptions
+  extends Omit<BatchOptions, "concurrency" | "priority" | "signal"> {
+  window?: number;
+}
+
+/**
+ * A frame produced by `streamFrames`.
+ * @typedef {Object} StreamedFrame
+ * @property {number} frame - The frame number.
+ * @property {Buffer} data - The frame in the requested format.
+ * @property {boolean} duplicate - Whether the frame rendered identically to the previous one, in which case `data` is the previous frame's Buffer.
+ */
+export interface StreamedFrame {
+  frame: number;
+  data: Buffer;
+  duplicate: boolean;
+}
+
+/**
+ * Options for loading a Lottie animation.
+ * @typedef {Object} LoadOptions
+ * @property {string} [resourcePath] - Directory that external image assets are resolved against.
+ * @property {string} [animationId] - Which animation of a dotLottie archive to load (default: the first in its manifest). Ignored for other inputs.
+ */
+export interface LoadOptions {
+  resourcePath?: string;
+  animationId?: string;
+}
+
+/**
+ * Options for probing a Lottie animation.
+ * @typedef {Object} ProbeOptions
+ * @property {AnimationSize[]} [sizes] - Output sizes to estimate the cost of (default: the intrinsic size).
+ */
+export interface ProbeOptions extends LoadOptions {
+  sizes?: AnimationSize[];
+}
+
+/**
+ * A named frame range of a probed animation.
+ * @typedef {Object} ProbeLayer
+ * @property {string} name - The layer name.
+ * @property {number} inFrame - The frame the layer starts at.
+ * @property {number} outFrame - The frame the layer ends at.
+ */
+export interface ProbeLayer {
+  name: string;
+  inFrame: number;
+  outFrame: number;
+}
+
+/**
+ * A marker of a probed animation.
+ * @typedef {Object} ProbeMarker
+ * @property {string} name - The marker name.
+ * @property {number} startFrame - The first frame of the marker.
+ * @property {number} endFrame - The last frame of the marker.
+ */
+export interface ProbeMarker {
+  name: string;
+  startFrame: number;
+  endFrame: number;
 }
 
+/**
+ * Structure counts of a probed animation. Layers and shapes inside precomps
+ * are counted once per definition, not per instance.
+ * @typedef {Object} ProbeComplexity
+ * @property {number} layers - Layers, including those of precomps.
+ * @property {number} shapes - Shape items, including those nested in groups.
+ * @property {number} masks - Layer masks.
+ * @property {number} precomps - Precomposition assets.
+ * @property {number} images - Image assets.
+ */
+export interface ProbeComplexity {
+  layers: number;
+  shapes: number;
+  masks: number;
+  precomps: number;
+  images: number;
+}
+
+/**
+ * Estimated cost of one PNG export at a given size.
+ * @typedef {Object} ProbeEstimate
+ * @property {number} width - The output width.
+ * @property {number} height - The output height.
+ * @property {number} surfaceBytes - Size of the render surface.
+ * @property {number} pngBytes - Worst-case size of the encoded PNG.
+ * @property {number} peakBytes - Estimated peak native memory of the export.
+ * @property {number} renderCost - Output megapixels times the layer, shape and mask count; a relative figure, not a time.
+ */
+export interface ProbeEstimate {
+  width: number;
+  height: number;
+  surfaceBytes: number;
+  pngBytes: number;
+  peakBytes: number;
+  renderCost: number;
+}
+
+/**
+ * Metadata of a Lottie animation, read without rendering it.
+ * @typedef {Object} ProbeResult
+ * @property {number} totalFrames - The number of frames.
+ * @property {number} frameRate - The frame rate in frames per second.
+ * @property {number} duration - The duration in seconds.
+ * @property {AnimationSize} size - The intrinsic size of the composition.
+ * @property {number} inputBytes - Size of the input.
+ * @property {number} jsonBytes - Size of the Lottie JSON after decompression.
+ * @property {ProbeLayer[]} layers - The top-level layers.
+ * @property {ProbeMarker[]} markers - The markers.
+ * @property {ProbeComplexity} complexity - Structure counts.
+ * @property {ProbeEstimate[]} estimates - One estimate per requested size.
+ */
+export interface ProbeResult {
+  totalFrames: number;
+  frameRate: number;
+  duration: number;
+  size: AnimationSize;
+  inputBytes: number;
+  jsonBytes: number;
+  layers: ProbeLayer[];
+  markers: ProbeMarker[];
+  complexity: ProbeComplexity;
+  estimates: ProbeEstimate[];
+}
+
+/**
+ * Options for the process-wide parsed animation cache.
+ * @typedef {Object} AnimationCacheOptions
+ * @property {number} [maxEntries] - Maximum number of cached animations (0 disables the cache, default: 0).
+ * @property {number} [maxBytes] - Maximum total decoded JSON size of cached animations in bytes (0 means unlimited, default: 0).
+ */
+export interface AnimationCacheOptions {
+  maxEntries?: number;
+  maxBytes?: number;
+}
+
+/**
+ * Counters of the process-wide parsed animation cache.
+ * @typedef {Object} AnimationCacheStats
+ * @property {number} hits - Loads served from the cache.
+ * @property {number} misses - Loads that had to parse the animation.
+ * @property {number} evictions - Entries dropped to stay within the budget.
+ * @property {number} entries - Animations currently cached.
+ * @property {number} bytes - Total decoded JSON size of the cached animations.
+ * @property {number} maxEntries - The configured entry budget.
+ * @property {number} maxBytes - The configured byte budget.
+ */
+export interface AnimationCacheStats {
+  hits: number;
+  misses: number;
+  evictions: number;
+  entries: number;
+  bytes: number;
+  maxEntries: number;
+  maxBytes: number;
+}
+
+/**
+ * Options for the process-wide rendered frame cache.
+ * @typedef {Object} FrameCacheOptions
+ * @property {number} [maxBytes] - Maximum total size of cached encoded frames in bytes (0 disables the cache, default: 0).
+ */
+export interface FrameCacheOptions {
+  maxBytes?: number;
+}
+
+/**
+ * Counters of the process-wide rendered frame cache.
+ * @typedef {Object} FrameCacheStats
+ * @property {number} hits - Exports served from the cache.
+ * @property {number} misses - Exports that had to render.
+ * @property {number} coalesced - Exports that shared an identical render already in flight.
+ * @property {number} evictions - Entries dropped to stay within the budget.
+ * @property {number} entries - Frames currently cached.
+ * @property {number} bytes - Total size of the cached frames.
+ * @property {number} maxBytes - The configured byte budget.
+ */
+export interface FrameCacheStats {
+  hits: number;
+  misses: number;
+  coalesced: number;
+  evictions: number;
+  entries: number;
+  bytes: number;
+  maxBytes: number;
+}
+
+/**
+ * Allocation counters of the native frame buffer pool.
+ * @typedef {Object} BufferPoolStats
+ * @property {number} scratchAllocations - Render and conversion buffers that had to be allocated.
+ * @property {number} scratchReuses - Render and conversion buffers served from the pool.
+ * @property {number} pooledBytes - Bytes currently held by idle pooled buffers.
+ * @property {number} outputAllocations - Allocations and resizes of encoded output buffers.
+ */
+export interface BufferPoolStats {
+  scratchAllocations: number;
+  scratchReuses: number;
+  pooledBytes: number;
+  outputAllocations: number;
+}
+
+/**
+ * Counters of one priority class of the worker pool queue.
+ * @typedef {Object} JobQueueStats
+ * @property {number} depth - Jobs currently waiting.
+ * @property {number} queued - Jobs queued so far.
+ * @property {number} started - Jobs that have started running.
+ * @property {number} cancelled - Jobs aborted before they started.
+ * @property {number} averageWaitMs - Mean time from queueing to start, in milliseconds.
+ * @property {number} maxWaitMs - Longest time from queueing to start, in milliseconds.
+ */
+export interface JobQueueStats {
+  depth: number;
+  queued: number;
+  started: number;
+  cancelled: number;
+  averageWaitMs: number;
+  maxWaitMs: number;
+}
+
+/**
+ * State of the addon's worker pool.
+ * @typedef {Object} QueueStats
+ * @property {number} concurrency - Number of worker threads.
+ * @property {number} running - Pool threads currently busy, running jobs or helping one fan out.
+ * @property {JobQueueStats} high - Counters of high priority jobs.
+ * @property {JobQueueStats} normal - Counters of normal priority jobs.
+ * @property {JobQueueStats} low - Counters of low priority jobs.
+ */
+export interface QueueStats {
+  concurrency: number;
+  running: number;
+  high: JobQueueStats;
+  normal: JobQueueStats;
+  low: JobQueueStats;
+}
+
+/**
+ * A bucket of a latency histogram.
+ * @typedef {Object} HistogramBucket
+ * @property {number} upperNs - Exclusive upper bound of the bucket.
+ * @property {number} count - Samples in the bucket.
+ */
+export interface HistogramBucket {
+  upperNs: number;
+  count: number;
+}
+
+/**
+ * Latency distribution of one stage. Buckets are log-linear, four per power
+ * of two, so quantiles are accurate to within 25%.
+ * @typedef {Object} StageHistogram
+ * @property {number} count - Number of samples.
+ * @property {number} meanNs - Mean latency.
+ * @property {number} p50Ns - Median latency.
+ * @property {number} p90Ns - 90th percentile latency.
+ * @property {number} p99Ns - 99th percentile latency.
+ * @property {number} maxNs - Highest latency seen.
+ * @property {HistogramBucket[]} buckets - The non-empty buckets, in ascending order.
+ */
+export interface StageHistogram {
+  count: number;
+  meanNs: number;
+  p50Ns: number;
+  p90Ns: number;
+  p99Ns: number;
+  maxNs: number;
+  buckets: HistogramBucket[];
+}
+
+/**
+ * Cumulative metrics of single-frame exports since the process started.
+ * @typedef {Object} Stats
+ * @property {number} calls - Calls that ran, successful or not.
+ * @property {number} failures - Calls that failed or were aborted while running.
+ * @property {number} inFlight - Calls running right now.
+ * @property {number} inputBytes - Total animation data of successful calls.
+ * @property {number} outputBytes - Total frame data of successful calls.
+ * @property {Object} stages - A `StageHistogram` each for `queue`, `parse`, `render`, `encode` and `total`, over successful calls.
+ */
+export interface Stats {
+  calls: number;
+  failures: number;
+  inFlight: number;
+  inputBytes: number;
+  outputBytes: number;
+  stages: {
+    queue: StageHistogram;
+    parse: StageHistogram;
+    render: StageHistogram;
+    encode: StageHistogram;
+    total: StageHistogram;
+  };
+}
+
+/**
+ * Intrinsic size of a Lottie animation.
+ * @typedef {Object} AnimationSize
+ * @property {number} width - The composition width in pixels.
+ * @property {number} height - The composition height in pixels.
+ */
+export interface AnimationSize {
+  width: number;
+  height: number;
+}
+
+/**
+ * Interface for a parsed animation handle created by the native module.
+ */
+export interface NativeAnimation {
+  readonly totalFrames: number;
+  readonly frameRate: number;
+  readonly duration: number;
+  readonly size: AnimationSize;
+  renderFrame(options?: NativeOptions<FrameOptions>): Promise<Buffer | FrameTarget>;
+  renderFrameSync(options?: FrameOptions): Buffer | FrameTarget;
+  share(): number;
+}
+
+/**
+ * Options as passed to the native module, which cancels jobs through a token
+ * rather than an AbortSignal.
+ */
+type NativeOptions<T> = T & { cancelToken?: object };
+
 /**
  * Interface for the native module functions.
  */
 interface NativeModule {
-  exportFrame(buffer: Buffer, options?: Options): Promise<Buffer>;
-  exportFrameSync(buffer: Buffer, options?: Options): Buffer;
+  exportFrame(input: LottieInput, options?: NativeOptions<FrameOptions>): Promise<Buffer | FrameTarget>;
+  exportFrameSync(input: LottieInput, options?: FrameOptions): Buffer | FrameTarget;
+  exportFrames(input: LottieInput, options?: NativeOptions<BatchOptions>): Promise<BatchResult>;
+  exportAnimation(input: LottieInput, options?: NativeOptions<AnimationOptions>): Promise<Buffer>;
+  exportSpriteSheet(
+    input: LottieInput,
+    options?: NativeOptions<SpriteSheetOptions>
+  ): Promise<SpriteSheet>;
+  createFrameStream(
+    input: LottieInput,
+    options: StreamOptions,
+    callback: (
+      error: string | null,
+      frame: number | null,
+      data: Buffer | null,
+      duplicate: boolean
+    ) => void
+  ): object;
+  ackFrameStream(handle: object): void;
+  cancelFrameStream(handle: object): void;
+  loadAnimation(input: LottieInput, options?: LoadOptions): Promise<NativeAnimation>;
+  loadAnimationSync(input: LottieInput, options?: LoadOptions): NativeAnimation;
+  openSharedAnimation(id: number): NativeAnimation;
+  releaseSharedAnimation(id: number): boolean;
+  probe(input: LottieInput, options?: ProbeOptions): Promise<ProbeResult>;
+  probeSync(input: LottieInput, options?: ProbeOptions): ProbeResult;
+  configureAnimationCache(options: AnimationCacheOptions): void;
+  clearAnimationCache(): void;
+  getAnimationCacheStats(): AnimationCacheStats;
+  configureFrameCache(options: FrameCacheOptions): void;
+  clearFrameCache(): void;
+  getFrameCacheStats(): FrameCacheStats;
+  getBufferPoolStats(): BufferPoolStats;
+  setConcurrency(concurrency: number): void;
+  getQueueStats(): QueueStats;
+  createCancelToken(): object;
+  cancelToken(token: object): void;
+  getStats(): Stats;
 }
 
 /**
@@ -58,63 +694,1012 @@ function loadNativeModule(): NativeModule {
 const native = loadNativeModule();
 
 /**
- * Asynchronously exports a frame from a Lottie animation to PNG.
- * @param {Buffer} buffer - The Lottie JSON animation data.
- * @param {Options} [options] - Configuration options for the export.
- * @returns {Promise<Buffer>} A promise resolving to the PNG data as a Buffer.
- * @throws {TypeError} If `buffer` is not a Buffer.
+ * Asynchronously exports a frame from a Lottie animation to PNG or raw pixels.
+ * @param {LottieInput} input - The Lottie animation data: JSON, a gzip-compressed .tgs sticker or a .lottie archive, in a Buffer or in a file.
+ * @param {FrameOptions} [options] - Configuration options for the export.
+ * @returns {Promise<Buffer | FrameTarget>} A promise resolving to the frame as a Buffer, or to `options.target` once the frame has been rendered into it.
+ * @throws {TypeError} If `input` is neither a Buffer nor a `{ path }` object.
  * @throws {RangeError} If any option value is invalid.
  * @throws {Error} If the native module fails to process the animation.
  */
+export function exportFrame<T extends FrameTarget>(
+  input: LottieInput,
+  options: FrameOptions & { target: T }
+): Promise<Timed<T>>;
+export function exportFrame(
+  input: LottieInput,
+  options?: FrameOptions
+): Promise<Timed<Buffer>>;
 export async function exportFrame(
-  buffer: Buffer,
-  options?: Options
+  input: LottieInput,
+  options?: FrameOptions
+): Promise<Buffer | FrameTarget> {
+  validateInput(input, options);
+  const result = await runAbortable(options?.signal, (cancelToken) =>
+    native.exportFrame(input, toNativeOptions(options, cancelToken))
+  );
+  return frameResult(options, result);
+}
+
+/**
+ * Synchronously exports a frame from a Lottie animation to PNG or raw pixels.
+ * @param {LottieInput} input - The Lottie animation data: JSON, a gzip-compressed .tgs sticker or a .lottie archive, in a Buffer or in a file.
+ * @param {FrameOptions} [options] - Configuration options for the export.
+ * @returns {Buffer | FrameTarget} The frame as a Buffer, or `options.target` once the frame has been rendered into it.
+ * @throws {TypeError} If `input` is neither a Buffer nor a `{ path }` object.
+ * @throws {RangeError} If any option value is invalid.
+ * @throws {Error} If the native module fails to process the animation.
+ */
+export function exportFrameSync<T extends FrameTarget>(
+  input: LottieInput,
+  options: FrameOptions & { target: T }
+): Timed<T>;
+export function exportFrameSync(
+  input: LottieInput,
+  options?: FrameOptions
+): Timed<Buffer>;
+export function exportFrameSync(
+  input: LottieInput,
+  options?: FrameOptions
+): Buffer | FrameTarget {
+  validateInput(input, options);
+  const result = native.exportFrameSync(input, toNativeOptions(options));
+  return frameResult(options, result);
+}
+
+/**
+ * Asynchronously exports several frames of a Lottie animation to PNG. The
+ * animation is parsed once and the frames are rendered and encoded in
+ * parallel, each thread with its own renderer. Unless `dedupe` is false, a
+ * frame that renders identically to the frame before it is not encoded again.
+ * @param {LottieInput} input - The Lottie animation data: JSON, a gzip-compressed .tgs sticker or a .lottie archive, in a Buffer or in a file.
+ * @param {BatchOptions} [options] - Configuration options for the export.
+ * @returns {Promise<BatchResult>} A promise resolving to the PNG data of each requested frame, in order.
+ * @throws {TypeError} If `input` is neither a Buffer nor a `{ path }` object.
+ * @throws {RangeError} If any option value is invalid.
+ * @throws {Error} If the native module fails to process the animation.
+ */
+export async function exportFrames(
+  input: LottieInput,
+  options?: BatchOptions
+): Promise<BatchResult> {
+  validateLottieInput(input);
+  validateOptions(options);
+  validateBatchOptions(options);
+  return runAbortable(options?.signal, (cancelToken) =>
+    native.exportFrames(input, withCancelToken(options, cancelToken))
+  );
+}
+
+/**
+ * Asynchronously exports a Lottie animation as an animated PNG. Each frame
+ * after the first only encodes the rectangle that changed since the previous
+ * one, and frames that did not change at all extend the previous frame's
+ * delay instead of being stored again.
+ * @param {LottieInput} input - The Lottie animation data: JSON, a gzip-compressed .tgs sticker or a .lottie archive, in a Buffer or in a file.
+ * @param {AnimationOptions} [options] - Configuration options for the export.
+ * @returns {Promise<Buffer>} A promise resolving to the APNG data as a Buffer.
+ * @throws {TypeError} If `input` is neither a Buffer nor a `{ path }` object.
+ * @throws {RangeError} If any option value is invalid.
+ * @throws {Error} If the native module fails to process the animation.
+ */
+export async function exportAnimation(
+  input: LottieInput,
+  options?: AnimationOptions
 ): Promise<Buffer> {
-  validateInput(buffer, options);
-  return native.exportFrame(buffer, options);
+  validateLottieInput(input);
+
+  if (options) {
+    const { format, frameRange, fpsOverride, loop, ...frameOptions } = options;
+    validateOptions(frameOptions);
+    rejectViewportOptions(frameOptions);
+    if (format !== undefined && format !== "apng") {
+      throw new RangeError('Option "format" must be "apng"');
+    }
+    validateFrameSelection(frameRange, "frameRange");
+    if (fpsOverride !== undefined) {
+      if (
+        typeof fpsOverride !== "number" ||
+        !(fpsOverride > 0) ||
+        fpsOverride > 1000
+      ) {
+        throw new RangeError(
+          'Option "fpsOverride" must be a number greater than 0 and at most 1000'
+        );
+      }
+    }
+    if (loop !== undefined) {
+      if (!Number.isInteger(loop) || loop < 0 || loop > 0xffffffff) {
+        throw new RangeError('Option "loop" must be a non-negative integer');
+      }
+    }
+  }
+
+  return runAbortable(options?.signal, (cancelToken) =>
+    native.exportAnimation(input, withCancelToken(options, cancelToken))
+  );
 }
 
 /**
- * Synchronously exports a frame from a Lottie animation to PNG.
- * @param {Buffer} buffer - The Lottie JSON animation data.
- * @param {Options} [options] - Configuration options for the export.
- * @returns {Buffer} The PNG data as a Buffer.
- * @throws {TypeError} If `buffer` is not a Buffer.
+ * Asynchronously exports frames of a Lottie animation laid out in one grid
+ * image. Every frame renders in parallel straight into its cell of the sheet,
+ * which is then encoded once. The 4096 pixel size limit applies to the sheet,
+ * not to each cell.
+ * @param {LottieInput} input - The Lottie animation data: JSON, a gzip-compressed .tgs sticker or a .lottie archive, in a Buffer or in a file.
+ * @param {SpriteSheetOptions} [options] - Configuration options for the export.
+ * @returns {Promise<SpriteSheet>} A promise resolving to the sheet and its frame map.
+ * @throws {TypeError} If `input` is neither a Buffer nor a `{ path }` object.
+ * @throws {RangeError} If any option value is invalid.
+ * @throws {Error} If the native module fails to process the animation, or the sheet would exceed 4096x4096 pixels.
+ */
+export async function exportSpriteSheet(
+  input: LottieInput,
+  options?: SpriteSheetOptions
+): Promise<SpriteSheet> {
+  validateLottieInput(input);
+
+  if (options) {
+    const { columns, frameStep, cellWidth, cellHeight, padding, ...batchOptions } =
+      options;
+    validateOptions(batchOptions);
+    validateBatchOptions(batchOptions);
+    validateInteger(columns, "columns", 1, 4096);
+    validateInteger(frameStep, "frameStep", 1, 0xffffffff);
+    validateInteger(cellWidth, "cellWidth", 1, 4096);
+    validateInteger(cellHeight, "cellHeight", 1, 4096);
+    validateInteger(padding, "padding", 0, 4096);
+    if (
+      frameStep !== undefined &&
+      (batchOptions.frames !== undefined ||
+        batchOptions.times !== undefined ||
+        batchOptions.fps !== undefined)
+    ) {
+      throw new RangeError(
+        'Option "frameStep" cannot be combined with "frames", "times" or "fps"'
+      );
+    }
+  }
+
+  return runAbortable(options?.signal, (cancelToken) =>
+    native.exportSpriteSheet(input, withCancelToken(options, cancelToken))
+  );
+}
+
+/**
+ * Streams frames of a Lottie animation as PNG. The worker pool renders and
+ * encodes at most `window` frames ahead of the consumer and pauses while the
+ * consumer falls behind, so memory stays bounded regardless of animation
+ * length. Breaking out of the iteration stops the native producer.
+ * @param {LottieInput} input - The Lottie animation data: JSON, a gzip-compressed .tgs sticker or a .lottie archive, in a Buffer or in a file.
+ * @param {StreamOptions} [options] - Configuration options for the export.
+ * @returns {AsyncIterableIterator<StreamedFrame>} The requested frames, in order.
+ * @throws {TypeError} If `input` is neither a Buffer nor a `{ path }` object.
  * @throws {RangeError} If any option value is invalid.
  * @throws {Error} If the native module fails to process the animation.
  */
-export function exportFrameSync(buffer: Buffer, options?: Options): Buffer {
-  validateInput(buffer, options);
-  return native.exportFrameSync(buffer, options);
+export function streamFrames(
+  input: LottieInput,
+  options?: StreamOptions
+): AsyncIterableIterator<StreamedFrame> {
+  validateLottieInput(input);
+  validateOptions(options);
+  validateBatchOptions(options);
+
+  if (options && typeof options.window === "number") {
+    if (
+      !Number.isInteger(options.window) ||
+      options.window < 1 ||
+      options.window > 64
+    ) {
+      throw new RangeError('Option "window" must be an integer between 1 and 64');
+    }
+  }
+
+  const queue: StreamedFrame[] = [];
+  let finished = false;
+  let failure: Error | undefined;
+  let wake: (() => void) | undefined;
+
+  const handle = native.createFrameStream(
+    input,
+    options ?? {},
+    (error, frame, data, duplicate) => {
+      if (error !== null) {
+        failure = new Error(error);
+      } else if (frame === null || data === null) {
+        finished = true;
+      } else {
+        queue.push({ frame, data, duplicate });
+      }
+      if (wake) {
+        const resolve = wake;
+        wake = undefined;
+        resolve();
+      }
+    }
+  );
+
+  async function* iterate(): AsyncIterableIterator<StreamedFrame> {
+    try {
+      while (true) {
+        const item = queue.shift();
+        if (item) {
+          native.ackFrameStream(handle);
+          yield item;
+        } else if (failure) {
+          throw failure;
+        } else if (finished) {
+          return;
+        } else {
+          await new Promise<void>((resolve) => {
+            wake = resolve;
+          });
+        }
+      }
+    } finally {
+      native.cancelFrameStream(handle);
+    }
+  }
+
+  return iterate();
+}
+
+/**
+ * A parsed Lottie animation that can render any number of frames without
+ * re-parsing the JSON.
+ *
+ * Thread safety: renders on one handle are serialized natively, because an
+ * rlottie animation cannot rasterize two frames at once. Only rasterization
+ * holds the lock; PNG encoding of concurrent `renderFrame` calls still runs in
+ * parallel on the worker pool. To rasterize in parallel, open several handles
+ * from one `share()` ID or load several from the same data.
+ */
+export class LottieAnimation {
+  /**
+   * Wraps a native animation handle. Use `loadAnimation` or
+   * `loadAnimationSync` instead of calling this directly.
+   * @param {NativeAnimation} handle - The native animation handle.
+   */
+  constructor(private readonly handle: NativeAnimation) {}
+
+  /** The number of frames in the animation. */
+  get totalFrames(): number {
+    return this.handle.totalFrames;
+  }
+
+  /** The frame rate of the animation in frames per second. */
+  get frameRate(): number {
+    return this.handle.frameRate;
+  }
+
+  /** The duration of the animation in seconds. */
+  get duration(): number {
+    return this.handle.duration;
+  }
+
+  /** The intrinsic size of the animation. */
+  get size(): AnimationSize {
+    return this.handle.size;
+  }
+
+  /**
+   * Asynchronously renders a frame of the animation to PNG or raw pixels.
+   * @param {FrameOptions} [options] - Configuration options for the render.
+   * @returns {Promise<Buffer | FrameTarget>} A promise resolving to the frame as a Buffer, or to `options.target` once the frame has been rendered into it.
+   * @throws {RangeError} If any option value is invalid.
+   * @throws {Error} If the native module fails to render the frame.
+   */
+  renderFrame<T extends FrameTarget>(
+    options: FrameOptions & { target: T }
+  ): Promise<Timed<T>>;
+  renderFrame(options?: FrameOptions): Promise<Timed<Buffer>>;
+  async renderFrame(options?: FrameOptions): Promise<Buffer | FrameTarget> {
+    validateOptions(options);
+    if (options) rejectViewportOptions(options);
+    const result = await runAbortable(options?.signal, (cancelToken) =>
+      this.handle.renderFrame(toNativeOptions(options, cancelToken))
+    );
+    return frameResult(options, result);
+  }
+
+  /**
+   * Synchronously renders a frame of the animation to PNG or raw pixels.
+   * @param {FrameOptions} [options] - Configuration options for the render.
+   * @returns {Buffer | FrameTarget} The frame as a Buffer, or `options.target` once the frame has been rendered into it.
+   * @throws {RangeError} If any option value is invalid.
+   * @throws {Error} If the native module fails to render the frame.
+   */
+  renderFrameSync<T extends FrameTarget>(
+    options: FrameOptions & { target: T }
+  ): Timed<T>;
+  renderFrameSync(options?: FrameOptions): Timed<Buffer>;
+  renderFrameSync(options?: FrameOptions): Buffer | FrameTarget {
+    validateOptions(options);
+    if (options) rejectViewportOptions(options);
+    const result = this.handle.renderFrameSync(toNativeOptions(options));
+    return frameResult(options, result);
+  }
+
+  /**
+   * Publishes the parsed animation under a process-wide ID that any worker
+   * thread can pass to `openSharedAnimation`. Calling it again returns the
+   * same ID; each call must be balanced by one `releaseSharedAnimation`.
+   * @returns {number} The shared animation ID.
+   */
+  share(): number {
+    return this.handle.share();
+  }
+}
+
+/**
+ * Asynchronously parses a Lottie animation into a reusable handle.
+ * @param {LottieInput} input - The Lottie animation data: JSON, a gzip-compressed .tgs sticker or a .lottie archive, in a Buffer or in a file.
+ * @param {LoadOptions} [options] - Configuration options for loading.
+ * @returns {Promise<LottieAnimation>} A promise resolving to the parsed animation.
+ * @throws {TypeError} If `input` is neither a Buffer nor a `{ path }` object.
+ * @throws {Error} If the native module fails to parse the animation.
+ */
+export async function loadAnimation(
+  input: LottieInput,
+  options?: LoadOptions
+): Promise<LottieAnimation> {
+  validateLottieInput(input);
+  validateLoadOptions(options);
+  return new LottieAnimation(await native.loadAnimation(input, options));
+}
+
+/**
+ * Synchronously parses a Lottie animation into a reusable handle.
+ * @param {LottieInput} input - The Lottie animation data: JSON, a gzip-compressed .tgs sticker or a .lottie archive, in a Buffer or in a file.
+ * @param {LoadOptions} [options] - Configuration options for loading.
+ * @returns {LottieAnimation} The parsed animation.
+ * @throws {TypeError} If `input` is neither a Buffer nor a `{ path }` object.
+ * @throws {Error} If the native module fails to parse the animation.
+ */
+export function loadAnimationSync(
+  input: LottieInput,
+  options?: LoadOptions
+): LottieAnimation {
+  validateLottieInput(input);
+  validateLoadOptions(options);
+  return new LottieAnimation(native.loadAnimationSync(input, options));
+}
+
+/**
+ * Throws unless `id` can be a shared animation ID.
+ * @param {number} id - The ID to check.
+ * @throws {TypeError} If `id` is not a positive integer.
+ */
+function validateSharedAnimationId(id: number): void {
+  if (!Number.isInteger(id) || id < 1 || id > 0xffffffff) {
+    throw new TypeError("Shared animation ID must be a positive integer");
+  }
+}
+
+/**
+ * Opens an animation published with `LottieAnimation.share()`, possibly on
+ * another worker thread. The returned handle has a renderer of its own over
+ * the shared parsed model, so the JSON is neither copied nor parsed again and
+ * its renders do not wait for those of other handles.
+ * @param {number} id - The ID returned by `share()`.
+ * @returns {LottieAnimation} A handle to the shared animation.
+ * @throws {TypeError} If `id` is not a positive integer.
+ * @throws {Error} If no animation is shared under `id`.
+ */
+export function openSharedAnimation(id: number): LottieAnimation {
+  validateSharedAnimationId(id);
+  return new LottieAnimation(native.openSharedAnimation(id));
+}
+
+/**
+ * Drops one reference taken by `LottieAnimation.share()`. Once every share is
+ * released the ID can no longer be opened; handles already open stay valid.
+ * @param {number} id - The ID returned by `share()`.
+ * @returns {boolean} False if no animation was shared under `id`.
+ * @throws {TypeError} If `id` is not a positive integer.
+ */
+export function releaseSharedAnimation(id: number): boolean {
+  validateSharedAnimationId(id);
+  return native.releaseSharedAnimation(id);
+}
+
+/**
+ * Configures the process-wide cache of parsed animations. The cache is off by
+ * default; when enabled, repeated exports of identical input bytes (and
+ * resource path) skip copying and parsing the JSON. Only the parsed model is
+ * shared; every call gets its own renderer, so renders of the same cached
+ * animation run in parallel.
+ * @param {AnimationCacheOptions} options - The cache budget.
+ * @throws {RangeError} If any option value is invalid.
+ */
+export function configureAnimationCache(options: AnimationCacheOptions): void {
+  if (typeof options.maxEntries === "number") {
+    if (!Number.isInteger(options.maxEntries) || options.maxEntries < 0) {
+      throw new RangeError('Option "maxEntries" must be a non-negative integer');
+    }
+  }
+
+  if (typeof options.maxBytes === "number") {
+    if (!Number.isSafeInteger(options.maxBytes) || options.maxBytes < 0) {
+      throw new RangeError('Option "maxBytes" must be a non-negative integer');
+    }
+  }
+
+  native.configureAnimationCache(options);
+}
+
+/**
+ * Drops every animation from the process-wide cache, and every model from
+ * rlottie's model cache. Renders in progress keep their models.
+ */
+export function clearAnimationCache(): void {
+  native.clearAnimationCache();
+}
+
+/**
+ * Returns the counters of the process-wide animation cache.
+ * @returns {AnimationCacheStats} The current cache counters.
+ */
+export function getAnimationCacheStats(): AnimationCacheStats {
+  return native.getAnimationCacheStats();
+}
+
+/**
+ * Configures the process-wide cache of rendered frames. The cache is off by
+ * default; when enabled, exportFrame and exportFrameSync calls with identical
+ * input bytes and output options return the stored result instead of
+ * rendering, and identical calls running at the same time share one render.
+ * Every hit returns a copy of the cached result. Pass `shareCached: true` to
+ * get a view of the cached memory instead, which saves the copy but is shared
+ * by every such caller, so it must not be written to.
+ * Renders into a target and LottieAnimation renders bypass the cache.
+ * @param {FrameCacheOptions} options - The cache budget.
+ * @throws {RangeError} If any option value is invalid.
+ */
+export function configureFrameCache(options: FrameCacheOptions): void {
+  if (typeof options.maxBytes === "number") {
+    if (!Number.isSafeInteger(options.maxBytes) || options.maxBytes < 0) {
+      throw new RangeError('Option "maxBytes" must be a non-negative integer');
+    }
+  }
+
+  native.configureFrameCache(options);
+}
+
+/**
+ * Drops every frame from the process-wide frame cache. Buffers already
+ * returned stay valid.
+ */
+export function clearFrameCache(): void {
+  native.clearFrameCache();
+}
+
+/**
+ * Returns the counters of the process-wide frame cache.
+ * @returns {FrameCacheStats} The current cache counters.
+ */
+export function getFrameCacheStats(): FrameCacheStats {
+  return native.getFrameCacheStats();
+}
+
+/**
+ * Asynchronously reads the metadata of a Lottie animation and estimates the
+ * cost of rendering it, without allocating a surface or rendering a frame.
+ * @param {LottieInput} input - The Lottie animation data: JSON, a gzip-compressed .tgs sticker or a .lottie archive, in a Buffer or in a file.
+ * @param {ProbeOptions} [options] - Configuration options for the probe.
+ * @returns {Promise<ProbeResult>} A promise resolving to the metadata.
+ * @throws {TypeError} If `input` is neither a Buffer nor a `{ path }` object.
+ * @throws {RangeError} If any size is invalid.
+ * @throws {Error} If the native module fails to parse the animation.
+ */
+export async function probe(
+  input: LottieInput,
+  options?: ProbeOptions
+): Promise<ProbeResult> {
+  validateLottieInput(input);
+  validateProbeOptions(options);
+  return native.probe(input, options);
+}
+
+/**
+ * Synchronously reads the metadata of a Lottie animation and estimates the
+ * cost of rendering it, without allocating a surface or rendering a frame.
+ * @param {LottieInput} input - The Lottie animation data: JSON, a gzip-compressed .tgs sticker or a .lottie archive, in a Buffer or in a file.
+ * @param {ProbeOptions} [options] - Configuration options for the probe.
+ * @returns {ProbeResult} The metadata.
+ * @throws {TypeError} If `input` is neither a Buffer nor a `{ path }` object.
+ * @throws {RangeError} If any size is invalid.
+ * @throws {Error} If the native module fails to parse the animation.
+ */
+export function probeSync(input: LottieInput, options?: ProbeOptions): ProbeResult {
+  validateLottieInput(input);
+  validateProbeOptions(options);
+  return native.probeSync(input, options);
+}
+
+/**
+ * Returns the allocation counters of the native frame buffer pool.
+ * @returns {BufferPoolStats} The current pool counters.
+ */
+export function getBufferPoolStats(): BufferPoolStats {
+  return native.getBufferPoolStats();
+}
+
+/**
+ * Returns cumulative metrics of every single-frame export and render since
+ * the process started: call and byte counters, the number of calls running,
+ * and a latency histogram per stage. Recording is lock-free and always on.
+ * @returns {Stats} The current metrics.
+ */
+export function getStats(): Stats {
+  return native.getStats();
+}
+
+/**
+ * Sets the number of threads in the addon's worker pool, which runs every
+ * asynchronous render instead of the libuv threadpool. Multi-threaded exports
+ * fan out onto the same threads, so this caps the addon's render threads.
+ * Shrinking lets running jobs finish first.
+ * @param {number} concurrency - Number of worker threads (integer between 1 and 64, default: number of CPUs).
+ * @throws {RangeError} If `concurrency` is invalid.
+ */
+export function setConcurrency(concurrency: number): void {
+  if (!Number.isInteger(concurrency) || concurrency < 1 || concurrency > 64) {
+    throw new RangeError("Concurrency must be an integer between 1 and 64");
+  }
+  native.setConcurrency(concurrency);
+}
+
+/**
+ * Returns the state of the addon's worker pool: queue depth, throughput and
+ * queue wait times per priority class.
+ * @returns {QueueStats} The current pool state.
+ */
+export function getQueueStats(): QueueStats {
+  return native.getQueueStats();
 }
 
 /**
  * Validates the input parameters for exporting a Lottie frame.
- * @param {Buffer} buffer - The Lottie JSON animation data.
+ * @param {LottieInput} input - The Lottie animation data: JSON, a gzip-compressed .tgs sticker or a .lottie archive, in a Buffer or in a file.
  * @param {Options} [options] - Configuration options for the export.
- * @throws {TypeError} If `buffer` is not a Buffer.
+ * @throws {TypeError} If `input` is neither a Buffer nor a `{ path }` object.
  * @throws {RangeError} If any option value is invalid.
  */
-function validateInput(buffer: Buffer, options?: Options): void {
-  if (!Buffer.isBuffer(buffer)) {
-    throw new TypeError("Input must be a Buffer containing Lottie JSON data");
+function validateInput(input: LottieInput, options?: FrameOptions): void {
+  validateLottieInput(input);
+  validateOptions(options);
+}
+
+/**
+ * Validates the options specific to batch export.
+ * @param {BatchOptions} [options] - Configuration options for the export.
+ * @throws {RangeError} If any option value is invalid.
+ * @throws {TypeError} If `dedupe` is not a boolean.
+ */
+function validateBatchOptions(options?: BatchOptions): void {
+  if (!options) {
+    return;
+  }
+
+  validateFrameSelection(options.frames, "frames");
+
+  const single = options as BatchOptions & FrameOptions;
+  if (single.time !== undefined || single.progress !== undefined) {
+    throw new RangeError(
+      'Options "time" and "progress" select a single frame; use "times" or "fps" to resample a batch'
+    );
+  }
+  if (options.times !== undefined) {
+    if (
+      !Array.isArray(options.times) ||
+      !options.times.every(
+        (time) => typeof time === "number" && Number.isFinite(time) && time >= 0
+      )
+    ) {
+      throw new RangeError(
+        'Option "times" must be an array of non-negative numbers of milliseconds'
+      );
+    }
+  }
+  if (options.fps !== undefined) {
+    if (typeof options.fps !== "number" || !(options.fps > 0) || options.fps > 1000) {
+      throw new RangeError('Option "fps" must be a number greater than 0 and at most 1000');
+    }
+  }
+  const selections = [options.frames, options.times, options.fps];
+  if (selections.filter((value) => value !== undefined).length > 1) {
+    throw new RangeError('Only one of "frames", "times" and "fps" can be given');
+  }
+
+  if (typeof options.concurrency === "number") {
+    if (
+      !Number.isInteger(options.concurrency) ||
+      options.concurrency < 1 ||
+      options.concurrency > 64
+    ) {
+      throw new RangeError(
+        'Option "concurrency" must be an integer between 1 and 64'
+      );
+    }
+  }
+
+  if (options.dedupe !== undefined && typeof options.dedupe !== "boolean") {
+    throw new TypeError('Option "dedupe" must be a boolean');
   }
 
+  rejectViewportOptions(options);
+}
+
+/**
+ * Rejects the options that only single-frame exports support: a viewport,
+ * a scale, tiling and sizes above 4096.
+ * @param {FrameOptions} options - Configuration options for the export.
+ * @throws {RangeError} If any of them is set.
+ */
+function rejectViewportOptions(options: FrameOptions): void {
+  if (
+    options.viewport !== undefined ||
+    options.scale !== undefined ||
+    options.tileSize !== undefined ||
+    (options.width ?? 0) > 4096 ||
+    (options.height ?? 0) > 4096
+  ) {
+    throw new RangeError(
+      'Options "viewport", "scale", "tileSize" and sizes above 4096 are only supported by exportFrame and exportFrameSync'
+    );
+  }
+}
+
+/**
+ * Validates the viewport options and returns the size of the output.
+ * @param {FrameOptions} options - Configuration options for the export.
+ * @returns {[number, number]} The output width and height.
+ * @throws {TypeError} If `viewport` is not an object.
+ * @throws {RangeError} If any option value is invalid.
+ */
+function validateViewport(options: FrameOptions): [number, number] {
+  const width = options.width ?? 100;
+  const height = options.height ?? 100;
+  const viewport = options.viewport ?? { x: 0, y: 0, width, height };
+  const scale = options.scale ?? 1;
+
+  if (options.viewport !== undefined) {
+    if (typeof viewport !== "object" || viewport === null) {
+      throw new TypeError('Option "viewport" must be an object');
+    }
+    for (const key of ["x", "y"] as const) {
+      if (typeof viewport[key] !== "number" || !(viewport[key] >= 0)) {
+        throw new RangeError(`Option "viewport.${key}" must be a non-negative number`);
+      }
+    }
+    for (const key of ["width", "height"] as const) {
+      if (typeof viewport[key] !== "number" || !(viewport[key] > 0)) {
+        throw new RangeError(`Option "viewport.${key}" must be a positive number`);
+      }
+    }
+    if (viewport.x + viewport.width > width || viewport.y + viewport.height > height) {
+      throw new RangeError('Option "viewport" must lie within the width x height canvas');
+    }
+  }
+
+  if (options.scale !== undefined) {
+    if (typeof scale !== "number" || !(scale > 0) || scale > 16) {
+      throw new RangeError('Option "scale" must be a number greater than 0 and at most 16');
+    }
+  }
+  validateInteger(options.tileSize, "tileSize", 64, 4096);
+
+  const outputWidth = Math.round(viewport.width * scale);
+  const outputHeight = Math.round(viewport.height * scale);
+  if (outputWidth < 1 || outputHeight < 1 || outputWidth > 16384 || outputHeight > 16384) {
+    throw new RangeError("The viewport times scale must be between 1 and 16384 pixels on each side");
+  }
+  return [outputWidth, outputHeight];
+}
+
+/**
+ * Validates an optional integer option.
+ * @param {unknown} value - The option value.
+ * @param {string} name - The name of the option, for error messages.
+ * @param {number} min - The smallest allowed value.
+ * @param {number} max - The largest allowed value.
+ * @throws {RangeError} If the value is not an integer between `min` and `max`.
+ */
+function validateInteger(
+  value: unknown,
+  name: string,
+  min: number,
+  max: number
+): void {
+  if (value === undefined) {
+    return;
+  }
+  if (!Number.isInteger(value) || (value as number) < min || (value as number) > max) {
+    throw new RangeError(
+      `Option "${name}" must be an integer between ${min} and ${max}`
+    );
+  }
+}
+
+/**
+ * Validates a list or range of frames.
+ * @param {number[] | FrameRange} [frames] - The frames to validate.
+ * @param {string} name - The name of the option, for error messages.
+ * @throws {RangeError} If any frame or range value is invalid.
+ */
+function validateFrameSelection(
+  frames: number[] | FrameRange | undefined,
+  name: string
+): void {
+  if (Array.isArray(frames)) {
+    for (const frame of frames) {
+      if (!Number.isInteger(frame) || frame < 0) {
+        throw new RangeError(`Option "${name}" must contain non-negative integers`);
+      }
+    }
+  } else if (frames !== undefined) {
+    for (const key of ["start", "end"] as const) {
+      const value = frames[key];
+      if (value !== undefined && (!Number.isInteger(value) || value < 0)) {
+        throw new RangeError(`Option "${name}.${key}" must be a non-negative integer`);
+      }
+    }
+    if (frames.start !== undefined && frames.end !== undefined && frames.start > frames.end) {
+      throw new RangeError(`Option "${name}.start" must not be after "${name}.end"`);
+    }
+    if (
+      frames.step !== undefined &&
+      (!Number.isInteger(frames.step) || frames.step < 1)
+    ) {
+      throw new RangeError(`Option "${name}.step" must be a positive integer`);
+    }
+  }
+}
+
+/**
+ * Validates the options that control how the animation is loaded.
+ * @param {LoadOptions} [options] - Options that may carry a resource path or animation ID.
+ * @throws {TypeError} If `resourcePath` or `animationId` is not a string.
+ */
+function validateLoadOptions(options?: LoadOptions): void {
+  if (options && options.resourcePath !== undefined) {
+    if (typeof options.resourcePath !== "string") {
+      throw new TypeError('Option "resourcePath" must be a string');
+    }
+  }
+  if (options && options.animationId !== undefined) {
+    if (typeof options.animationId !== "string") {
+      throw new TypeError('Option "animationId" must be a string');
+    }
+  }
+}
+
+/**
+ * Validates the options of a probe.
+ * @param {ProbeOptions} [options] - The probe options.
+ * @throws {TypeError} If `sizes` is not an array or a load option has the wrong type.
+ * @throws {RangeError} If any size is out of range.
+ */
+function validateProbeOptions(options?: ProbeOptions): void {
+  validateLoadOptions(options);
+  if (options?.sizes === undefined) return;
+  if (!Array.isArray(options.sizes)) {
+    throw new TypeError('Option "sizes" must be an array of { width, height } objects');
+  }
+  for (const size of options.sizes) {
+    if (
+      typeof size !== "object" ||
+      size === null ||
+      !Number.isInteger(size.width) ||
+      !Number.isInteger(size.height) ||
+      size.width < 1 ||
+      size.width > 16384 ||
+      size.height < 1 ||
+      size.height > 16384
+    ) {
+      throw new RangeError('Option "sizes" must hold integer widths and heights between 1 and 16384');
+    }
+  }
+}
+
+/**
+ * Validates the Lottie input.
+ * @param {LottieInput} input - The Lottie animation data: JSON, a gzip-compressed .tgs sticker or a .lottie archive, in a Buffer or in a file.
+ * @throws {TypeError} If `input` is neither a Buffer nor a `{ path }` object.
+ */
+function validateLottieInput(input: LottieInput): void {
+  if (Buffer.isBuffer(input)) {
+    return;
+  }
+  if (
+    typeof input !== "object" ||
+    input === null ||
+    typeof input.path !== "string" ||
+    input.path.length === 0
+  ) {
+    throw new TypeError(
+      "Input must be a Buffer containing Lottie JSON data or a { path } object"
+    );
+  }
+}
+
+/**
+ * Passes a SharedArrayBuffer target to the native module as a byte view,
+ * which N-API can address.
+ * @param {FrameOptions} [options] - Configuration options for the export.
+ * @returns {FrameOptions | undefined} The options to hand to the native module.
+ */
+function toNativeOptions(
+  options?: FrameOptions,
+  cancelToken?: object
+): NativeOptions<FrameOptions> | undefined {
+  if (
+    typeof SharedArrayBuffer !== "undefined" &&
+    options?.target instanceof SharedArrayBuffer
+  ) {
+    return withCancelToken(
+      { ...options, target: new Uint8Array(options.target) },
+      cancelToken
+    );
+  }
+  return withCancelToken(options, cancelToken);
+}
+
+/**
+ * Picks what a single-frame call resolves to: `options.target` when there is
+ * one, otherwise the native result. A SharedArrayBuffer target reaches the
+ * native module wrapped in a view, so its timings are moved over.
+ * @param {FrameOptions} [options] - The caller's options.
+ * @param {Timed<Buffer | FrameTarget>} result - The native result.
+ * @returns {Timed<Buffer | FrameTarget>} The value to hand back to the caller.
+ */
+function frameResult(
+  options: FrameOptions | undefined,
+  result: Timed<Buffer | FrameTarget>
+): Timed<Buffer | FrameTarget> {
+  const target: Timed<FrameTarget> | undefined = options?.target;
+  if (!target) {
+    return result;
+  }
+  if (target !== result && result.timings) {
+    target.timings = result.timings;
+  }
+  return target;
+}
+
+/**
+ * Adds a native cancel token to the options, if there is one.
+ * @param {T} [options] - The caller's options.
+ * @param {object} [cancelToken] - The token from `runAbortable`.
+ * @returns {NativeOptions<T> | undefined} The options to pass to the native module.
+ */
+function withCancelToken<T extends object>(
+  options: T | undefined,
+  cancelToken: object | undefined
+): NativeOptions<T> | undefined {
+  return cancelToken ? { ...(options as T), cancelToken } : options;
+}
+
+/**
+ * Runs a native call that `signal` can abort. Aborting cancels the native job
+ * through a cancel token, and the call then rejects with the signal's reason.
+ * @param {AbortSignal} [signal] - The caller's abort signal.
+ * @param {(cancelToken?: object) => Promise<T>} run - Starts the native call.
+ * @returns {Promise<T>} The result of the native call.
+ */
+async function runAbortable<T>(
+  signal: AbortSignal | undefined,
+  run: (cancelToken?: object) => Promise<T>
+): Promise<T> {
+  if (!signal) {
+    return run();
+  }
+  signal.throwIfAborted();
+
+  const cancelToken = native.createCancelToken();
+  const onAbort = () => native.cancelToken(cancelToken);
+  signal.addEventListener("abort", onAbort, { once: true });
+  try {
+    return await run(cancelToken);
+  } catch (error) {
+    if (signal.aborted) {
+      throw signal.reason;
+    }
+    throw error;
+  } finally {
+    signal.removeEventListener("abort", onAbort);
+  }
+}
+
+/**
+ * Validates the frame export options.
+ * @param {FrameOptions} [options] - Configuration options for the export.
+ * @throws {TypeError} If `target` is not an ArrayBuffer, SharedArrayBuffer or view.
+ * @throws {RangeError} If any option value is invalid.
+ */
+function validateOptions(options?: FrameOptions): void {
+  validateLoadOptions(options);
+
   if (options) {
-    if (typeof options.frame === "number") {
-      if (!Number.isInteger(options.frame) || options.frame < 0) {
-        throw new RangeError('Option "frame" must be a non-negative integer');
+    if (
+      options.format !== undefined &&
+      !["png", "png-fast", "qoi", "rgba", "bgra", "argb-premul"].includes(options.format)
+    ) {
+      throw new RangeError(
+        'Option "format" must be one of "png", "png-fast", "qoi", "rgba", "bgra" or "argb-premul"'
+      );
+    }
+
+    if (typeof options.compressionLevel === "number") {
+      if (
+        !Number.isInteger(options.compressionLevel) ||
+        options.compressionLevel < 0 ||
+        options.compressionLevel > 9
+      ) {
+        throw new RangeError(
+          'Option "compressionLevel" must be an integer between 0 and 9'
+        );
+      }
+    }
+
+    if (
+      options.filter !== undefined &&
+      !["none", "sub", "up", "average", "paeth", "adaptive"].includes(options.filter)
+    ) {
+      throw new RangeError(
+        'Option "filter" must be one of "none", "sub", "up", "average", "paeth" or "adaptive"'
+      );
+    }
+
+    if (
+      options.strategy !== undefined &&
+      !["default", "filtered", "huffman", "rle"].includes(options.strategy)
+    ) {
+      throw new RangeError(
+        'Option "strategy" must be one of "default", "filtered", "huffman" or "rle"'
+      );
+    }
+
+    if (
+      options.priority !== undefined &&
+      !["high", "normal", "low"].includes(options.priority)
+    ) {
+      throw new RangeError('Option "priority" must be one of "high", "normal" or "low"');
+    }
+
+    if (options.signal !== undefined && !(options.signal instanceof AbortSignal)) {
+      throw new TypeError('Option "signal" must be an AbortSignal');
+    }
+
+    if (typeof options.compressionThreads === "number") {
+      if (
+        !Number.isInteger(options.compressionThreads) ||
+        options.compressionThreads < 1 ||
+        options.compressionThreads > 64
+      ) {
+        throw new RangeError(
+          'Option "compressionThreads" must be an integer between 1 and 64'
+        );
       }
     }
 
+    if (options.timings !== undefined && typeof options.timings !== "boolean") {
+      throw new TypeError('Option "timings" must be a boolean');
+    }
+
+    if (options.shareCached !== undefined && typeof options.shareCached !== "boolean") {
+      throw new TypeError('Option "shareCached" must be a boolean');
+    }
+
     if (typeof options.width === "number") {
       if (
         !Number.isInteger(options.width) ||
         options.width < 1 ||
-        options.width > 4096
+        options.width > 16384
       ) {
         throw new RangeError(
-          'Option "width" must be an integer between 1 and 4096'
+          'Option "width" must be an integer between 1 and 16384'
         );
       }
     }
@@ -123,12 +1708,67 @@ function validateInput(buffer: Buffer, options?: Options): void {
       if (
         !Number.isInteger(options.height) ||
         options.height < 1 ||
-        options.height > 4096
+        options.height > 16384
       ) {
         throw new RangeError(
-          'Option "height" must be an integer between 1 and 4096'
+          'Option "height" must be an integer between 1 and 16384'
+        );
+      }
+    }
+
+    const [outputWidth, outputHeight] = validateViewport(options);
+
+    if (options.target !== undefined) {
+      const target = options.target;
+      const isMemory =
+        ArrayBuffer.isView(target) ||
+        target instanceof ArrayBuffer ||
+        (typeof SharedArrayBuffer !== "undefined" &&
+          target instanceof SharedArrayBuffer);
+      if (!isMemory) {
+        throw new TypeError(
+          'Option "target" must be an ArrayBuffer, SharedArrayBuffer or ArrayBuffer view'
         );
       }
+      if (!["rgba", "bgra", "argb-premul"].includes(options.format ?? "png")) {
+        throw new RangeError('Option "target" requires a raw pixel "format"');
+      }
+      const required = outputWidth * outputHeight * 4;
+      if (target.byteLength < required) {
+        throw new RangeError(
+          `Option "target" must hold at least ${required} bytes`
+        );
+      }
+    }
+
+    if (typeof options.frame === "number") {
+      if (!Number.isInteger(options.frame) || options.frame < 0) {
+        throw new RangeError('Option "frame" must be a non-negative integer');
+      }
+    }
+
+    if (options.time !== undefined) {
+      if (
+        typeof options.time !== "number" ||
+        !Number.isFinite(options.time) ||
+        options.time < 0
+      ) {
+        throw new RangeError('Option "time" must be a non-negative number of milliseconds');
+      }
+    }
+
+    if (options.progress !== undefined) {
+      if (
+        typeof options.progress !== "number" ||
+        !(options.progress >= 0 && options.progress <= 1)
+      ) {
+        throw new RangeError('Option "progress" must be a number between 0 and 1');
+      }
+    }
+
+    const addresses = [options.frame, options.time, options.progress];
+    if (addresses.filter((value) => value !== undefined).length > 1) {
+      throw new RangeError('Only one of "frame", "time" and "progress" can be given');
     }
 
     if (typeof options.quality === "number") {
@@ -1,4 +1,5 @@
 #include "utils.h"
+#include <cstdlib>
 
 bool has_own_property(napi_env env, napi_value obj, const char* key) {
     napi_value key_value;
@@ -9,4 +10,70 @@ bool has_own_property(napi_env env, napi_value obj, const char* key) {
     status = napi_has_own_property(env, obj, key_value, &has_prop);
     if (status != napi_ok) return false;
     return has_prop;
+}
+
+bool get_string_value(napi_env env, napi_value value, std::string& result) {
+    size_t length;
+    napi_status status = napi_get_value_string_utf8(env, value, nullptr, 0, &length);
+    if (status != napi_ok) return false;
+
+    result.resize(length);
+    status = napi_get_value_string_utf8(env, value, &result[0], length + 1, &length);
+    return status == napi_ok;
+}
+
+bool set_number_property(napi_env env, napi_value object, const char* key, double value) {
+    napi_value number;
+    if (napi_create_double(env, value, &number) != napi_ok) return false;
+    return napi_set_named_property(env, object, key, number) == napi_ok;
+}
+
+static void free_owned_buffer(napi_env env, void* data, void* hint) {
+    free(data);
+}
+
+napi_status create_owned_buffer(napi_env env, void* data, size_t size, napi_value* result) {
+    napi_status status = napi_create_external_buffer(env, size, data, free_owned_buffer, nullptr, result);
+    if (status == napi_ok) return status;
+
+    status = napi_create_buffer_copy(env, size, data, nullptr, result);
+    free(data);
+    return status;
+}
+
+bool get_byte_view(napi_env env, napi_value value, void** data, size_t* size) {
+    bool is_type = false;
+    if (napi_is_typedarray(env, value, &is_type) == napi_ok && is_type) {
+        napi_typedarray_type type;
+        size_t length;
+        if (napi_get_typedarray_info(env, value, &type, &length, data, nullptr, nullptr) != napi_ok) return false;
+        size_t element_size = 1;
+        switch (type) {
+            case napi_int16_array:
+            case napi_uint16_array:
+                element_size = 2;
+                break;
+            case napi_int32_array:
+            case napi_uint32_array:
+            case napi_float32_array:
+                element_size = 4;
+                break;
+            case napi_float64_array:
+            case napi_bigint64_array:
+            case napi_biguint64_array:
+                element_size = 8;
+                break;
+            default:
+                break;
+        }
+        *size = length * element_size;
+        return true;
+    }
+    if (napi_is_dataview(env, value, &is_type) == napi_ok && is_type) {
+        return napi_get_dataview_info(env, value, size, data, nullptr, nullptr) == napi_ok;
+    }
+    if (napi_is_arraybuffer(env, value, &is_type) == napi_ok && is_type) {
+        return napi_get_arraybuffer_info(env, value, data, size) == napi_ok;
+    }
+    return false;
 }
\ No newline at end of file
@@ -2,11 +2,20 @@
 #define UTILS_H
 
 #include <napi.h>
+#include <string>
 
 #define THROW_ERROR(env, msg) napi_throw_error(env, nullptr, msg); return nullptr
 #define THROW_ERROR_NO_RETURN(env, msg) napi_throw_error(env, nullptr, msg); return
 #define CHECK_STATUS(env, status, msg) if (status != napi_ok) { THROW_ERROR(env, msg); }
 
 bool has_own_property(napi_env env, napi_value obj, const char* key);
+bool get_string_value(napi_env env, napi_value value, std::string& result);
+bool set_number_property(napi_env env, napi_value object, const char* key, double value);
+// Hands malloc'd memory to JS as a Buffer without copying; the Buffer frees it.
+// Where external buffers are not allowed it falls back to a copy. The memory is
+// owned by the callee in every case, including failure.
+napi_status create_owned_buffer(napi_env env, void* data, size_t size, napi_value* result);
+// Resolves the memory behind a Buffer, TypedArray, DataView or ArrayBuffer.
+bool get_byte_view(napi_env env, napi_value value, void** data, size_t* size);
 
 #endif // UTILS_H
\ No newline at end of file
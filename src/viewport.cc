@@ -0,0 +1,202 @@
+#include "viewport.h"
+#include "animation.h"
+#include "animation_input.h"
+#include "converter.h"
+#include "json_scan.h"
+#include "parallel.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+
+#define lp_COLOR_BYTES 4
+#define li_MAX_TILE_DIMENSION 4096
+#define li_DEFAULT_TILE_DIMENSION 2048
+#define ls_VIEWPORT_ASSET_ID "__lottie_frame_viewport"
+
+// The parts of the source document a wrapper composition is built from.
+struct ViewportSource {
+    std::string json;
+    // Root members other than the ones the wrapper replaces, each followed by a comma.
+    std::string members;
+    size_t layers_begin;
+    size_t layers_end;
+    // Contents of the root assets array without the brackets; empty if none.
+    std::string assets;
+    double width;
+    double height;
+    std::string in_point;
+    std::string out_point;
+};
+
+static void append_json_string(std::string& out, const std::string& value) {
+    out.push_back('"');
+    for (char c : value) {
+        if (c == '"' || c == '\\') out.push_back('\\');
+        out.push_back(c);
+    }
+    out.push_back('"');
+}
+
+static bool read_json_number(const std::string& json, size_t begin, double* value) {
+    const char* start = json.c_str() + begin;
+    char* end;
+    *value = strtod(start, &end);
+    return end != start;
+}
+
+static bool scan_viewport_source(ViewportSource& source) {
+    const std::string& json = source.json;
+    bool has_width = false, has_height = false;
+    source.layers_end = 0;
+
+    bool ok = json_for_each_member(json, json_skip_whitespace(json, 0), [&](const std::string& key, size_t begin, size_t end) {
+        if (key == "w") {
+            has_width = read_json_number(json, begin, &source.width);
+        } else if (key == "h") {
+            has_height = read_json_number(json, begin, &source.height);
+        } else if (key == "layers") {
+            source.layers_begin = begin;
+            source.layers_end = end;
+        } else if (key == "assets") {
+            if (json[begin] != '[') return false;
+            if (json[json_skip_whitespace(json, begin + 1)] != ']') {
+                source.assets.assign(json, begin + 1, end - begin - 2);
+            }
+        } else {
+            if (key == "ip") source.in_point.assign(json, begin, end - begin);
+            if (key == "op") source.out_point.assign(json, begin, end - begin);
+            append_json_string(source.members, key);
+            source.members.push_back(':');
+            source.members.append(json, begin, end - begin);
+            source.members.push_back(',');
+        }
+        return true;
+    });
+
+    return ok && has_width && has_height && source.width > 0 && source.height > 0 && source.layers_end &&
+           !source.in_point.empty() && !source.out_point.empty();
+}
+
+// A composition of tile_width x tile_height holding the source as one
+// precomposition layer, scaled and moved so that the tile's output pixels
+// show exactly what a full render of the canvas would have there.
+static std::string build_viewport_json(const ViewportSource& source, double scale, double x, double y,
+                                       int tile_width, int tile_height) {
+    std::string json;
+    json.reserve(source.json.size() + 512);
+    json.push_back('{');
+    json.append(source.members);
+
+    char buffer[512];
+    snprintf(buffer, sizeof(buffer), "\"w\":%d,\"h\":%d,\"assets\":[", tile_width, tile_height);
+    json.append(buffer);
+    if (!source.assets.empty()) {
+        json.append(source.assets);
+        json.push_back(',');
+    }
+    json.append("{\"id\":\"" ls_VIEWPORT_ASSET_ID "\",\"layers\":");
+    json.append(source.json, source.layers_begin, source.layers_end - source.layers_begin);
+
+    snprintf(buffer, sizeof(buffer),
+             "}],\"layers\":[{\"ddd\":0,\"ind\":1,\"ty\":0,\"nm\":\"viewport\",\"refId\":\"" ls_VIEWPORT_ASSET_ID "\","
+             "\"sr\":1,\"ks\":{\"o\":{\"a\":0,\"k\":100},\"r\":{\"a\":0,\"k\":0},\"p\":{\"a\":0,\"k\":[%.9g,%.9g,0]},"
+             "\"a\":{\"a\":0,\"k\":[0,0,0]},\"s\":{\"a\":0,\"k\":[%.9g,%.9g,100]}},\"ao\":0,\"w\":%.9g,\"h\":%.9g,\"ip\":",
+             x, y, scale * 100, scale * 100, source.width, source.height);
+    json.append(buffer);
+    json.append(source.in_point);
+    json.append(",\"op\":");
+    json.append(source.out_point);
+    json.append(",\"st\":0,\"bm\":0}]}");
+    return json;
+}
+
+bool render_viewport_frame(ConverterData* data, uint32_t* pixels, size_t stride) {
+    const RenderViewport& viewport = data->viewport;
+    uint64_t start = metrics_now_ns();
+
+    ViewportSource source;
+    if (!decode_animation_input(data->in_data, data->in_size, data->animation_id, source.json, data->error_msg)) {
+        return false;
+    }
+    if (!scan_viewport_source(source)) {
+        data->error_msg = "Failed to load Lottie animation from provided JSON data";
+        return false;
+    }
+    std::string model_key = animation_model_key(data->in_data, data->in_size, data->resource_path, data->animation_id);
+
+    // Where a plain render puts the composition: fitted into the canvas with
+    // its aspect ratio kept, and centered.
+    double fit = std::min(viewport.canvas_width / source.width, viewport.canvas_height / source.height);
+    double scale = fit * viewport.scale;
+    double origin_x = ((viewport.canvas_width - source.width * fit) / 2 - viewport.x) * viewport.scale;
+    double origin_y = ((viewport.canvas_height - source.height * fit) / 2 - viewport.y) * viewport.scale;
+
+    int tile = viewport.tile_size;
+    if (tile == 0) tile = std::max(data->width, data->height) > li_MAX_TILE_DIMENSION ? li_DEFAULT_TILE_DIMENSION : li_MAX_TILE_DIMENSION;
+    int columns = (data->width + tile - 1) / tile;
+    int rows = (data->height + tile - 1) / tile;
+    size_t tiles = (size_t)columns * rows;
+
+    std::atomic<uint64_t> parse_ns(metrics_now_ns() - start);
+    std::atomic<uint64_t> render_ns(0);
+    std::mutex error_mutex;
+
+    // rlottie fits the whole composition into a surface's draw region rather
+    // than cropping to it, so every tile is a wrapper of its own, moved by the
+    // tile's offset and rendered onto a surface at the tile's origin. A single
+    // tile is kept in rlottie's model cache like any animation; the wrappers of
+    // a tiled render are used once and bypass it, so one poster cannot evict
+    // the models other renders share.
+    bool ok = parallel_for(tiles, std::min(tiles, default_concurrency()), [&](size_t, size_t index) {
+        if (is_cancelled(data->cancel)) {
+            std::lock_guard<std::mutex> lock(error_mutex);
+            data->error_msg = ls_ABORTED_MESSAGE;
+            return false;
+        }
+
+        int tile_x = (int)(index % columns) * tile;
+        int tile_y = (int)(index / columns) * tile;
+        int tile_width = std::min(tile, data->width - tile_x);
+        int tile_height = std::min(tile, data->height - tile_y);
+        double x = origin_x - tile_x;
+        double y = origin_y - tile_y;
+
+        uint64_t parse_start = metrics_now_ns();
+        std::string json = build_viewport_json(source, scale, x, y, tile_width, tile_height);
+        std::unique_ptr<rlottie::Animation> animation;
+        if (tiles == 1) {
+            char suffix[160];
+            snprintf(suffix, sizeof(suffix), ":%dx%d@%.9g,%.9g,%.9g", tile_width, tile_height, x, y, scale);
+            animation = load_shared_animation_from_data(std::move(json), model_key + suffix, data->resource_path);
+        } else {
+            animation = load_animation_from_data(std::move(json), data->resource_path);
+        }
+        parse_ns += metrics_now_ns() - parse_start;
+        if (!animation) {
+            std::lock_guard<std::mutex> lock(error_mutex);
+            data->error_msg = "Failed to load Lottie animation from provided JSON data";
+            return false;
+        }
+
+        size_t frame_count = get_total_frames(animation);
+        uint32_t frame = resolve_frame_address(data, frame_count, animation->frameRate());
+        if (frame >= frame_count) {
+            std::lock_guard<std::mutex> lock(error_mutex);
+            data->error_msg = "Frame index out of range (total frames: " + std::to_string(frame_count) + ")";
+            return false;
+        }
+
+        uint64_t render_start = metrics_now_ns();
+        uint32_t* origin = pixels + (size_t)tile_y * stride + tile_x;
+        rlottie::Surface surface(origin, tile_width, tile_height, stride * lp_COLOR_BYTES);
+        render_frame_sync(animation, frame, surface);
+        render_ns += metrics_now_ns() - render_start;
+        return true;
+    });
+
+    data->timings.stage_ns[METRIC_STAGE_PARSE] = parse_ns;
+    data->timings.stage_ns[METRIC_STAGE_RENDER] = render_ns;
+    return ok;
+}
\ No newline at end of file
@@ -0,0 +1,33 @@
+#ifndef VIEWPORT_H
+#define VIEWPORT_H
+
+#include <cstdint>
+#include <string>
+
+// A region of a canvas_width x canvas_height canvas, the animation fitted into
+// it as a plain render would, drawn at `scale` output pixels per canvas pixel.
+// Such frames are rendered from a wrapper composition the size of the output,
+// so rasterization cost follows output pixels only.
+struct RenderViewport {
+    bool enabled;
+    int canvas_width;
+    int canvas_height;
+    double x;
+    double y;
+    double width;
+    double height;
+    double scale;
+    // Edge of the square tiles the output is split into; 0 picks one tile up
+    // to li_MAX_TILE_DIMENSION and tiles of that size beyond it.
+    int tile_size;
+};
+
+struct ConverterData;
+
+// Renders the addressed frame through data->viewport into `pixels`, data->width x
+// data->height premultiplied ARGB32 with `stride` pixels per row. Tiles are
+// rendered in parallel, each from a wrapper of its own onto a surface at the
+// tile's origin. Fills the parse and render timings.
+bool render_viewport_frame(ConverterData* data, uint32_t* pixels, size_t stride);
+
+#endif // VIEWPORT_H
\ No newline at end of file
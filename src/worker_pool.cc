@@ -0,0 +1,394 @@
+#include "worker_pool.h"
+#include "addon.h"
+#include "parallel.h"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+struct PoolJob;
+
+// Shared by the env's queued jobs and its completion function, so that a job
+// finishing after the env has exited finds `closed` instead of a freed tsfn.
+struct PoolEnv : std::enable_shared_from_this<PoolEnv> {
+    napi_threadsafe_function tsfn;
+    // JS thread only: jobs queued from this env and not yet completed. The
+    // completion callback is only ref'd while there are any.
+    size_t pending;
+    // Guarded by pool.mutex: jobs of this env executing right now.
+    std::vector<PoolJob*> running;
+    // Guards tsfn once the env starts exiting.
+    std::mutex mutex;
+    bool closed;
+};
+
+struct PoolJob {
+    napi_env env;
+    napi_async_execute_callback execute;
+    napi_async_complete_callback complete;
+    PoolJobDestroy destroy;
+    void* data;
+    JobPriority priority;
+    std::shared_ptr<CancelToken> cancel;
+    std::shared_ptr<PoolEnv> pool_env;
+    std::chrono::steady_clock::time_point queued_at;
+    bool cancelled;
+};
+
+// A parallel_for fanned out from a running job: up to `offered` idle workers
+// each join in with fn(worker). Offers wait ahead of the queued jobs of the
+// same priority, since the job they help has already started.
+struct HelperGroup {
+    const std::function<void(size_t worker)>* fn;
+    JobPriority priority;
+    size_t offered;
+    size_t next_worker;
+    size_t active;
+    std::condition_variable done_cv;
+};
+
+struct WorkerPool {
+    std::mutex mutex;
+    std::condition_variable cv;
+    // Signalled whenever a job finishes executing.
+    std::condition_variable idle_cv;
+    std::deque<HelperGroup*> helpers[JOB_PRIORITY_COUNT];
+    std::deque<PoolJob*> queues[JOB_PRIORITY_COUNT];
+    std::vector<std::thread> threads;
+    std::vector<bool> alive;
+    size_t concurrency = 0;
+    size_t running = 0;
+    JobQueueStats stats[JOB_PRIORITY_COUNT] = {};
+};
+
+// Shared by every environment in the process; each environment only has its
+// own PoolEnv to receive completions on its JS thread. Never destroyed: the
+// workers are left running at process exit rather than joined, so exit()
+// doesn't wait for a render in flight.
+static WorkerPool& pool = *new WorkerPool();
+
+// The priority of the job running on this thread, inherited by its helpers.
+// Synchronous calls fan out from the JS thread at normal priority.
+static thread_local JobPriority current_priority = JOB_PRIORITY_NORMAL;
+
+// The job's environment is gone, so nothing can observe the result.
+static void abandon_job(PoolJob* job) {
+    job->destroy(job->data);
+    delete job;
+}
+
+static void dispatch_completion(PoolJob* job) {
+    bool sent;
+    {
+        std::lock_guard<std::mutex> lock(job->pool_env->mutex);
+        sent = !job->pool_env->closed &&
+               napi_call_threadsafe_function(job->pool_env->tsfn, job, napi_tsfn_nonblocking) == napi_ok;
+    }
+    if (!sent) abandon_job(job);
+}
+
+static void run_helper_locked(std::unique_lock<std::mutex>& lock, HelperGroup* group) {
+    size_t worker = group->next_worker++;
+    group->active++;
+    pool.running++;
+    lock.unlock();
+    current_priority = group->priority;
+    (*group->fn)(worker);
+    lock.lock();
+    pool.running--;
+    if (--group->active == 0) group->done_cv.notify_all();
+}
+
+static void run_worker(size_t index) {
+    std::unique_lock<std::mutex> lock(pool.mutex);
+    while (true) {
+        PoolJob* job = nullptr;
+        HelperGroup* group = nullptr;
+        pool.cv.wait(lock, [index, &job, &group] {
+            if (index >= pool.concurrency) return true;
+            for (size_t priority = 0; priority < JOB_PRIORITY_COUNT; priority++) {
+                std::deque<HelperGroup*>& helpers = pool.helpers[priority];
+                if (!helpers.empty()) {
+                    group = helpers.front();
+                    if (--group->offered == 0) helpers.pop_front();
+                    return true;
+                }
+                std::deque<PoolJob*>& queue = pool.queues[priority];
+                if (!queue.empty()) {
+                    job = queue.front();
+                    queue.pop_front();
+                    return true;
+                }
+            }
+            return false;
+        });
+        if (group) {
+            run_helper_locked(lock, group);
+            continue;
+        }
+        if (!job) {
+            pool.alive[index] = false;
+            return;
+        }
+
+        JobQueueStats& stats = pool.stats[job->priority];
+        if (is_cancelled(job->cancel)) {
+            job->cancelled = true;
+            stats.cancelled++;
+            lock.unlock();
+            dispatch_completion(job);
+            lock.lock();
+            continue;
+        }
+
+        double wait_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - job->queued_at).count();
+        stats.started++;
+        stats.total_wait_ms += wait_ms;
+        if (wait_ms > stats.max_wait_ms) stats.max_wait_ms = wait_ms;
+        pool.running++;
+        job->pool_env->running.push_back(job);
+        lock.unlock();
+
+        current_priority = job->priority;
+        job->execute(job->env, job->data);
+
+        // Leave the running count before the completion can reach JS, so a
+        // caller that reads the stats after its promise settles sees it done.
+        lock.lock();
+        pool.running--;
+        std::vector<PoolJob*>& env_running = job->pool_env->running;
+        env_running.erase(std::find(env_running.begin(), env_running.end(), job));
+        pool.idle_cv.notify_all();
+        lock.unlock();
+        dispatch_completion(job);
+        lock.lock();
+    }
+}
+
+// Starts workers up to the configured concurrency. A slot whose worker is
+// still finishing a job after a shrink is simply kept.
+static void start_workers_locked() {
+    if (pool.concurrency == 0) pool.concurrency = default_concurrency();
+    if (pool.threads.size() < pool.concurrency) {
+        pool.threads.resize(pool.concurrency);
+        pool.alive.resize(pool.concurrency, false);
+    }
+    for (size_t i = 0; i < pool.concurrency; i++) {
+        if (pool.alive[i]) continue;
+        if (pool.threads[i].joinable()) pool.threads[i].join();
+        try {
+            pool.threads[i] = std::thread(run_worker, i);
+            pool.alive[i] = true;
+        } catch (const std::system_error&) {
+            // Out of threads: the workers already running take the queue.
+            if (i == 0) throw;
+            break;
+        }
+    }
+}
+
+// Fans a parallel_for out over idle pool workers rather than fresh threads, so
+// it counts against the pool's concurrency and its thread-local scratch
+// buffers outlive the call. The caller works through the indices as well;
+// offers no worker has taken by the time it is done are withdrawn.
+static void run_on_pool(size_t helpers, const std::function<void(size_t worker)>& fn) {
+    HelperGroup group{&fn, current_priority, 0, 1, 0, {}};
+    {
+        std::lock_guard<std::mutex> lock(pool.mutex);
+        try {
+            start_workers_locked();
+            // On a pool thread, the caller itself holds one of the workers.
+            group.offered = std::min(helpers, pool.concurrency - 1);
+        } catch (const std::system_error&) {
+            group.offered = 0;
+        }
+        if (group.offered) pool.helpers[group.priority].push_back(&group);
+    }
+    if (group.offered == 1) {
+        pool.cv.notify_one();
+    } else if (group.offered) {
+        pool.cv.notify_all();
+    }
+
+    fn(0);
+
+    std::unique_lock<std::mutex> lock(pool.mutex);
+    if (group.offered) {
+        std::deque<HelperGroup*>& queue = pool.helpers[group.priority];
+        queue.erase(std::find(queue.begin(), queue.end(), &group));
+        group.offered = 0;
+    }
+    group.done_cv.wait(lock, [&group] { return group.active == 0; });
+}
+
+static const bool pool_runner_installed = (set_parallel_runner(run_on_pool), true);
+
+static void complete_pool_job(napi_env env, napi_value js_callback, void* context, void* data) {
+    PoolJob* job = static_cast<PoolJob*>(data);
+    // Without an env the tsfn is being torn down with this job still queued,
+    // and its finalizer has already freed the context.
+    if (env == nullptr) {
+        abandon_job(job);
+        return;
+    }
+    PoolEnv* pool_env = static_cast<std::shared_ptr<PoolEnv>*>(context)->get();
+    job->complete(env, job->cancelled ? napi_cancelled : napi_ok, job->data);
+    if (--pool_env->pending == 0) {
+        napi_unref_threadsafe_function(env, pool_env->tsfn);
+    }
+    delete job;
+}
+
+// Runs when the environment exits, e.g. a worker thread is terminated. Its
+// queued jobs are dropped and its running ones are cancelled and waited for,
+// since they may still read buffers owned by the environment's heap; they stop
+// at their next cancellation check instead of finishing the render. Neither
+// gets a completion; their data is destroyed instead.
+static void release_pool_env(void* arg) {
+    PoolEnv* pool_env = static_cast<PoolEnv*>(arg);
+    std::vector<PoolJob*> dropped;
+    {
+        std::unique_lock<std::mutex> lock(pool.mutex);
+        for (std::deque<PoolJob*>& queue : pool.queues) {
+            for (auto it = queue.begin(); it != queue.end();) {
+                if ((*it)->pool_env.get() == pool_env) {
+                    dropped.push_back(*it);
+                    it = queue.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+        }
+        for (PoolJob* job : pool_env->running) {
+            if (job->cancel) job->cancel->cancelled.store(true, std::memory_order_relaxed);
+        }
+        pool.idle_cv.wait(lock, [pool_env] { return pool_env->running.empty(); });
+    }
+    {
+        std::lock_guard<std::mutex> lock(pool_env->mutex);
+        pool_env->closed = true;
+    }
+    napi_release_threadsafe_function(pool_env->tsfn, napi_tsfn_abort);
+    for (PoolJob* job : dropped) {
+        abandon_job(job);
+    }
+}
+
+static void finalize_pool_env(napi_env env, void* finalize_data, void* hint) {
+    delete static_cast<std::shared_ptr<PoolEnv>*>(finalize_data);
+}
+
+static PoolEnv* get_pool_env(napi_env env) {
+    AddonData* addon = get_addon_data(env);
+    if (!addon) return nullptr;
+    if (addon->pool_env) return addon->pool_env;
+
+    // The threadsafe function holds one reference and every queued job another.
+    auto* owner = new std::shared_ptr<PoolEnv>(std::make_shared<PoolEnv>());
+    PoolEnv* pool_env = owner->get();
+    pool_env->tsfn = nullptr;
+    pool_env->pending = 0;
+    pool_env->closed = false;
+    napi_value resource_name;
+    napi_status status = napi_create_string_utf8(env, "LottieWorkerPool", NAPI_AUTO_LENGTH, &resource_name);
+    if (status == napi_ok) {
+        status = napi_create_threadsafe_function(env, nullptr, nullptr, resource_name, 0, 1, owner, finalize_pool_env,
+                                                 owner, complete_pool_job, &pool_env->tsfn);
+    }
+    if (status != napi_ok) {
+        delete owner;
+        return nullptr;
+    }
+    napi_unref_threadsafe_function(env, pool_env->tsfn);
+    napi_add_env_cleanup_hook(env, release_pool_env, pool_env);
+    addon->pool_env = pool_env;
+    return pool_env;
+}
+
+napi_status queue_pool_work(napi_env env, napi_async_execute_callback execute, napi_async_complete_callback complete,
+                            PoolJobDestroy destroy, void* data, JobPriority priority,
+                            const std::shared_ptr<CancelToken>& cancel) {
+    PoolEnv* pool_env = get_pool_env(env);
+    if (!pool_env) return napi_generic_failure;
+
+    PoolJob* job = new PoolJob{env, execute, complete, destroy, data, priority, cancel, pool_env->shared_from_this(), std::chrono::steady_clock::now(), false};
+    {
+        std::lock_guard<std::mutex> lock(pool.mutex);
+        try {
+            start_workers_locked();
+        } catch (const std::system_error&) {
+            delete job;
+            return napi_generic_failure;
+        }
+        pool.queues[priority].push_back(job);
+        pool.stats[priority].queued++;
+    }
+    pool.cv.notify_one();
+
+    if (pool_env->pending++ == 0) {
+        napi_ref_threadsafe_function(env, pool_env->tsfn);
+    }
+    return napi_ok;
+}
+
+void cancel_pool_work(const std::shared_ptr<CancelToken>& cancel) {
+    cancel->cancelled.store(true, std::memory_order_relaxed);
+
+    std::vector<PoolJob*> cancelled;
+    {
+        std::lock_guard<std::mutex> lock(pool.mutex);
+        for (std::deque<PoolJob*>& queue : pool.queues) {
+            for (auto it = queue.begin(); it != queue.end();) {
+                if ((*it)->cancel == cancel) {
+                    (*it)->cancelled = true;
+                    pool.stats[(*it)->priority].cancelled++;
+                    cancelled.push_back(*it);
+                    it = queue.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+        }
+    }
+    for (PoolJob* job : cancelled) {
+        dispatch_completion(job);
+    }
+}
+
+void set_pool_concurrency(size_t concurrency) {
+    std::lock_guard<std::mutex> lock(pool.mutex);
+    bool started = !pool.threads.empty();
+    pool.concurrency = concurrency;
+    // Surplus workers exit once their current job is done.
+    pool.cv.notify_all();
+    if (started) start_workers_locked();
+}
+
+WorkerPoolStats get_worker_pool_stats() {
+    std::lock_guard<std::mutex> lock(pool.mutex);
+    WorkerPoolStats stats;
+    stats.concurrency = pool.concurrency ? pool.concurrency : default_concurrency();
+    stats.running = pool.running;
+    for (size_t i = 0; i < JOB_PRIORITY_COUNT; i++) {
+        stats.queues[i] = pool.stats[i];
+        stats.queues[i].depth = pool.queues[i].size();
+    }
+    return stats;
+}
+
+bool parse_job_priority(const std::string& name, JobPriority* priority) {
+    if (name == "high") {
+        *priority = JOB_PRIORITY_HIGH;
+    } else if (name == "normal") {
+        *priority = JOB_PRIORITY_NORMAL;
+    } else if (name == "low") {
+        *priority = JOB_PRIORITY_LOW;
+    } else {
+        return false;
+    }
+    return true;
+}
\ No newline at end of file
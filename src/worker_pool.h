@@ -0,0 +1,66 @@
+#ifndef WORKER_POOL_H
+#define WORKER_POOL_H
+
+#include <napi.h>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#define ls_ABORTED_MESSAGE "Operation aborted"
+
+enum JobPriority {
+    JOB_PRIORITY_HIGH,
+    JOB_PRIORITY_NORMAL,
+    JOB_PRIORITY_LOW,
+    JOB_PRIORITY_COUNT
+};
+
+// Set from JS when the caller's AbortSignal fires, or by the pool when the
+// job's environment exits. Jobs still queued are completed as cancelled right
+// away; running jobs poll it between stages.
+struct CancelToken {
+    std::atomic<bool> cancelled{false};
+};
+
+struct JobQueueStats {
+    size_t depth;
+    uint64_t queued;
+    uint64_t started;
+    uint64_t cancelled;
+    double total_wait_ms;
+    double max_wait_ms;
+};
+
+struct WorkerPoolStats {
+    size_t concurrency;
+    size_t running;
+    JobQueueStats queues[JOB_PRIORITY_COUNT];
+};
+
+// Frees a job's data instead of `complete` when the job's environment exits
+// before the job completes. It may run on any thread and must not call into
+// JS; references into the exiting environment die with it and are dropped,
+// not deleted.
+typedef void (*PoolJobDestroy)(void* data);
+
+// The addon's own render threads. Jobs run here instead of on the libuv
+// threadpool, so long renders never hold up fs or dns work. Higher priority
+// jobs always start first; within a priority jobs start in queue order.
+// `execute` runs on a pool thread and `complete` on the JS thread, with
+// napi_cancelled if the job was cancelled before it started. Every job gets
+// exactly one of `complete` and `destroy`.
+napi_status queue_pool_work(napi_env env, napi_async_execute_callback execute, napi_async_complete_callback complete,
+                            PoolJobDestroy destroy, void* data, JobPriority priority,
+                            const std::shared_ptr<CancelToken>& cancel);
+// Cancels the token and completes every job still queued under it.
+void cancel_pool_work(const std::shared_ptr<CancelToken>& cancel);
+void set_pool_concurrency(size_t concurrency);
+WorkerPoolStats get_worker_pool_stats();
+bool parse_job_priority(const std::string& name, JobPriority* priority);
+
+inline bool is_cancelled(const std::shared_ptr<CancelToken>& cancel) {
+    return cancel && cancel->cancelled.load(std::memory_order_relaxed);
+}
+
+#endif // WORKER_POOL_H
\ No newline at end of file
@@ -0,0 +1,86 @@
+// The parsed-animation cache: hits reuse the parsed model with a renderer of
+// their own, and entries are charged by their decoded size.
+//
+//   node --test test/
+
+"use strict";
+
+const assert = require("node:assert");
+const fs = require("node:fs");
+const path = require("node:path");
+const { test } = require("node:test");
+const zlib = require("node:zlib");
+const lottie = require("..");
+
+const corpus = path.join(__dirname, "..", "bench", "corpus");
+
+test("concurrent exports of a cached animation match uncached ones", async () => {
+  const input = fs.readFileSync(path.join(corpus, "shapes.json"));
+  const options = { width: 96, height: 96, format: "rgba" };
+  const frames = [0, 5, 10, 15, 20, 25, 30, 35];
+  const expected = frames.map((frame) => lottie.exportFrameSync(input, { ...options, frame }));
+
+  lottie.configureAnimationCache({ maxEntries: 4 });
+  try {
+    const before = lottie.getAnimationCacheStats();
+    const results = await Promise.all(frames.map((frame) => lottie.exportFrame(input, { ...options, frame })));
+    for (let i = 0; i < frames.length; i++) {
+      assert.ok(results[i].equals(expected[i]), `frame ${frames[i]} differs`);
+    }
+    const after = lottie.getAnimationCacheStats();
+    assert.strictEqual(after.entries, 1);
+    assert.strictEqual(after.hits + after.misses - before.hits - before.misses, frames.length);
+    assert.ok(after.hits - before.hits >= frames.length - 1);
+  } finally {
+    lottie.configureAnimationCache({ maxEntries: 0 });
+    lottie.clearAnimationCache();
+  }
+});
+
+test("a .tgs entry is charged its decoded size", () => {
+  const json = fs.readFileSync(path.join(corpus, "layers.json"));
+  const tgs = zlib.gzipSync(json);
+  lottie.configureAnimationCache({ maxEntries: 4 });
+  try {
+    lottie.exportFrameSync(tgs, { width: 32, height: 32, format: "rgba" });
+    assert.strictEqual(lottie.getAnimationCacheStats().bytes, json.length);
+
+    // A budget that fits the compressed file but not the decoded one keeps
+    // nothing.
+    lottie.clearAnimationCache();
+    lottie.configureAnimationCache({ maxEntries: 4, maxBytes: tgs.length * 2 });
+    lottie.exportFrameSync(tgs, { width: 32, height: 32, format: "rgba" });
+    assert.strictEqual(lottie.getAnimationCacheStats().entries, 0);
+  } finally {
+    lottie.configureAnimationCache({ maxEntries: 0, maxBytes: 0 });
+    lottie.clearAnimationCache();
+  }
+});
+
+test("entries that survive an eviction still hit and render the same", () => {
+  const shapes = fs.readFileSync(path.join(corpus, "shapes.json"));
+  const layers = fs.readFileSync(path.join(corpus, "layers.json"));
+  const options = { width: 48, height: 48, format: "rgba" };
+  const expected = lottie.exportFrameSync(shapes, options);
+
+  lottie.configureAnimationCache({ maxEntries: 1 });
+  try {
+    const start = lottie.getAnimationCacheStats();
+    lottie.exportFrameSync(shapes, options);
+    // Caching the second animation evicts the first one, which empties
+    // rlottie's model cache.
+    lottie.exportFrameSync(layers, options);
+    const before = lottie.getAnimationCacheStats();
+    assert.strictEqual(before.entries, 1);
+    assert.strictEqual(before.evictions - start.evictions, 1);
+
+    lottie.exportFrameSync(layers, options);
+    assert.ok(lottie.exportFrameSync(shapes, options).equals(expected));
+    const after = lottie.getAnimationCacheStats();
+    assert.strictEqual(after.hits - before.hits, 1);
+    assert.strictEqual(after.misses - before.misses, 1);
+  } finally {
+    lottie.configureAnimationCache({ maxEntries: 0 });
+    lottie.clearAnimationCache();
+  }
+});
@@ -0,0 +1,164 @@
+// Compressed inputs: .tgs and .lottie data render like the JSON inside, and
+// size fields that lie only size the first allocation, never making it larger
+// than the data could inflate to.
+//
+//   node --test test/
+
+"use strict";
+
+const assert = require("node:assert");
+const { execFile } = require("node:child_process");
+const fs = require("node:fs");
+const os = require("node:os");
+const path = require("node:path");
+const { test } = require("node:test");
+const zlib = require("node:zlib");
+const lottie = require("..");
+
+const corpus = path.join(__dirname, "..", "bench", "corpus");
+const json = fs.readFileSync(path.join(corpus, "simple.json"));
+
+function crc32(data) {
+  let crc = ~0;
+  for (const byte of data) {
+    crc ^= byte;
+    for (let k = 0; k < 8; k++) crc = (crc >>> 1) ^ (0xedb88320 & -(crc & 1));
+  }
+  return ~crc >>> 0;
+}
+
+// A zip archive of `entries`, each `{ name, data, size }`, deflated and with
+// `size` (default: the real one) recorded as the uncompressed size in both
+// headers.
+function zipArchive(entries) {
+  const locals = [];
+  const centrals = [];
+  let offset = 0;
+  for (const { name, data, size = data.length } of entries) {
+    const entryName = Buffer.from(name);
+    const compressed = zlib.deflateRawSync(data);
+    const crc = crc32(data);
+
+    const local = Buffer.alloc(30);
+    local.writeUInt32LE(0x04034b50, 0);
+    local.writeUInt16LE(20, 4);
+    local.writeUInt16LE(8, 8);
+    local.writeUInt32LE(crc, 14);
+    local.writeUInt32LE(compressed.length, 18);
+    local.writeUInt32LE(size, 22);
+    local.writeUInt16LE(entryName.length, 26);
+
+    const central = Buffer.alloc(46);
+    central.writeUInt32LE(0x02014b50, 0);
+    central.writeUInt16LE(20, 4);
+    central.writeUInt16LE(20, 6);
+    central.writeUInt16LE(8, 10);
+    central.writeUInt32LE(crc, 16);
+    central.writeUInt32LE(compressed.length, 20);
+    central.writeUInt32LE(size, 24);
+    central.writeUInt16LE(entryName.length, 28);
+    central.writeUInt32LE(offset, 42);
+
+    locals.push(local, entryName, compressed);
+    centrals.push(central, entryName);
+    offset += local.length + entryName.length + compressed.length;
+  }
+
+  const directory = Buffer.concat(centrals);
+  const end = Buffer.alloc(22);
+  end.writeUInt32LE(0x06054b50, 0);
+  end.writeUInt16LE(entries.length, 8);
+  end.writeUInt16LE(entries.length, 10);
+  end.writeUInt32LE(directory.length, 12);
+  end.writeUInt32LE(offset, 16);
+
+  return Buffer.concat([...locals, directory, end]);
+}
+
+// A .lottie archive holding `animations/<name>.json` with `size` recorded as
+// its uncompressed size in both headers.
+function dotLottie(name, data, size) {
+  return zipArchive([{ name: `animations/${name}.json`, data, size }]);
+}
+
+// Exports `input` in a fresh process, since peak RSS never comes back down,
+// and returns how far the export raised it in MB along with any error.
+async function exportInChild(input) {
+  const file = path.join(fs.mkdtempSync(path.join(os.tmpdir(), "lottie-frame-")), "input");
+  fs.writeFileSync(file, input);
+  const script = `
+    const lottie = require(${JSON.stringify(path.join(__dirname, ".."))});
+    const fs = require("node:fs");
+    const input = fs.readFileSync(${JSON.stringify(file)});
+    // Warms up the addon and the render path with the plain JSON.
+    lottie.exportFrameSync(fs.readFileSync(${JSON.stringify(path.join(corpus, "simple.json"))}), { width: 16, height: 16 });
+    const before = process.resourceUsage().maxRSS;
+    let error = null;
+    try {
+      lottie.exportFrameSync(input, { width: 16, height: 16 });
+    } catch (e) {
+      error = e.message;
+    }
+    console.log(JSON.stringify({ grown: (process.resourceUsage().maxRSS - before) / 1024, error }));
+  `;
+  try {
+    const stdout = await new Promise((resolve, reject) => {
+      execFile(process.execPath, [...process.execArgv, "-e", script], (error, out) => (error ? reject(error) : resolve(out)));
+    });
+    return JSON.parse(stdout);
+  } finally {
+    fs.rmSync(path.dirname(file), { recursive: true });
+  }
+}
+
+test("a gzip ISIZE of 4 GB doesn't allocate 256 MB", async () => {
+  const tgs = zlib.gzipSync(json);
+  tgs.writeUInt32LE(0xffffffff, tgs.length - 4);
+  const { grown, error } = await exportInChild(tgs);
+  // zlib checks ISIZE once the data is inflated.
+  assert.ok(error, "a wrong ISIZE is rejected");
+  assert.ok(grown < 32, `peak RSS grew by ${grown.toFixed(0)} MB`);
+});
+
+test("a .lottie entry announcing 255 MB loads with its real size", async () => {
+  const archive = dotLottie("simple", json, 255 << 20);
+  const { grown, error } = await exportInChild(archive);
+  assert.strictEqual(error, null);
+  assert.ok(grown < 32, `peak RSS grew by ${grown.toFixed(0)} MB`);
+
+  const frame = lottie.exportFrameSync(archive, { width: 16, height: 16 });
+  assert.ok(frame.equals(lottie.exportFrameSync(json, { width: 16, height: 16 })));
+});
+
+test("a .lottie entry announcing too little still inflates in full", () => {
+  const archive = dotLottie("simple", json, 16);
+  const frame = lottie.exportFrameSync(archive, { width: 16, height: 16 });
+  assert.ok(frame.equals(lottie.exportFrameSync(json, { width: 16, height: 16 })));
+});
+
+test("a .tgs sticker renders like its JSON", async () => {
+  const tgs = zlib.gzipSync(json);
+  const options = { frame: 12, width: 48, height: 48, format: "rgba" };
+  const expected = lottie.exportFrameSync(json, options);
+  assert.ok(lottie.exportFrameSync(tgs, options).equals(expected));
+  assert.ok((await lottie.exportFrame(tgs, options)).equals(expected));
+  assert.ok(lottie.loadAnimationSync(tgs).renderFrameSync(options).equals(expected));
+});
+
+test("a .lottie archive yields the manifest's first animation or the one asked for", async () => {
+  const wide = Buffer.from(JSON.stringify({ ...JSON.parse(json), w: 1024, h: 256 }));
+  const manifest = Buffer.from(JSON.stringify({ version: "1", animations: [{ id: "wide" }, { id: "simple" }] }));
+  const archive = zipArchive([
+    { name: "manifest.json", data: manifest },
+    { name: "animations/simple.json", data: json },
+    { name: "animations/wide.json", data: wide },
+  ]);
+  const options = { frame: 12, width: 48, height: 48, format: "rgba" };
+
+  assert.deepStrictEqual(lottie.loadAnimationSync(archive).size, { width: 1024, height: 256 });
+  assert.ok(lottie.exportFrameSync(archive, options).equals(lottie.exportFrameSync(wide, options)));
+  const simple = await lottie.loadAnimation(archive, { animationId: "simple" });
+  assert.deepStrictEqual(simple.size, { width: 512, height: 512 });
+  assert.ok(simple.renderFrameSync(options).equals(lottie.exportFrameSync(json, options)));
+  assert.throws(() => lottie.exportFrameSync(archive, { ...options, animationId: "missing" }), /'missing' not found/);
+});
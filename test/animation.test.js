@@ -0,0 +1,53 @@
+// LottieAnimation handles: parsed once, they render the same frames as
+// one-shot exports, concurrently and after the input buffer is reused.
+//
+//   node --test test/
+
+"use strict";
+
+const assert = require("node:assert");
+const fs = require("node:fs");
+const path = require("node:path");
+const { test } = require("node:test");
+const lottie = require("..");
+
+const corpus = path.join(__dirname, "..", "bench", "corpus");
+
+test("handles report the animation's metadata", async () => {
+  const input = fs.readFileSync(path.join(corpus, "shapes.json"));
+  for (const animation of [lottie.loadAnimationSync(input), await lottie.loadAnimation(input)]) {
+    assert.strictEqual(animation.totalFrames, 60);
+    assert.strictEqual(animation.frameRate, 30);
+    assert.strictEqual(animation.duration, 2);
+    assert.deepStrictEqual(animation.size, { width: 512, height: 512 });
+  }
+});
+
+test("renders match one-shot exports, also when issued together", async () => {
+  const input = fs.readFileSync(path.join(corpus, "layers.json"));
+  const animation = await lottie.loadAnimation(input);
+  const options = (frame) => ({ frame, width: 160, height: 120, format: frame % 2 ? "rgba" : "png" });
+  const frames = [0, 7, 15, 16, 33, 59];
+
+  const renders = await Promise.all(frames.map((frame) => animation.renderFrame(options(frame))));
+  frames.forEach((frame, index) => {
+    const expected = lottie.exportFrameSync(input, options(frame));
+    assert.ok(renders[index].equals(expected), `frame ${frame}`);
+    assert.ok(animation.renderFrameSync(options(frame)).equals(expected), `frame ${frame}, sync`);
+  });
+});
+
+test("a handle doesn't read its input after loading", () => {
+  const input = fs.readFileSync(path.join(corpus, "shapes.json"));
+  const options = { frame: 20, width: 64, height: 64, format: "rgba" };
+  const expected = lottie.exportFrameSync(input, options);
+  const animation = lottie.loadAnimationSync(input);
+  input.fill(0);
+  assert.ok(animation.renderFrameSync(options).equals(expected));
+});
+
+test("empty input fails to load", async () => {
+  const input = Buffer.alloc(0);
+  assert.throws(() => lottie.loadAnimationSync(input), /Failed to load Lottie animation/);
+  await assert.rejects(lottie.loadAnimation(input), /Failed to load Lottie animation/);
+});
@@ -0,0 +1,104 @@
+// APNG export: the chunk sequence is well formed, an unchanged stretch of
+// frames is merged into one longer frame, and every other frame stores only
+// the rectangle of pixels that changed since the one before.
+//
+//   node --test test/
+
+"use strict";
+
+const assert = require("node:assert");
+const { test } = require("node:test");
+const lottie = require("..");
+
+// A disc that grows until frame 40, holds its size through frame 49 and
+// shrinks again, so frames 41-49 are identical to frame 40.
+const size = { k: [
+  { t: 0, s: [20, 20], o: { x: [0], y: [0] }, i: { x: [1], y: [1] } },
+  { t: 40, s: [60, 60], o: { x: [0], y: [0] }, i: { x: [1], y: [1] } },
+  { t: 49, s: [60, 60], o: { x: [0], y: [0] }, i: { x: [1], y: [1] } },
+  { t: 59, s: [20, 20] },
+], a: 1 };
+const input = Buffer.from(JSON.stringify({
+  v: "5.7.0", fr: 30, ip: 0, op: 60, w: 100, h: 100, layers: [{
+    ty: 4, ind: 1, ip: 0, op: 60, st: 0,
+    ks: { o: { a: 0, k: 100 }, r: { a: 0, k: 0 }, p: { a: 0, k: [50, 50] }, a: { a: 0, k: [0, 0] }, s: { a: 0, k: [100, 100] } },
+    shapes: [
+      { ty: "el", p: { a: 0, k: [0, 0] }, s: size },
+      { ty: "fl", c: { a: 0, k: [0.8, 0.4, 0.1, 1] }, o: { a: 0, k: 100 } },
+    ],
+  }],
+}));
+
+function readChunks(png) {
+  assert.ok(png.subarray(0, 8).equals(Buffer.from([137, 80, 78, 71, 13, 10, 26, 10])));
+  const chunks = [];
+  for (let offset = 8; offset < png.length; ) {
+    const length = png.readUInt32BE(offset);
+    chunks.push({ type: png.toString("latin1", offset + 4, offset + 8), data: png.subarray(offset + 8, offset + 8 + length) });
+    offset += 12 + length;
+  }
+  return chunks;
+}
+
+function readFctl(data) {
+  return {
+    sequence: data.readUInt32BE(0),
+    width: data.readUInt32BE(4),
+    height: data.readUInt32BE(8),
+    x: data.readUInt32BE(12),
+    y: data.readUInt32BE(16),
+    delay: data.readUInt16BE(20) / data.readUInt16BE(22),
+  };
+}
+
+function dirtyRect(previous, current, width, height) {
+  let [left, top, right, bottom] = [width, height, -1, -1];
+  for (let y = 0; y < height; y++) {
+    for (let x = 0; x < width; x++) {
+      const i = (y * width + x) * 4;
+      if (previous.readUInt32BE(i) !== current.readUInt32BE(i)) {
+        [left, top] = [Math.min(left, x), Math.min(top, y)];
+        [right, bottom] = [Math.max(right, x), Math.max(bottom, y)];
+      }
+    }
+  }
+  return right < 0 ? null : { x: left, y: top, width: right - left + 1, height: bottom - top + 1 };
+}
+
+test("a static stretch is merged and changed frames are cropped", async () => {
+  const options = { width: 100, height: 100 };
+  const frames = await lottie.exportFrames(input, { ...options, format: "rgba", dedupe: false });
+  const chunks = readChunks(await lottie.exportAnimation(input, options));
+
+  // Keep each shown frame's number and its change from the frame before.
+  const shown = [];
+  for (let frame = 0; frame < frames.length; frame++) {
+    const rect = frame ? dirtyRect(frames[frame - 1], frames[frame], 100, 100) : { x: 0, y: 0, width: 100, height: 100 };
+    if (rect) shown.push({ frame, rect, delay: 1 / 30 });
+    else shown[shown.length - 1].delay += 1 / 30;
+  }
+  const held = shown.find((entry) => entry.frame === 40);
+  assert.ok(held && held.delay > 9.5 / 30, "frames 41-49 render like frame 40");
+  assert.ok(held.rect.width < 100 || held.rect.height < 100, "the disc does not fill the frame");
+
+  const actl = chunks.find((chunk) => chunk.type === "acTL").data;
+  assert.strictEqual(actl.readUInt32BE(0), shown.length);
+  assert.strictEqual(actl.readUInt32BE(4), 0);
+
+  // fcTL and fdAT share one sequence, starting at 0 and without gaps.
+  const sequenced = chunks.filter((chunk) => chunk.type === "fcTL" || chunk.type === "fdAT");
+  sequenced.forEach((chunk, index) => assert.strictEqual(chunk.data.readUInt32BE(0), index));
+  assert.strictEqual(chunks.findIndex((chunk) => chunk.type === "fcTL"), chunks.findIndex((chunk) => chunk.type === "IDAT") - 1);
+
+  const controls = chunks.filter((chunk) => chunk.type === "fcTL").map((chunk) => readFctl(chunk.data));
+  assert.strictEqual(controls.length, shown.length);
+  controls.forEach((control, index) => {
+    const { frame, rect, delay } = shown[index];
+    assert.deepStrictEqual(
+      { x: control.x, y: control.y, width: control.width, height: control.height },
+      rect,
+      `frame ${frame}`
+    );
+    assert.ok(Math.abs(control.delay - delay) < 1e-9, `delay of frame ${frame}`);
+  });
+});
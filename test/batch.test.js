@@ -0,0 +1,57 @@
+// Batch exports: deduplicated results are reported by position, which stays
+// unambiguous when time resampling requests a frame number more than once.
+//
+//   node --test test/
+
+"use strict";
+
+const assert = require("node:assert");
+const fs = require("node:fs");
+const path = require("node:path");
+const { test } = require("node:test");
+const lottie = require("..");
+
+const corpus = path.join(__dirname, "..", "bench", "corpus");
+const input = fs.readFileSync(path.join(corpus, "shapes.json"));
+
+// Every result that shares an earlier result's Buffer, as [index, sourceIndex].
+function sharedBuffers(results) {
+  const pairs = [];
+  for (let i = 0; i < results.length; i++) {
+    const source = results.indexOf(results[i]);
+    if (source !== i) pairs.push([i, source]);
+  }
+  return pairs;
+}
+
+test("duplicates pair each repeated result with its source", async () => {
+  const results = await lottie.exportFrames(input, { frames: [0, 20, 0, 20, 10], width: 64, height: 64, format: "rgba" });
+  assert.deepStrictEqual(results.frames, [0, 20, 0, 20, 10]);
+  assert.deepStrictEqual(results.duplicates, sharedBuffers(results));
+  assert.deepStrictEqual(results.duplicates.slice(0, 2), [[2, 0], [3, 1]]);
+});
+
+test("duplicates of a resampled export index the results, not the frames", async () => {
+  const totalFrames = (await lottie.loadAnimation(input)).totalFrames;
+  const results = await lottie.exportFrames(input, { fps: 240, width: 32, height: 32, format: "rgba" });
+  assert.ok(results.length > totalFrames);
+  assert.ok(new Set(results.frames).size < results.length);
+  assert.deepStrictEqual(results.duplicates, sharedBuffers(results));
+
+  const unique = await lottie.exportFrames(input, { fps: 240, width: 32, height: 32, format: "rgba", dedupe: false });
+  assert.deepStrictEqual(unique.duplicates, []);
+});
+
+test("ranges beyond the animation are rejected before they are expanded", async () => {
+  const totalFrames = (await lottie.loadAnimation(input)).totalFrames;
+  await assert.rejects(
+    lottie.exportFrames(input, { frames: { start: 0, end: 4294967295 }, width: 16, height: 16 }),
+    /out of range/
+  );
+  await assert.rejects(
+    lottie.exportFrames(input, { frames: { start: totalFrames }, width: 16, height: 16 }),
+    /after its end/
+  );
+  const last = await lottie.exportFrames(input, { frames: { start: totalFrames - 1 }, width: 16, height: 16 });
+  assert.deepStrictEqual(last.frames, [totalFrames - 1]);
+});
@@ -0,0 +1,78 @@
+// Steady-state allocations: once a thread has rendered a size, its render
+// surfaces and conversion buffers come from the scratch pool, each frame
+// allocates only its output, and inputs are read in place.
+//
+//   node --test test/
+
+"use strict";
+
+const assert = require("node:assert");
+const fs = require("node:fs");
+const path = require("node:path");
+const { test } = require("node:test");
+const lottie = require("..");
+
+const corpus = path.join(__dirname, "..", "bench", "corpus");
+const input = fs.readFileSync(path.join(corpus, "shapes.json"));
+const FRAMES = 24;
+const WARM_UP = 2;
+
+// Renders FRAMES frames one after another and returns how the pool counters
+// moved after the first WARM_UP of them.
+async function steadyState(render) {
+  for (let frame = 0; frame < WARM_UP; frame++) await render(frame);
+  const before = lottie.getBufferPoolStats();
+  for (let frame = WARM_UP; frame < FRAMES; frame++) await render(frame);
+  const after = lottie.getBufferPoolStats();
+  return {
+    scratchAllocations: after.scratchAllocations - before.scratchAllocations,
+    scratchReuses: after.scratchReuses - before.scratchReuses,
+    outputAllocations: after.outputAllocations - before.outputAllocations,
+  };
+}
+
+for (const format of ["rgba", "qoi", "png"]) {
+  test(`synchronous ${format} frames stop allocating scratch after warm-up`, async () => {
+    const counts = await steadyState((frame) => lottie.exportFrameSync(input, { frame, width: 256, height: 256, format }));
+    assert.strictEqual(counts.scratchAllocations, 0);
+    // Raw frames render straight into their output and need no scratch.
+    if (format !== "rgba") assert.ok(counts.scratchReuses > 0);
+    // PNG output grows by doubling from an estimate; the others are sized
+    // exactly up front.
+    if (format === "png") {
+      assert.ok(counts.outputAllocations >= FRAMES - WARM_UP);
+    } else {
+      assert.strictEqual(counts.outputAllocations, FRAMES - WARM_UP);
+    }
+  });
+}
+
+test("asynchronous frames stop allocating scratch after warm-up", async () => {
+  const concurrency = lottie.getQueueStats().concurrency;
+  // One pool thread, so the warm-up covers every thread that renders.
+  lottie.setConcurrency(1);
+  try {
+    const counts = await steadyState((frame) => lottie.exportFrame(input, { frame, width: 256, height: 256, format: "rgba" }));
+    assert.strictEqual(counts.scratchAllocations, 0);
+    assert.strictEqual(counts.outputAllocations, FRAMES - WARM_UP);
+  } finally {
+    lottie.setConcurrency(concurrency);
+  }
+});
+
+// The input is borrowed, so bytes changed while a job waits in the queue are
+// what it parses. A copy taken at call time would still render.
+test("inputs are read in place, not copied", async () => {
+  const concurrency = lottie.getQueueStats().concurrency;
+  lottie.setConcurrency(1);
+  try {
+    const blocker = lottie.exportFrame(input, { width: 2048, height: 2048, format: "rgba" });
+    const borrowed = Buffer.from(input);
+    const pending = lottie.exportFrame(borrowed, { width: 64, height: 64 });
+    borrowed.fill(0x20);
+    await blocker;
+    await assert.rejects(pending);
+  } finally {
+    lottie.setConcurrency(concurrency);
+  }
+});
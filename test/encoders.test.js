@@ -0,0 +1,153 @@
+// The fast encoders round-trip: png-fast's zlib stream inflates to exactly the
+// sub-filtered rows of an rgba export, and QOI decodes to its pixels. Sizes
+// are picked to cross deflate's 258-byte match limit, QOI's 62-pixel run
+// limit and the row strips of compressionThreads. The default PNG settings
+// compress, while the legacy quality 100 still stores.
+//
+//   node --test test/
+
+"use strict";
+
+const assert = require("node:assert");
+const fs = require("node:fs");
+const path = require("node:path");
+const zlib = require("node:zlib");
+const { test } = require("node:test");
+const lottie = require("..");
+
+const corpus = path.join(__dirname, "..", "bench", "corpus");
+const input = fs.readFileSync(path.join(corpus, "shapes.json"));
+
+const sizes = [
+  [1, 1],
+  [1, 150],
+  [61, 9],
+  [62, 9],
+  [63, 9],
+  [65, 33],
+  [300, 7],
+  [517, 211],
+];
+
+function readPng(png) {
+  assert.ok(png.subarray(0, 8).equals(Buffer.from([137, 80, 78, 71, 13, 10, 26, 10])));
+  const chunks = [];
+  for (let offset = 8; offset < png.length; ) {
+    const length = png.readUInt32BE(offset);
+    chunks.push({ type: png.toString("latin1", offset + 4, offset + 8), data: png.subarray(offset + 8, offset + 8 + length) });
+    offset += 12 + length;
+  }
+  const ihdr = chunks[0].data;
+  return {
+    width: ihdr.readUInt32BE(0),
+    height: ihdr.readUInt32BE(4),
+    bitDepth: ihdr[8],
+    colorType: ihdr[9],
+    idat: Buffer.concat(chunks.filter((chunk) => chunk.type === "IDAT").map((chunk) => chunk.data)),
+  };
+}
+
+// Each row as filter type 1 (sub) followed by the row minus the pixel before.
+function subFilteredRows(rgba, width, height) {
+  const stride = width * 4;
+  const out = Buffer.alloc(height * (stride + 1));
+  for (let y = 0; y < height; y++) {
+    const row = y * (stride + 1);
+    out[row] = 1;
+    for (let i = 0; i < stride; i++) {
+      const left = i >= 4 ? rgba[y * stride + i - 4] : 0;
+      out[row + 1 + i] = (rgba[y * stride + i] - left) & 0xff;
+    }
+  }
+  return out;
+}
+
+// A straightforward decoder written from the QOI specification.
+function decodeQoi(qoi) {
+  assert.strictEqual(qoi.toString("latin1", 0, 4), "qoif");
+  const width = qoi.readUInt32BE(4);
+  const height = qoi.readUInt32BE(8);
+  const pixels = Buffer.alloc(width * height * 4);
+  const index = new Uint8Array(64 * 4);
+  let [r, g, b, a] = [0, 0, 0, 255];
+  let offset = 14;
+  let run = 0;
+  for (let p = 0; p < pixels.length; p += 4) {
+    if (run > 0) {
+      run--;
+    } else {
+      const op = qoi[offset++];
+      if (op === 0xfe) {
+        [r, g, b] = [qoi[offset], qoi[offset + 1], qoi[offset + 2]];
+        offset += 3;
+      } else if (op === 0xff) {
+        [r, g, b, a] = [qoi[offset], qoi[offset + 1], qoi[offset + 2], qoi[offset + 3]];
+        offset += 4;
+      } else if (op >> 6 === 0) {
+        [r, g, b, a] = index.subarray(op * 4, op * 4 + 4);
+      } else if (op >> 6 === 1) {
+        r = (r + ((op >> 4) & 3) - 2) & 0xff;
+        g = (g + ((op >> 2) & 3) - 2) & 0xff;
+        b = (b + (op & 3) - 2) & 0xff;
+      } else if (op >> 6 === 2) {
+        const dg = (op & 0x3f) - 32;
+        const next = qoi[offset++];
+        r = (r + dg + (next >> 4) - 8) & 0xff;
+        g = (g + dg) & 0xff;
+        b = (b + dg + (next & 0x0f) - 8) & 0xff;
+      } else {
+        run = op & 0x3f;
+      }
+      index.set([r, g, b, a], ((r * 3 + g * 5 + b * 7 + a * 11) % 64) * 4);
+    }
+    pixels.set([r, g, b, a], p);
+  }
+  assert.ok(qoi.subarray(offset).equals(Buffer.from([0, 0, 0, 0, 0, 0, 0, 1])), "stream ends with the end marker");
+  return { width, height, pixels };
+}
+
+test("png-fast inflates to the sub-filtered rows", () => {
+  for (const [width, height] of sizes) {
+    const options = { frame: 12, width, height };
+    const rgba = lottie.exportFrameSync(input, { ...options, format: "rgba" });
+    const png = readPng(lottie.exportFrameSync(input, { ...options, format: "png-fast" }));
+    assert.deepStrictEqual([png.width, png.height, png.bitDepth, png.colorType], [width, height, 8, 6]);
+    // inflateSync also checks the stream's Adler-32.
+    assert.ok(zlib.inflateSync(png.idat).equals(subFilteredRows(rgba, width, height)), `${width}x${height}`);
+  }
+});
+
+test("png-fast frames split into strips inflate the same", () => {
+  // 4 bytes a pixel: both frames hold enough rows for several strips, and
+  // the odd height leaves the last strip short.
+  for (const [width, height] of [[512, 512], [700, 389]]) {
+    const options = { frame: 40, width, height };
+    const rgba = lottie.exportFrameSync(input, { ...options, format: "rgba" });
+    const expected = subFilteredRows(rgba, width, height);
+    for (const compressionThreads of [1, 2, 3]) {
+      const png = readPng(lottie.exportFrameSync(input, { ...options, format: "png-fast", compressionThreads }));
+      assert.ok(zlib.inflateSync(png.idat).equals(expected), `${width}x${height} on ${compressionThreads} threads`);
+    }
+  }
+});
+
+test("qoi decodes to the rgba pixels", async () => {
+  for (const [width, height] of sizes) {
+    const options = { frame: 25, width, height };
+    const rgba = lottie.exportFrameSync(input, { ...options, format: "rgba" });
+    const qoi = decodeQoi(await lottie.exportFrame(input, { ...options, format: "qoi" }));
+    assert.deepStrictEqual([qoi.width, qoi.height], [width, height]);
+    assert.ok(qoi.pixels.equals(rgba), `${width}x${height}`);
+  }
+});
+
+test("default PNGs are compressed, and quality 100 stores them", () => {
+  const options = { frame: 30, width: 256, height: 256 };
+  const png = lottie.exportFrameSync(input, options);
+  assert.ok(png.equals(lottie.exportFrameSync(input, { ...options, compressionLevel: 1 })));
+
+  const stored = lottie.exportFrameSync(input, { ...options, quality: 100 });
+  assert.ok(stored.equals(lottie.exportFrameSync(input, { ...options, compressionLevel: 0 })));
+  assert.ok(readPng(stored).idat.length > 256 * (256 * 4 + 1));
+  assert.ok(png.length * 4 < stored.length, `${png.length} bytes by default, ${stored.length} stored`);
+});
@@ -0,0 +1,55 @@
+// `{ path }` inputs: a mapped file renders exactly like the same bytes in a
+// Buffer, in every kind of call, and a file that can't be read fails the call.
+//
+//   node --test test/
+
+"use strict";
+
+const assert = require("node:assert");
+const fs = require("node:fs");
+const os = require("node:os");
+const path = require("node:path");
+const { test, after } = require("node:test");
+const zlib = require("node:zlib");
+const lottie = require("..");
+
+const corpus = path.join(__dirname, "..", "bench", "corpus");
+const file = path.join(corpus, "layers.json");
+const json = fs.readFileSync(file);
+const directory = fs.mkdtempSync(path.join(os.tmpdir(), "lottie-frame-"));
+after(() => fs.rmSync(directory, { recursive: true }));
+
+test("files render like their bytes in a Buffer", async () => {
+  const tgs = path.join(directory, "layers.tgs");
+  fs.writeFileSync(tgs, zlib.gzipSync(json));
+  const options = { frame: 21, width: 72, height: 72, format: "rgba" };
+  const expected = lottie.exportFrameSync(json, options);
+
+  for (const input of [{ path: file }, { path: tgs }]) {
+    assert.ok(lottie.exportFrameSync(input, options).equals(expected), input.path);
+    assert.ok((await lottie.exportFrame(input, options)).equals(expected), input.path);
+    assert.ok(lottie.loadAnimationSync(input).renderFrameSync(options).equals(expected), input.path);
+    assert.ok((await lottie.loadAnimation(input)).renderFrameSync(options).equals(expected), input.path);
+  }
+
+  const frames = await lottie.exportFrames({ path: file }, { frames: [3, 21, 40], width: 72, height: 72, format: "rgba" });
+  assert.ok(frames[1].equals(expected));
+  const streamed = [];
+  for await (const { data } of lottie.streamFrames({ path: file }, { frames: [3, 21, 40], width: 72, height: 72, format: "rgba" })) {
+    streamed.push(data);
+  }
+  streamed.forEach((data, i) => assert.ok(data.equals(frames[i]), `streamed frame ${i}`));
+  assert.deepStrictEqual(await lottie.probe({ path: file }), await lottie.probe(json));
+});
+
+test("missing, empty and non-regular files fail the call", async () => {
+  const missing = path.join(directory, "missing.json");
+  const empty = path.join(directory, "empty.json");
+  fs.writeFileSync(empty, "");
+  const options = { width: 16, height: 16 };
+
+  assert.throws(() => lottie.exportFrameSync({ path: missing }, options), /Failed to open animation file/);
+  await assert.rejects(lottie.exportFrame({ path: missing }, options), /Failed to open animation file/);
+  await assert.rejects(lottie.loadAnimation({ path: directory }), /Failed to open animation file|not a regular file/);
+  assert.throws(() => lottie.exportFrameSync({ path: empty }, options), /Failed to load Lottie animation/);
+});
@@ -0,0 +1,86 @@
+// The rendered frame cache: hits are copies unless a shared view is asked for,
+// and callers waiting on an identical render can still be aborted.
+//
+//   node --test test/
+
+"use strict";
+
+const assert = require("node:assert");
+const fs = require("node:fs");
+const path = require("node:path");
+const { test } = require("node:test");
+const lottie = require("..");
+
+const corpus = path.join(__dirname, "..", "bench", "corpus");
+const input = fs.readFileSync(path.join(corpus, "shapes.json"));
+
+async function withFrameCache(fn) {
+  lottie.configureFrameCache({ maxBytes: 256 << 20 });
+  try {
+    return await fn();
+  } finally {
+    lottie.configureFrameCache({ maxBytes: 0 });
+  }
+}
+
+test("hits can be modified without touching the cache", () =>
+  withFrameCache(() => {
+    const options = { frame: 3, width: 64, height: 64, format: "rgba" };
+    const before = lottie.getFrameCacheStats();
+    const first = lottie.exportFrameSync(input, options);
+    const expected = Buffer.from(first);
+    first.fill(0);
+
+    const copy = lottie.exportFrameSync(input, options);
+    assert.ok(copy.equals(expected));
+    copy.fill(0);
+
+    return lottie.exportFrame(input, options).then((result) => {
+      assert.ok(result.equals(expected));
+      result.fill(0);
+      assert.ok(lottie.exportFrameSync(input, options).equals(expected));
+      assert.strictEqual(lottie.getFrameCacheStats().hits - before.hits, 3);
+    });
+  }));
+
+test("shareCached hits are views of one cached frame", () =>
+  withFrameCache(async () => {
+    const options = { frame: 4, width: 64, height: 64, format: "rgba", shareCached: true };
+    const first = lottie.exportFrameSync(input, options);
+    const second = await lottie.exportFrame(input, options);
+    assert.ok(second.equals(first));
+
+    // Both alias the cache entry, so a write shows through every view.
+    const value = first[0];
+    first[0] = value ^ 0xff;
+    assert.strictEqual(second[0], value ^ 0xff);
+    first[0] = value;
+    assert.ok(lottie.exportFrameSync(input, { ...options, shareCached: false }).equals(second));
+  }));
+
+// The second call coalesces onto the first one's render and would otherwise
+// hold its pool thread until that render is done.
+test("aborting a call waiting on an identical render rejects right away", () =>
+  withFrameCache(async () => {
+    const concurrency = lottie.getQueueStats().concurrency;
+    lottie.setConcurrency(2);
+    try {
+      const options = { width: 4096, height: 4096, format: "rgba" };
+      const before = lottie.getFrameCacheStats();
+      const settled = [];
+      const owner = lottie.exportFrame(input, options).then(() => settled.push("owner"));
+      await new Promise((resolve) => setTimeout(resolve, 20));
+
+      const controller = new AbortController();
+      const waiter = lottie.exportFrame(input, { ...options, signal: controller.signal });
+      const rejected = assert.rejects(waiter, { name: "AbortError" }).then(() => settled.push("waiter"));
+      await new Promise((resolve) => setTimeout(resolve, 20));
+      controller.abort();
+
+      await Promise.all([owner, rejected]);
+      assert.deepStrictEqual(settled, ["waiter", "owner"]);
+      assert.strictEqual(lottie.getFrameCacheStats().coalesced - before.coalesced, 0);
+    } finally {
+      lottie.setConcurrency(concurrency);
+    }
+  }));
@@ -0,0 +1,84 @@
+// Per-call timings and process-wide stats: the stages of one call add up to
+// no more than its total, every call is counted once, and every successful
+// one lands once in each histogram of a stage it ran.
+//
+//   node --test test/
+
+"use strict";
+
+const assert = require("node:assert");
+const fs = require("node:fs");
+const path = require("node:path");
+const { test } = require("node:test");
+const lottie = require("..");
+
+const corpus = path.join(__dirname, "..", "bench", "corpus");
+const input = fs.readFileSync(path.join(corpus, "shapes.json"));
+const stages = ["queue", "parse", "render", "encode", "total"];
+
+function checkTimings(timings, { inputBytes, outputBytes, surfaceBytes }) {
+  assert.deepStrictEqual(
+    { inputBytes: timings.inputBytes, outputBytes: timings.outputBytes, surfaceBytes: timings.surfaceBytes },
+    { inputBytes, outputBytes, surfaceBytes }
+  );
+  assert.ok(timings.renderNs > 0 && timings.encodeNs > 0);
+  // The total starts once a pool thread has the call, after the queue.
+  const parts = timings.parseNs + timings.renderNs + timings.encodeNs;
+  assert.ok(parts <= timings.totalNs, `stages add up to ${parts} ns of ${timings.totalNs} ns`);
+}
+
+test("timings describe the call they are attached to", async () => {
+  const options = { frame: 9, width: 120, height: 90, timings: true };
+  const sync = lottie.exportFrameSync(input, options);
+  checkTimings(sync.timings, { inputBytes: input.length, outputBytes: sync.length, surfaceBytes: 120 * 90 * 4 });
+  assert.strictEqual(sync.timings.queueNs, 0);
+  assert.ok(sync.timings.parseNs > 0);
+
+  const async = await lottie.exportFrame(input, options);
+  checkTimings(async.timings, { inputBytes: input.length, outputBytes: async.length, surfaceBytes: 120 * 90 * 4 });
+
+  const animation = lottie.loadAnimationSync(input);
+  const target = Buffer.alloc(120 * 90 * 4);
+  assert.strictEqual(await animation.renderFrame({ ...options, format: "rgba", target }), target);
+  checkTimings(target.timings, { inputBytes: 0, outputBytes: target.length, surfaceBytes: 120 * 90 * 4 });
+  assert.strictEqual(target.timings.parseNs, 0);
+
+  assert.strictEqual(lottie.exportFrameSync(input, { ...options, timings: false }).timings, undefined);
+});
+
+test("stats count every call once, and histograms only successful ones", async () => {
+  const before = lottie.getStats();
+  const outputs = [];
+  for (let i = 0; i < 5; i++) outputs.push(lottie.exportFrameSync(input, { frame: i, width: 32, height: 32 }));
+  outputs.push(await lottie.exportFrame(input, { frame: 5, width: 32, height: 32 }));
+  assert.throws(() => lottie.exportFrameSync(Buffer.alloc(0), { width: 32, height: 32 }));
+  const after = lottie.getStats();
+
+  assert.strictEqual(after.calls - before.calls, 7);
+  assert.strictEqual(after.failures - before.failures, 1);
+  assert.strictEqual(after.inFlight, 0);
+  assert.strictEqual(after.inputBytes - before.inputBytes, 6 * input.length);
+  assert.strictEqual(after.outputBytes - before.outputBytes, outputs.reduce((sum, png) => sum + png.length, 0));
+  assert.strictEqual(after.stages.render.count - before.stages.render.count, 6);
+  assert.strictEqual(after.stages.total.count - before.stages.total.count, 6);
+  // Synchronous calls have no queue stage.
+  assert.strictEqual(after.stages.queue.count - before.stages.queue.count, 1);
+});
+
+test("histograms are consistent and bound the latencies they saw", async () => {
+  const slow = await lottie.exportFrame(input, { width: 1024, height: 1024, timings: true });
+  const stats = lottie.getStats();
+  for (const stage of stages) {
+    const { count, meanNs, p50Ns, p90Ns, p99Ns, maxNs, buckets } = stats.stages[stage];
+    assert.ok(count > 0, stage);
+    assert.ok(p50Ns <= p90Ns && p90Ns <= p99Ns && p99Ns <= maxNs * 1.25, `${stage} quantiles are ordered`);
+    assert.ok(meanNs <= maxNs, stage);
+    assert.strictEqual(buckets.reduce((sum, bucket) => sum + bucket.count, 0), count, `${stage} buckets`);
+    buckets.forEach((bucket, i) => {
+      assert.ok(bucket.count > 0);
+      if (i) assert.ok(bucket.upperNs > buckets[i - 1].upperNs, `${stage} buckets ascend`);
+    });
+  }
+  assert.ok(stats.stages.total.maxNs >= slow.timings.totalNs * 0.75);
+  assert.ok(stats.stages.render.buckets.at(-1).upperNs >= slow.timings.renderNs);
+});
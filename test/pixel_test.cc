@@ -0,0 +1,132 @@
+// Checks every pixel kernel this CPU can run against the scalar reference,
+// byte for byte: every (channel, alpha) pair, in RGBA and BGRA order, with
+// unaligned heads and tails and in place.
+//
+//   npm run test:native
+
+#include "pixel.h"
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#define lp_COLOR_BYTES 4
+// Longer than two AVX2 blocks, so every tail length is covered after a vector loop.
+#define li_MAX_TAIL_COUNT 40
+#define li_MAX_MISALIGNMENT 7
+
+typedef void (*Converter)(const uint32_t* src, uint8_t* dst, size_t count);
+
+static int failures = 0;
+
+// Each alpha paired with every channel value, including the ones above alpha
+// that premultiplied data never holds but the kernels must still clamp alike.
+// Red takes the value as is and green and blue mix it up, so every channel
+// sees every pair across the image.
+static std::vector<uint32_t> every_channel_alpha_pair() {
+    std::vector<uint32_t> pixels;
+    pixels.reserve(256 * 256);
+    for (uint32_t a = 0; a < 256; a++) {
+        for (uint32_t c = 0; c < 256; c++) {
+            uint32_t g = (c * 167 + 13) & 0xFF;
+            uint32_t b = 255 - c;
+            pixels.push_back((a << 24) | (c << 16) | (g << 8) | b);
+        }
+    }
+    return pixels;
+}
+
+static void expect_same(const char* kernel, const char* order, const char* what, const uint8_t* expected,
+                        const uint8_t* actual, size_t count) {
+    for (size_t i = 0; i < count * lp_COLOR_BYTES; i++) {
+        if (expected[i] != actual[i]) {
+            fprintf(stderr, "%s %s %s: pixel %zu byte %zu is %u, expected %u\n", kernel, order, what, i / lp_COLOR_BYTES,
+                    i % lp_COLOR_BYTES, actual[i], expected[i]);
+            failures++;
+            return;
+        }
+    }
+}
+
+static void check_converter(const char* kernel, const char* order, Converter convert, Converter reference) {
+    std::vector<uint32_t> pixels = every_channel_alpha_pair();
+    size_t count = pixels.size();
+    std::vector<uint8_t> expected(count * lp_COLOR_BYTES);
+    std::vector<uint8_t> actual(count * lp_COLOR_BYTES);
+    reference(pixels.data(), expected.data(), count);
+
+    convert(pixels.data(), actual.data(), count);
+    expect_same(kernel, order, "all pairs", expected.data(), actual.data(), count);
+
+    // In place, as the raw output formats convert the render surface itself.
+    std::vector<uint32_t> in_place(pixels);
+    convert(in_place.data(), reinterpret_cast<uint8_t*>(in_place.data()), count);
+    expect_same(kernel, order, "in place", expected.data(), reinterpret_cast<const uint8_t*>(in_place.data()), count);
+
+    // Every short length from every misaligned start, so the vector loops'
+    // unaligned loads and stores and the scalar tails all run.
+    std::vector<uint32_t> src(li_MAX_MISALIGNMENT + li_MAX_TAIL_COUNT);
+    std::vector<uint8_t> dst((li_MAX_MISALIGNMENT + li_MAX_TAIL_COUNT) * lp_COLOR_BYTES + li_MAX_MISALIGNMENT);
+    for (size_t offset = 0; offset <= li_MAX_MISALIGNMENT; offset++) {
+        for (size_t length = 0; length + offset <= li_MAX_MISALIGNMENT + li_MAX_TAIL_COUNT; length++) {
+            // A window of the pairs that starts somewhere new for every case.
+            size_t start = (offset * 7919 + length * 104729) % (count - length);
+            memcpy(src.data() + offset, pixels.data() + start, length * sizeof(uint32_t));
+            memset(dst.data(), 0xA5, dst.size());
+            convert(src.data() + offset, dst.data() + offset, length);
+
+            char what[64];
+            snprintf(what, sizeof(what), "offset %zu length %zu", offset, length);
+            expect_same(kernel, order, what, expected.data() + start * lp_COLOR_BYTES, dst.data() + offset, length);
+            for (size_t i = 0; i < offset; i++) {
+                if (dst[i] != 0xA5) {
+                    fprintf(stderr, "%s %s %s: wrote before the output\n", kernel, order, what);
+                    failures++;
+                    break;
+                }
+            }
+            size_t end = offset + length * lp_COLOR_BYTES;
+            for (size_t i = end; i < dst.size(); i++) {
+                if (dst[i] != 0xA5) {
+                    fprintf(stderr, "%s %s %s: wrote past the output\n", kernel, order, what);
+                    failures++;
+                    break;
+                }
+            }
+        }
+    }
+}
+
+int main() {
+    std::vector<PixelKernel> kernels = supported_pixel_kernels();
+    const PixelKernel& scalar = kernels[0];
+    for (const PixelKernel& kernel : kernels) {
+        printf("checking %s\n", kernel.name);
+        check_converter(kernel.name, "rgba", kernel.to_rgba, scalar.to_rgba);
+        check_converter(kernel.name, "bgra", kernel.to_bgra, scalar.to_bgra);
+    }
+
+    // The scalar reference itself against the formula in pixel.h.
+    std::vector<uint32_t> pixels = every_channel_alpha_pair();
+    std::vector<uint8_t> rgba(pixels.size() * lp_COLOR_BYTES);
+    scalar.to_rgba(pixels.data(), rgba.data(), pixels.size());
+    for (size_t i = 0; i < pixels.size() && failures < 10; i++) {
+        uint32_t a = pixels[i] >> 24;
+        for (int channel = 0; channel < 3; channel++) {
+            uint32_t c = (pixels[i] >> (16 - channel * 8)) & 0xFF;
+            uint32_t expected = a == 0 ? 0 : (c * 255 + a / 2) / a;
+            if (expected > 255) expected = 255;
+            if (rgba[i * lp_COLOR_BYTES + channel] != expected || rgba[i * lp_COLOR_BYTES + 3] != a) {
+                fprintf(stderr, "scalar: pixel %08x channel %d is %u, expected %u\n", pixels[i], channel,
+                        rgba[i * lp_COLOR_BYTES + channel], expected);
+                failures++;
+            }
+        }
+    }
+
+    if (failures) {
+        fprintf(stderr, "%d failure(s)\n", failures);
+        return 1;
+    }
+    printf("ok: %zu kernel(s), runtime pick %s\n", kernels.size(), pixel_kernel_name());
+    return 0;
+}
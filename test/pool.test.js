@@ -0,0 +1,131 @@
+// Fan-out and streaming on the worker pool: multi-threaded exports borrow pool
+// threads instead of starting their own, and streams stay within their window,
+// hold no thread while the consumer is behind and stop when it leaves.
+//
+//   node --test test/
+
+"use strict";
+
+const assert = require("node:assert");
+const fs = require("node:fs");
+const path = require("node:path");
+const { test } = require("node:test");
+const lottie = require("..");
+
+const corpus = path.join(__dirname, "..", "bench", "corpus");
+const input = fs.readFileSync(path.join(corpus, "shapes.json"));
+
+function threadCount() {
+  return fs.readdirSync("/proc/self/task").length;
+}
+
+async function withConcurrency(concurrency, fn) {
+  const previous = lottie.getQueueStats().concurrency;
+  lottie.setConcurrency(concurrency);
+  try {
+    return await fn();
+  } finally {
+    lottie.setConcurrency(previous);
+  }
+}
+
+test("batch fan-out stays within the pool", { skip: process.platform !== "linux" }, () =>
+  withConcurrency(3, async () => {
+    const options = { frames: { start: 0, end: 40 }, width: 128, height: 128, dedupe: false };
+    const expected = await lottie.exportFrames(input, { ...options, concurrency: 1 });
+    // Starts the pool threads before the baseline is taken.
+    await lottie.exportFrame(input, { width: 8, height: 8 });
+
+    const baseline = threadCount();
+    let maxThreads = baseline;
+    let maxRunning = 0;
+    const sampler = setInterval(() => {
+      maxThreads = Math.max(maxThreads, threadCount());
+      maxRunning = Math.max(maxRunning, lottie.getQueueStats().running);
+    }, 1);
+    const frames = await lottie.exportFrames(input, { ...options, concurrency: 8, compressionThreads: 4 });
+    clearInterval(sampler);
+
+    assert.strictEqual(frames.length, expected.length);
+    for (let i = 0; i < frames.length; i++) {
+      assert.ok(frames[i].equals(expected[i]), `frame ${i} differs`);
+    }
+    assert.strictEqual(maxThreads, baseline);
+    assert.ok(maxRunning <= 3, `running peaked at ${maxRunning}`);
+  }));
+
+test("a stalled stream holds no pool thread", { skip: process.platform !== "linux" }, () =>
+  withConcurrency(1, async () => {
+    await lottie.exportFrame(input, { width: 8, height: 8 });
+    const baseline = threadCount();
+
+    const streams = [];
+    for (let i = 0; i < 4; i++) {
+      const stream = lottie.streamFrames(input, { width: 64, height: 64, window: 2 });
+      await stream.next();
+      streams.push(stream);
+    }
+    assert.strictEqual(threadCount(), baseline);
+
+    // Every stream is waiting on its consumer, so the single pool thread is
+    // free for other work.
+    await lottie.exportFrame(input, { width: 32, height: 32 });
+    assert.strictEqual(lottie.getQueueStats().running, 0);
+
+    for (const stream of streams) await stream.return();
+  }));
+
+test("streamed frames match single exports", () =>
+  withConcurrency(2, async () => {
+    let count = 0;
+    for await (const { frame, data } of lottie.streamFrames(input, { width: 48, height: 48, window: 1, dedupe: false })) {
+      assert.ok(data.equals(lottie.exportFrameSync(input, { frame, width: 48, height: 48 })), `frame ${frame} differs`);
+      count++;
+    }
+    assert.strictEqual(count, lottie.loadAnimationSync(input).totalFrames);
+  }));
+
+// The producer runs exactly `window` frames ahead: those arrive at once, and
+// the next one is only rendered once the consumer has taken the first of them.
+test("streams render up to their window ahead of the consumer", () =>
+  withConcurrency(2, async () => {
+    const options = { width: 1024, height: 1024, format: "rgba", dedupe: false };
+    let start = process.hrtime.bigint();
+    await lottie.exportFrame(input, { ...options, frame: 5 });
+    const renderMs = Number(process.hrtime.bigint() - start) / 1e6;
+
+    const stream = lottie.streamFrames(input, { ...options, window: 3 });
+    await stream.next();
+    await new Promise((resolve) => setTimeout(resolve, renderMs * 8));
+
+    start = process.hrtime.bigint();
+    const ahead = [];
+    for (let i = 0; i < 3; i++) ahead.push((await stream.next()).value.frame);
+    const aheadMs = Number(process.hrtime.bigint() - start) / 1e6;
+    start = process.hrtime.bigint();
+    const next = (await stream.next()).value.frame;
+    const nextMs = Number(process.hrtime.bigint() - start) / 1e6;
+    await stream.return();
+
+    assert.deepStrictEqual([...ahead, next], [1, 2, 3, 4]);
+    assert.ok(aheadMs < renderMs / 2, `the 3 frames ahead took ${aheadMs.toFixed(0)} ms, a render ${renderMs.toFixed(0)} ms`);
+    assert.ok(nextMs > renderMs / 4, `frame 4 took ${nextMs.toFixed(0)} ms, a render ${renderMs.toFixed(0)} ms`);
+  }));
+
+test("leaving a stream early stops its producer", () =>
+  withConcurrency(1, async () => {
+    const options = { width: 1024, height: 1024, format: "rgba", dedupe: false, window: 64 };
+    for await (const { frame } of lottie.streamFrames(input, options)) {
+      if (frame === 1) break;
+    }
+    // At most the frame being rendered when the stream was cancelled finishes.
+    const start = process.hrtime.bigint();
+    while (lottie.getQueueStats().running > 0) {
+      await new Promise((resolve) => setTimeout(resolve, 5));
+    }
+    const drainMs = Number(process.hrtime.bigint() - start) / 1e6;
+    const renderStart = process.hrtime.bigint();
+    await lottie.exportFrame(input, { ...options, frame: 30 });
+    const renderMs = Number(process.hrtime.bigint() - renderStart) / 1e6;
+    assert.ok(drainMs < renderMs * 3, `the pool took ${drainMs.toFixed(0)} ms to drain, a render ${renderMs.toFixed(0)} ms`);
+  }));
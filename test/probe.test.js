@@ -0,0 +1,93 @@
+// Probing: metadata matches a loaded animation, complexity is counted from the
+// JSON, estimates follow their documented formulas, and nothing is rendered.
+//
+//   node --test test/
+
+"use strict";
+
+const assert = require("node:assert");
+const { test } = require("node:test");
+const zlib = require("node:zlib");
+const lottie = require("..");
+
+const transform = { o: { a: 0, k: 100 }, r: { a: 0, k: 0 }, p: { a: 0, k: [0, 0] }, a: { a: 0, k: [0, 0] }, s: { a: 0, k: [100, 100] } };
+const rect = { ty: "rc", p: { a: 0, k: [0, 0] }, s: { a: 0, k: [20, 20] }, r: { a: 0, k: 0 } };
+const fill = { ty: "fl", c: { a: 0, k: [1, 0, 0, 1] }, o: { a: 0, k: 100 } };
+const mask = { mode: "a", inv: false, o: { a: 0, k: 100 }, pt: { a: 0, k: { c: true, v: [[0, 0], [50, 0], [50, 50]], i: [[0, 0], [0, 0], [0, 0]], o: [[0, 0], [0, 0], [0, 0]] } } };
+
+// Top level: two instances of one precomp and a shape layer with a group and
+// two masks. The precomp holds two shape layers; an image asset is unused.
+const input = Buffer.from(JSON.stringify({
+  v: "5.7.0", fr: 25, ip: 0, op: 50, w: 200, h: 100,
+  assets: [
+    { id: "comp", layers: [
+      { ty: 4, ind: 1, nm: "Inner rect", ip: 0, op: 50, st: 0, ks: transform, shapes: [rect, fill] },
+      { ty: 4, ind: 2, nm: "Inner fill", ip: 0, op: 50, st: 0, ks: transform, shapes: [fill] },
+    ] },
+    { id: "image", w: 10, h: 10, u: "images/", p: "image.png" },
+  ],
+  layers: [
+    { ty: 0, ind: 1, nm: "Precomp A", refId: "comp", ip: 0, op: 50, st: 0, w: 200, h: 100, ks: transform },
+    { ty: 0, ind: 2, nm: "Precomp B", refId: "comp", ip: 10, op: 40, st: 0, w: 200, h: 100, ks: transform },
+    { ty: 4, ind: 3, nm: "Masked", ip: 0, op: 50, st: 0, ks: transform, hasMask: true, masksProperties: [mask, mask],
+      shapes: [{ ty: "gr", it: [rect, fill, { ty: "tr", ...transform }] }] },
+  ],
+  markers: [{ cm: "intro", tm: 0, dr: 10 }],
+}));
+
+test("probes report the metadata and complexity of the animation", async () => {
+  const result = await lottie.probe(input);
+  assert.deepStrictEqual(lottie.probeSync(input), result);
+
+  const animation = lottie.loadAnimationSync(input);
+  assert.deepStrictEqual(
+    { totalFrames: result.totalFrames, frameRate: result.frameRate, duration: result.duration, size: result.size },
+    { totalFrames: animation.totalFrames, frameRate: animation.frameRate, duration: animation.duration, size: animation.size }
+  );
+  assert.deepStrictEqual(result.size, { width: 200, height: 100 });
+  assert.deepStrictEqual([result.inputBytes, result.jsonBytes], [input.length, input.length]);
+  assert.deepStrictEqual(result.markers, [{ name: "intro", startFrame: 0, endFrame: 10 }]);
+  for (const layer of result.layers) {
+    assert.strictEqual(typeof layer.name, "string");
+    assert.ok(layer.inFrame <= layer.outFrame);
+  }
+  // Precomp layers count once, however often the precomp is used.
+  assert.deepStrictEqual(result.complexity, { layers: 5, shapes: 7, masks: 2, precomps: 1, images: 1 });
+
+  const tgs = zlib.gzipSync(input);
+  const compressed = lottie.probeSync(tgs);
+  assert.deepStrictEqual([compressed.inputBytes, compressed.jsonBytes], [tgs.length, input.length]);
+  assert.deepStrictEqual(compressed.complexity, result.complexity);
+});
+
+test("estimates follow their formulas and bound a real export", () => {
+  const sizes = [{ width: 64, height: 32 }, { width: 300, height: 150 }];
+  const { estimates, inputBytes, jsonBytes, complexity } = lottie.probeSync(input, { sizes });
+  assert.strictEqual(estimates.length, 2);
+  estimates.forEach((estimate, i) => {
+    const { width, height } = sizes[i];
+    assert.deepStrictEqual([estimate.width, estimate.height], [width, height]);
+    assert.strictEqual(estimate.surfaceBytes, width * height * 4);
+    assert.strictEqual(estimate.peakBytes, inputBytes + 2 * jsonBytes + estimate.surfaceBytes + estimate.pngBytes);
+    const cost = ((width * height) / 1e6) * (complexity.layers + complexity.shapes + complexity.masks);
+    assert.ok(Math.abs(estimate.renderCost - cost) < 1e-9);
+    // quality 100 stores the image, the worst case.
+    assert.ok(lottie.exportFrameSync(input, { width, height, quality: 100 }).length <= estimate.pngBytes);
+  });
+
+  const intrinsic = lottie.probeSync(input).estimates;
+  assert.deepStrictEqual(intrinsic.map(({ width, height }) => ({ width, height })), [{ width: 200, height: 100 }]);
+});
+
+test("probing the largest size allocates no surface", () => {
+  const before = process.memoryUsage().rss;
+  const [estimate] = lottie.probeSync(input, { sizes: [{ width: 16384, height: 16384 }] }).estimates;
+  assert.strictEqual(estimate.surfaceBytes, 16384 * 16384 * 4);
+  const grown = (process.memoryUsage().rss - before) / (1 << 20);
+  assert.ok(grown < 64, `RSS grew by ${grown.toFixed(0)} MB`);
+});
+
+test("inputs that don't parse fail the probe", async () => {
+  assert.throws(() => lottie.probeSync(Buffer.alloc(0)));
+  await assert.rejects(lottie.probe(Buffer.from([0x1f, 0x8b, 8, 0, 0, 0, 0, 0, 0, 3, 1, 2, 3])));
+});
@@ -0,0 +1,69 @@
+// Raw pixel output: the three formats hold the same pixels in their own
+// layout, and frames rendered into a target land in its memory, at the
+// view's offset, without a copy.
+//
+//   node --test test/
+
+"use strict";
+
+const assert = require("node:assert");
+const fs = require("node:fs");
+const path = require("node:path");
+const { test } = require("node:test");
+const lottie = require("..");
+
+const corpus = path.join(__dirname, "..", "bench", "corpus");
+const input = fs.readFileSync(path.join(corpus, "layers.json"));
+const options = { frame: 17, width: 96, height: 80 };
+const bytes = 96 * 80 * 4;
+
+test("rgba, bgra and argb-premul hold the same pixels", () => {
+  const rgba = lottie.exportFrameSync(input, { ...options, format: "rgba" });
+  const bgra = lottie.exportFrameSync(input, { ...options, format: "bgra" });
+  const premul = lottie.exportFrameSync(input, { ...options, format: "argb-premul" });
+  assert.strictEqual(rgba.length, bytes);
+
+  let translucent = 0;
+  for (let i = 0; i < bytes; i += 4) {
+    assert.deepStrictEqual([bgra[i + 2], bgra[i + 1], bgra[i], bgra[i + 3]], [...rgba.subarray(i, i + 4)]);
+
+    // argb-premul is the renderer's native word: B, G, R, A on little endian.
+    const word = premul.readUInt32LE(i);
+    const alpha = word >>> 24;
+    assert.strictEqual(alpha, rgba[i + 3]);
+    const channels = [(word >>> 16) & 0xff, (word >>> 8) & 0xff, word & 0xff];
+    channels.forEach((value, c) => {
+      assert.ok(value <= alpha, `pixel ${i / 4} is premultiplied`);
+      if (alpha) assert.ok(Math.abs(Math.round((value * 255) / alpha) - rgba[i + c]) <= 1, `pixel ${i / 4}`);
+    });
+    if (alpha > 0 && alpha < 255) translucent++;
+  }
+  assert.ok(translucent > 0, "the frame has anti-aliased edges");
+});
+
+test("targets receive the frame at their own offset", async () => {
+  const expected = lottie.exportFrameSync(input, { ...options, format: "rgba" });
+
+  const shared = new SharedArrayBuffer(bytes);
+  assert.strictEqual(await lottie.exportFrame(input, { ...options, format: "rgba", target: shared }), shared);
+  assert.ok(Buffer.from(shared).equals(expected));
+
+  const backing = new ArrayBuffer(bytes + 16);
+  const view = new Uint8Array(backing, 8, bytes);
+  new Uint8Array(backing).fill(0xaa);
+  assert.strictEqual(lottie.exportFrameSync(input, { ...options, format: "rgba", target: view }), view);
+  assert.ok(Buffer.from(view).equals(expected));
+  const all = new Uint8Array(backing);
+  assert.ok(all.subarray(0, 8).every((value) => value === 0xaa) && all.subarray(8 + bytes).every((value) => value === 0xaa));
+
+  const animation = lottie.loadAnimationSync(input);
+  const target = Buffer.alloc(bytes);
+  assert.strictEqual(await animation.renderFrame({ ...options, format: "rgba", target }), target);
+  assert.ok(target.equals(expected));
+});
+
+test("targets that can't take the frame are rejected", () => {
+  assert.throws(() => lottie.exportFrameSync(input, { ...options, format: "rgba", target: Buffer.alloc(bytes - 1) }), RangeError);
+  assert.throws(() => lottie.exportFrameSync(input, { ...options, format: "png", target: Buffer.alloc(bytes) }), RangeError);
+  assert.throws(() => lottie.exportFrameSync(input, { ...options, format: "rgba", target: [] }), TypeError);
+});
@@ -0,0 +1,57 @@
+// Sprite sheets: every cell holds the same pixels as a single export of its
+// frame, at the position the map gives, with transparent padding in between.
+//
+//   node --test test/
+
+"use strict";
+
+const assert = require("node:assert");
+const fs = require("node:fs");
+const path = require("node:path");
+const { test } = require("node:test");
+const lottie = require("..");
+
+const corpus = path.join(__dirname, "..", "bench", "corpus");
+const input = fs.readFileSync(path.join(corpus, "shapes.json"));
+
+test("cells match single exports and the map", async () => {
+  const options = { cellWidth: 40, cellHeight: 30, padding: 3, frameStep: 7, format: "rgba", concurrency: 3 };
+  const { image, map } = await lottie.exportSpriteSheet(input, options);
+
+  // Frames 0, 7, ... 56 on a grid of ceil(sqrt(9)) columns.
+  const frames = Array.from({ length: 9 }, (_, i) => i * 7);
+  assert.deepStrictEqual(
+    { width: map.width, height: map.height, columns: map.columns, rows: map.rows, frameRate: map.frameRate },
+    { width: 3 * 40 + 2 * 3, height: 3 * 30 + 2 * 3, columns: 3, rows: 3, frameRate: 30 }
+  );
+  assert.strictEqual(image.length, map.width * map.height * 4);
+  assert.deepStrictEqual(JSON.parse(JSON.stringify(map)), map);
+
+  const covered = new Uint8Array(map.width * map.height);
+  map.frames.forEach((cell, i) => {
+    assert.deepStrictEqual(cell, { frame: frames[i], x: (i % 3) * 43, y: Math.floor(i / 3) * 33, width: 40, height: 30 });
+    const expected = lottie.exportFrameSync(input, { frame: cell.frame, width: 40, height: 30, format: "rgba" });
+    for (let row = 0; row < 30; row++) {
+      const start = ((cell.y + row) * map.width + cell.x) * 4;
+      assert.ok(image.subarray(start, start + 40 * 4).equals(expected.subarray(row * 160, (row + 1) * 160)), `frame ${cell.frame}, row ${row}`);
+      covered.fill(1, (cell.y + row) * map.width + cell.x, (cell.y + row) * map.width + cell.x + 40);
+    }
+  });
+  covered.forEach((inCell, pixel) => {
+    if (!inCell) assert.strictEqual(image.readUInt32LE(pixel * 4), 0, `padding pixel ${pixel}`);
+  });
+});
+
+test("an explicit frame list keeps its order, and columns wrap it", async () => {
+  const frames = [50, 3, 3, 20, 9];
+  const { image, map } = await lottie.exportSpriteSheet(input, { frames, columns: 2, cellWidth: 16, cellHeight: 16, format: "png" });
+  assert.deepStrictEqual(map.frames.map((cell) => cell.frame), frames);
+  assert.deepStrictEqual([map.columns, map.rows, map.width, map.height], [2, 3, 32, 48]);
+  assert.deepStrictEqual(map.frames.map((cell) => [cell.x, cell.y]), [[0, 0], [16, 0], [0, 16], [16, 16], [0, 32]]);
+  assert.strictEqual(image.readUInt32BE(16), 32);
+  assert.strictEqual(image.readUInt32BE(20), 48);
+});
+
+test("sheets over 4096 pixels are rejected", async () => {
+  await assert.rejects(lottie.exportSpriteSheet(input, { cellWidth: 1000, cellHeight: 10, columns: 5 }));
+});
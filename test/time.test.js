@@ -0,0 +1,93 @@
+// Addressing frames by time: times, progress and output frame rates resolve to
+// the nearest source frame with rlottie's rounding, and repeats are rendered
+// once.
+//
+//   node --test test/
+
+"use strict";
+
+const assert = require("node:assert");
+const fs = require("node:fs");
+const path = require("node:path");
+const { test } = require("node:test");
+const lottie = require("..");
+
+const corpus = path.join(__dirname, "..", "bench", "corpus");
+const input = fs.readFileSync(path.join(corpus, "shapes.json"));
+// 60 frames at 30 fps.
+const totalFrames = 60;
+const frameRate = 30;
+const size = { width: 40, height: 40, format: "rgba" };
+
+// The rounding of rlottie's frameAtPos, clamped to the last frame.
+function frameAtTime(timeMs) {
+  const progress = ((timeMs / 1000) * frameRate) / (totalFrames - 1);
+  return progress >= 1 ? totalFrames - 1 : Math.round(progress * (totalFrames - 1));
+}
+
+function frame(number) {
+  return lottie.exportFrameSync(input, { ...size, frame: number });
+}
+
+test("time and progress select the nearest frame", async () => {
+  const animation = lottie.loadAnimationSync(input);
+  const cases = [
+    [{ time: 0 }, 0],
+    [{ time: 500 }, 15],
+    [{ time: 1016 }, 30],
+    [{ time: 1984 }, 59],
+    [{ time: 60000 }, 59],
+    [{ progress: 0.5 }, 30],
+    [{ progress: 0.25 }, 15],
+    [{ progress: 1 }, 59],
+  ];
+  for (const [select, expected] of cases) {
+    const pixels = frame(expected);
+    assert.ok(lottie.exportFrameSync(input, { ...size, ...select }).equals(pixels), JSON.stringify(select));
+    assert.ok((await lottie.exportFrame(input, { ...size, ...select })).equals(pixels), JSON.stringify(select));
+    assert.ok(animation.renderFrameSync({ ...size, ...select }).equals(pixels), JSON.stringify(select));
+  }
+  assert.throws(() => lottie.exportFrameSync(input, { ...size, frame: 3, time: 100 }));
+});
+
+test("fps resamples the whole animation", async () => {
+  for (const fps of [24, 60]) {
+    const result = await lottie.exportFrames(input, { ...size, fps });
+    const expected = Array.from({ length: Math.ceil(2 * fps) }, (_, i) => frameAtTime((i * 1000) / fps));
+    assert.deepStrictEqual(result.frames, expected, `${fps} fps`);
+    result.forEach((data, i) => assert.ok(data.equals(frame(expected[i])), `${fps} fps, output frame ${i}`));
+
+    // Upsampling repeats frames, and each repeat shares its first render.
+    // Dedupe compares pixels, so distinct frames that render alike may be
+    // paired as well.
+    const paired = new Map(result.duplicates);
+    for (const [index, source] of result.duplicates) {
+      assert.strictEqual(result[index], result[source]);
+      assert.ok(result[index].equals(frame(result.frames[index])));
+    }
+    expected.forEach((number, i) => {
+      if (expected.indexOf(number) !== i) assert.ok(paired.has(i), `${fps} fps, output frame ${i} repeats frame ${number}`);
+    });
+  }
+});
+
+test("times select frames in order and clamp past the end", async () => {
+  const times = [1999, 0, 1000, 5000, 16.7];
+  const result = await lottie.exportFrames(input, { ...size, times, dedupe: false });
+  assert.deepStrictEqual(result.frames, [59, 0, 30, 59, 1]);
+  result.forEach((data, i) => assert.ok(data.equals(frame(result.frames[i])), `time ${times[i]}`));
+});
+
+test("streamed resamples mark repeated frames as duplicates", async () => {
+  const streamed = [];
+  for await (const { frame: number, data, duplicate } of lottie.streamFrames(input, { ...size, fps: 60 })) {
+    streamed.push({ number, data, duplicate });
+  }
+  assert.strictEqual(streamed.length, 120);
+  streamed.forEach(({ number, data, duplicate }, i) => {
+    assert.strictEqual(number, frameAtTime((i * 1000) / 60));
+    assert.ok(data.equals(frame(number)), `output frame ${i}`);
+    if (i > 0 && streamed[i - 1].number === number) assert.ok(duplicate, `output frame ${i} repeats frame ${number}`);
+    if (duplicate) assert.strictEqual(data, streamed[i - 1].data);
+  });
+});
@@ -0,0 +1,44 @@
+// Viewports and tiles: every tile is a wrapper composition of its own, moved
+// by the tile's offset, and together they must match a plain render.
+//
+//   node --test test/
+
+"use strict";
+
+const assert = require("node:assert");
+const fs = require("node:fs");
+const path = require("node:path");
+const { test } = require("node:test");
+const lottie = require("..");
+
+const corpus = path.join(__dirname, "..", "bench", "corpus");
+const input = fs.readFileSync(path.join(corpus, "shapes.json"));
+
+function crop(pixels, width, x, y, cropWidth, cropHeight) {
+  const out = Buffer.alloc(cropWidth * cropHeight * 4);
+  for (let row = 0; row < cropHeight; row++) {
+    pixels.copy(out, row * cropWidth * 4, ((y + row) * width + x) * 4, ((y + row) * width + x + cropWidth) * 4);
+  }
+  return out;
+}
+
+test("tiles match an untiled render", async () => {
+  const previous = lottie.getQueueStats().concurrency;
+  lottie.setConcurrency(3);
+  try {
+    const options = { frame: 10, width: 600, height: 400, format: "rgba" };
+    const full = lottie.exportFrameSync(input, options);
+    // 64 pixel tiles leave partial tiles on the right and bottom edges.
+    assert.ok(lottie.exportFrameSync(input, { ...options, tileSize: 64 }).equals(full));
+    assert.ok((await lottie.exportFrame(input, { ...options, tileSize: 100 })).equals(full));
+  } finally {
+    lottie.setConcurrency(previous);
+  }
+});
+
+test("a tiled viewport matches the same region of a full render", () => {
+  const full = lottie.exportFrameSync(input, { frame: 10, width: 600, height: 400, format: "rgba" });
+  const viewport = { x: 150, y: 50, width: 300, height: 200 };
+  const region = lottie.exportFrameSync(input, { frame: 10, width: 600, height: 400, format: "rgba", viewport, tileSize: 64 });
+  assert.ok(region.equals(crop(full, 600, 150, 50, 300, 200)));
+});
@@ -0,0 +1,201 @@
+// Multi-threaded use: many worker_threads sharing the render pool, and workers
+// terminated with jobs still queued or running on it.
+//
+//   node --test test/
+
+"use strict";
+
+const assert = require("node:assert");
+const { execFile } = require("node:child_process");
+const fs = require("node:fs");
+const path = require("node:path");
+const { test } = require("node:test");
+const { Worker } = require("node:worker_threads");
+const lottie = require("..");
+
+const corpus = path.join(__dirname, "..", "bench", "corpus");
+
+test("16 workers render a shared animation like the main thread", async () => {
+  const script = path.join(__dirname, "..", "bench", "workers.js");
+  const stdout = await new Promise((resolve, reject) => {
+    execFile(process.execPath, [...process.execArgv, script, "--workers", "16", "--frames", "12", "--size", "64"],
+      (error, out) => (error ? reject(error) : resolve(out)));
+  });
+  const summary = JSON.parse(stdout);
+  assert.strictEqual(summary.mismatches, 0);
+  assert.strictEqual(summary.released, true);
+  assert.strictEqual(summary.reopened, false);
+});
+
+// Each worker queues large raw exports and is terminated as soon as they are
+// queued, so one is rendering and the rest are waiting. Results of jobs that
+// finish after the environment is gone, and the data of jobs that never ran,
+// must be freed: leaking them costs 16 MB a cycle.
+test("terminated workers free their jobs", async () => {
+  const concurrency = lottie.getQueueStats().concurrency;
+  lottie.setConcurrency(1);
+  const code = `
+    const { parentPort, workerData } = require("node:worker_threads");
+    const lottie = require(workerData.lottie);
+    const input = require("node:fs").readFileSync(workerData.file);
+    for (let i = 0; i < 4; i++) {
+      lottie.exportFrame(input, { frame: i, width: 2048, height: 2048, format: "rgba" }).catch(() => {});
+    }
+    lottie.exportFrames(input, { frames: [0, 1], width: 1024, height: 1024, format: "rgba" }).catch(() => {});
+    lottie.probe(input).catch(() => {});
+    parentPort.postMessage("queued");
+  `;
+  const cycle = () =>
+    new Promise((resolve) => {
+      const worker = new Worker(code, {
+        eval: true,
+        workerData: { lottie: path.join(__dirname, ".."), file: path.join(corpus, "simple.json") },
+      });
+      worker.on("error", () => {});
+      worker.once("message", () => worker.terminate());
+      worker.once("exit", resolve);
+    });
+
+  try {
+    await cycle();
+    await cycle();
+    const before = process.memoryUsage().rss;
+    for (let i = 0; i < 12; i++) await cycle();
+    // Let the pool finish whatever the last worker left running.
+    while (lottie.getQueueStats().running > 0) await new Promise((r) => setTimeout(r, 10));
+    const grown = (process.memoryUsage().rss - before) / (1024 * 1024);
+    assert.ok(grown < 64, `RSS grew by ${grown.toFixed(0)} MB over 12 terminated workers`);
+  } finally {
+    lottie.setConcurrency(concurrency);
+  }
+});
+
+// A terminated worker's threadsafe functions are finalized before their last
+// queued calls are drained, which must not read the freed contexts. This
+// runs in a child process, since getting it wrong is a crash.
+test("workers terminated mid-stream exit cleanly", async () => {
+  const script = `
+    const { Worker } = require("node:worker_threads");
+    const code = \`
+      const { parentPort, workerData } = require("node:worker_threads");
+      const lottie = require(workerData.lottie);
+      const input = require("node:fs").readFileSync(workerData.file);
+      lottie.setConcurrency(2);
+      (async () => {
+        for (let i = 0; i < 3; i++) {
+          const stream = lottie.streamFrames(input, { width: 256, height: 256, window: 3 });
+          await stream.next();
+          lottie.exportFrame(input, { width: 256, height: 256 }).catch(() => {});
+          parentPort.postMessage("streaming");
+        }
+      })();
+    \`;
+    (async () => {
+      for (let i = 0; i < 20; i++) {
+        const worker = new Worker(code, {
+          eval: true,
+          workerData: { lottie: ${JSON.stringify(path.join(__dirname, ".."))}, file: ${JSON.stringify(path.join(corpus, "shapes.json"))} },
+        });
+        await new Promise((resolve) => worker.once("message", resolve));
+        await worker.terminate();
+      }
+    })();
+  `;
+  await new Promise((resolve, reject) => {
+    execFile(process.execPath, [...process.execArgv, "-e", script], (error) => (error ? reject(error) : resolve()));
+  });
+});
+
+test("process exit doesn't wait for a render in flight", async () => {
+  const input = fs.readFileSync(path.join(corpus, "simple.json"));
+  // One job long enough that waiting for it dwarfs the noise in process
+  // start-up and exit.
+  const options = { frames: { start: 0, end: 19 }, width: 2048, height: 2048, format: "rgba", concurrency: 1, dedupe: false };
+  let start = process.hrtime.bigint();
+  await lottie.exportFrames(input, options);
+  const renderMs = Number(process.hrtime.bigint() - start) / 1e6;
+
+  const run = async (render) => {
+    const script = `
+      const lottie = require(${JSON.stringify(path.join(__dirname, ".."))});
+      const input = require("node:fs").readFileSync(${JSON.stringify(path.join(corpus, "simple.json"))});
+      if (${render}) lottie.exportFrames(input, ${JSON.stringify(options)});
+      setTimeout(() => process.exit(0), 20);
+    `;
+    const begin = process.hrtime.bigint();
+    await new Promise((resolve, reject) => {
+      execFile(process.execPath, [...process.execArgv, "-e", script], (error) => (error ? reject(error) : resolve()));
+    });
+    return Number(process.hrtime.bigint() - begin) / 1e6;
+  };
+  const idleMs = await run(false);
+  const busyMs = await run(true);
+  assert.ok(busyMs - idleMs < renderMs / 2, `exit took ${busyMs.toFixed(0)} ms, ${idleMs.toFixed(0)} ms when idle, render ${renderMs.toFixed(0)} ms`);
+});
+
+test("handles opened from one shared ID render independently", async () => {
+  const input = fs.readFileSync(path.join(corpus, "shapes.json"));
+  const original = lottie.loadAnimationSync(input);
+  const id = original.share();
+  try {
+    const first = lottie.openSharedAnimation(id);
+    const second = lottie.openSharedAnimation(id);
+    assert.strictEqual(second.share(), id);
+    assert.ok(lottie.releaseSharedAnimation(id));
+
+    const small = { frame: 7, width: 16, height: 16, format: "rgba" };
+    assert.ok(second.renderFrameSync(small).equals(original.renderFrameSync(small)));
+
+    // A render on one handle must not hold up the others: each open has a
+    // renderer of its own over the shared model.
+    const large = { frame: 3, width: 4096, height: 4096, format: "rgba" };
+    let start = process.hrtime.bigint();
+    await first.renderFrame(large);
+    const largeMs = Number(process.hrtime.bigint() - start) / 1e6;
+
+    const pending = first.renderFrame(large);
+    await new Promise((resolve) => setTimeout(resolve, 10));
+    start = process.hrtime.bigint();
+    second.renderFrameSync(small);
+    const smallMs = Number(process.hrtime.bigint() - start) / 1e6;
+    await pending;
+    assert.ok(smallMs < largeMs / 4, `a 16x16 render took ${smallMs.toFixed(0)} ms beside a ${largeMs.toFixed(0)} ms one`);
+  } finally {
+    lottie.releaseSharedAnimation(id);
+  }
+});
+
+// Terminating a worker waits for its running jobs, which read its memory, but
+// cancels them first so that the wait is only until their next check.
+test("terminating a worker stops its running jobs", async () => {
+  const concurrency = lottie.getQueueStats().concurrency;
+  lottie.setConcurrency(1);
+  const options = { frames: { start: 0, end: 19 }, width: 2048, height: 2048, format: "rgba", dedupe: false };
+  const input = fs.readFileSync(path.join(corpus, "simple.json"));
+  try {
+    let start = process.hrtime.bigint();
+    await lottie.exportFrames(input, options);
+    const renderMs = Number(process.hrtime.bigint() - start) / 1e6;
+
+    const code = `
+      const { parentPort, workerData } = require("node:worker_threads");
+      const lottie = require(workerData.lottie);
+      const input = require("node:fs").readFileSync(workerData.file);
+      lottie.exportFrames(input, workerData.options).catch(() => {});
+      const wait = () => (lottie.getQueueStats().running > 0 ? parentPort.postMessage("running") : setTimeout(wait, 1));
+      wait();
+    `;
+    const worker = new Worker(code, {
+      eval: true,
+      workerData: { lottie: path.join(__dirname, ".."), file: path.join(corpus, "simple.json"), options },
+    });
+    worker.on("error", () => {});
+    await new Promise((resolve) => worker.once("message", resolve));
+    start = process.hrtime.bigint();
+    await worker.terminate();
+    const terminateMs = Number(process.hrtime.bigint() - start) / 1e6;
+    assert.ok(terminateMs < renderMs / 2, `terminate took ${terminateMs.toFixed(0)} ms, the export ${renderMs.toFixed(0)} ms`);
+  } finally {
+    lottie.setConcurrency(concurrency);
+  }
+});